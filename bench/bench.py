@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""编译吞吐量基准测试
+
+对 gen_sysy.py 的每种 shape 生成 1、2、4 倍规模的程序，用 --time-report 编译，
+报告每秒处理的行数、各阶段耗时和峰值 RSS。规模翻倍时耗时也应大致翻倍，
+"x2" 一列给出相邻规模的耗时比，明显大于 2 说明某个阶段不是线性的。
+
+有基线文件时，同时给出与基线相比的吞吐量和内存变化。
+
+用法: bench.py [--compiler ./compiler] [--baseline bench/baseline.json]
+               [--save-baseline] [--scale N] [--repeat N] [--shape NAME]
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import gen_sysy  # noqa: E402
+
+# 每种 shape 1 倍规模时的 size，--scale 整体放大
+BASE_SIZES = {
+    "functions": 500,
+    "straight": 5000,
+    "nesting": 200,
+    "globals": 20000,
+    "arrays": 100,
+}
+FACTORS = [1, 2, 4]
+# 表格中各阶段按流水线的顺序排列
+PHASES = ["lex+parse", "typecheck", "translate", "cfg", "select", "regalloc", "emit", "write"]
+
+
+def run_compiler(compiler, source, output):
+    """编译一次，返回 (墙钟秒数, 峰值 RSS KiB, {阶段: 毫秒}, 并行运行的阶段)"""
+    start = time.perf_counter()
+    proc = subprocess.Popen([compiler, source, output, "--time-report"],
+                            stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    stderr = proc.stderr.read().decode(errors="replace")
+    proc.stderr.close()
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    wall = time.perf_counter() - start
+    if proc.returncode != 0:
+        raise RuntimeError(f"{source}: compiler exited with {proc.returncode}\n{stderr}")
+    return (wall, usage.ru_maxrss) + parse_time_report(stderr)
+
+
+def parse_time_report(text):
+    """取出 --time-report 中每个阶段汇总行的毫秒数
+    (threads) 行的阶段在多个线程上并行，数值是各线程耗时之和而不是墙钟时间"""
+    phases = {}
+    threaded = set()
+    for line in text.splitlines():
+        parts = line.split()
+        if len(parts) >= 3 and parts[1] in ("(all)", "(threads)"):
+            phases[parts[0]] = float(parts[2])
+            if parts[1] == "(threads)":
+                threaded.add(parts[0])
+    return phases, threaded
+
+
+def measure(compiler, shape, size, repeat, workdir):
+    source = os.path.join(workdir, f"{shape}_{size}.sy")
+    text = gen_sysy.generate(shape, size)
+    with open(source, "w") as f:
+        f.write(text)
+    output = os.path.join(workdir, f"{shape}_{size}.s")
+    # 取最快的一次，减少机器抖动的影响
+    best = None
+    for _ in range(repeat):
+        result = run_compiler(compiler, source, output)
+        if best is None or result[0] < best[0]:
+            best = result
+    wall, rss, phases, threaded = best
+    lines = text.count("\n")
+    return {
+        "shape": shape,
+        "size": size,
+        "lines": lines,
+        "wall_ms": wall * 1000,
+        "lines_per_sec": lines / wall,
+        "peak_rss_kib": rss,
+        "phases_ms": phases,
+        "threaded_phases": sorted(threaded),
+    }
+
+
+def percent(new, old):
+    if not old:
+        return "     -"
+    return f"{(new - old) / old * 100:+5.0f}%"
+
+
+def report(results, baseline):
+    phase_names = list(PHASES)
+    for r in results:
+        for name in r["phases_ms"]:
+            if name not in phase_names:
+                phase_names.append(name)
+
+    header = f"{'Shape':<10} {'Size':>7} {'Lines':>8} {'Wall ms':>9} {'x2':>5} {'Lines/s':>10} {'RSS MiB':>8}"
+    if baseline:
+        header += f" {'vs base':>7} {'RSS':>6}"
+    # 并行阶段的数值是线程时间，列名后加 *
+    threaded = {name for r in results for name in r.get("threaded_phases", [])}
+    header += "".join(f" {name + ('*' if name in threaded else ''):>10}" for name in phase_names)
+    print(header)
+
+    previous = {}
+    for r in results:
+        key = f"{r['shape']}/{r['size']}"
+        ratio = ""
+        if r["shape"] in previous:
+            ratio = f"{r['wall_ms'] / previous[r['shape']]:.2f}"
+        previous[r["shape"]] = r["wall_ms"]
+        row = (f"{r['shape']:<10} {r['size']:>7} {r['lines']:>8} {r['wall_ms']:>9.1f} {ratio:>5}"
+               f" {r['lines_per_sec']:>10.0f} {r['peak_rss_kib'] / 1024:>8.1f}")
+        if baseline:
+            old = baseline.get(key, {})
+            row += (f" {percent(r['lines_per_sec'], old.get('lines_per_sec'))}"
+                    f" {percent(r['peak_rss_kib'], old.get('peak_rss_kib'))}")
+        row += "".join(f" {r['phases_ms'].get(name, 0):>10.1f}" for name in phase_names)
+        print(row)
+    if threaded:
+        print("* thread time: the phase ran on several threads, summed over them")
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description="SysY compile throughput benchmark")
+    parser.add_argument("--compiler", default=os.path.join(root, "compiler"))
+    parser.add_argument("--baseline", default=os.path.join(root, "bench", "baseline.json"))
+    parser.add_argument("--save-baseline", action="store_true",
+                        help="record this run as the new baseline")
+    parser.add_argument("--scale", type=float, default=1.0, help="multiply every size")
+    parser.add_argument("--repeat", type=int, default=3, help="runs per program, the fastest counts")
+    parser.add_argument("--shape", action="append", choices=gen_sysy.SHAPES,
+                        help="only run these shapes")
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(args.baseline) and not args.save_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    results = []
+    with tempfile.TemporaryDirectory(prefix="sysy-bench-") as workdir:
+        for shape in args.shape or gen_sysy.SHAPES:
+            for factor in FACTORS:
+                size = max(1, int(BASE_SIZES[shape] * args.scale * factor))
+                results.append(measure(args.compiler, shape, size, args.repeat, workdir))
+
+    report(results, baseline)
+
+    if args.save_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump({f"{r['shape']}/{r['size']}": r for r in results}, f, indent=2)
+            f.write("\n")
+        print(f"baseline saved to {args.baseline}")
+    elif not baseline:
+        print(f"no baseline at {args.baseline}; run make bench-baseline to record one")
+
+
+if __name__ == "__main__":
+    main()
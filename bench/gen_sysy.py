@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""生成用于测编译吞吐量的 SysY 程序
+
+每种 shape 针对编译器的一个扩展方向，size 控制规模，输出大致随 size 线性增长：
+
+  functions  size 个小函数，main 依次调用
+  straight   一个有 size 条语句的直线型长函数
+  nesting    嵌套 size 层的 if/while
+  globals    有 size 个初始值的全局数组和 size / 16 个全局标量
+  arrays     size x size x 4 的全局数组和 size x 16 的局部数组，用循环读写
+
+用法: gen_sysy.py <shape> <size> [output]，不给 output 时写到标准输出
+"""
+
+import sys
+
+SHAPES = ["functions", "straight", "nesting", "globals", "arrays"]
+
+
+def gen_functions(size):
+    lines = []
+    for i in range(size):
+        lines.append(f"int f{i}(int a, int b) {{")
+        lines.append(f"  int c = a * {i % 97} + b;")
+        lines.append(f"  if (c > {i % 13}) {{")
+        lines.append("    c = c - b;")
+        lines.append("  }")
+        lines.append("  while (c < 100) {")
+        lines.append("    c = c + a + 1;")
+        lines.append("  }")
+        lines.append("  return c;")
+        lines.append("}")
+    lines.append("int main() {")
+    lines.append("  int s = 0;")
+    for i in range(size):
+        lines.append(f"  s = s + f{i}(s, {i});")
+    lines.append("  write(s);")
+    lines.append("  return 0;")
+    lines.append("}")
+    return lines
+
+
+def gen_straight(size):
+    lines = ["int main() {"]
+    lines.append("  int " + ", ".join(f"x{k} = {k + 1}" for k in range(8)) + ";")
+    for i in range(size):
+        a, b, c = i % 8, (i + 3) % 8, (i + 5) % 8
+        lines.append(f"  x{a} = x{b} * {i % 31 + 1} + x{c} - {i % 17};")
+    lines.append("  write(" + " + ".join(f"x{k}" for k in range(8)) + ");")
+    lines.append("  return 0;")
+    lines.append("}")
+    return lines
+
+
+def gen_nesting(size):
+    lines = ["int main() {", "  int a = read();", "  int b = 0;"]
+    for depth in range(size):
+        indent = "  " * (depth + 1)
+        if depth % 2 == 0:
+            lines.append(f"{indent}if (a > {depth}) {{")
+        else:
+            lines.append(f"{indent}while (b < {depth}) {{")
+            lines.append(f"{indent}  b = b + 1;")
+    lines.append("  " * (size + 1) + "a = a + b;")
+    for depth in reversed(range(size)):
+        lines.append("  " * (depth + 1) + "}")
+    lines.append("  write(a);")
+    lines.append("  return 0;")
+    lines.append("}")
+    return lines
+
+
+def gen_globals(size):
+    lines = []
+    for i in range(size // 16):
+        lines.append(f"int g{i} = {i * 7 % 1000};")
+    lines.append(f"int table[{size}] = {{")
+    for start in range(0, size, 16):
+        values = ", ".join(str(v * 37 % 10007) for v in range(start, min(start + 16, size)))
+        lines.append(f"  {values}" + ("," if start + 16 < size else ""))
+    lines.append("};")
+    lines.append("int main() {")
+    lines.append("  int i = 0, s = 0;")
+    lines.append(f"  while (i < {size}) {{")
+    lines.append("    s = s + table[i];")
+    lines.append("    i = i + 1;")
+    lines.append("  }")
+    if size >= 16:
+        lines.append(f"  write(s + g0 + g{size // 16 - 1});")
+    else:
+        lines.append("  write(s);")
+    lines.append("  return 0;")
+    lines.append("}")
+    return lines
+
+
+def gen_arrays(size):
+    lines = [f"int cube[{size}][{size}][4];", "int main() {"]
+    lines.append(f"  int local[{size}][16] = {{{{1, 2, 3}}, {{4}}}};")
+    lines.append("  int i = 0, s = 0;")
+    lines.append(f"  while (i < {size}) {{")
+    lines.append("    int j = 0;")
+    lines.append(f"    while (j < {size}) {{")
+    lines.append("      cube[i][j][j % 4] = i * j + local[i][j % 16];")
+    lines.append("      s = s + cube[i][j][0] + cube[i][j][3];")
+    lines.append("      j = j + 1;")
+    lines.append("    }")
+    lines.append("    local[i][i % 16] = s;")
+    lines.append("    i = i + 1;")
+    lines.append("  }")
+    for k in range(size):
+        lines.append(f"  s = s + local[{k}][{k % 16}] + cube[{k}][{(k * 7) % size}][{k % 4}];")
+    lines.append("  write(s);")
+    lines.append("  return 0;")
+    lines.append("}")
+    return lines
+
+
+GENERATORS = {
+    "functions": gen_functions,
+    "straight": gen_straight,
+    "nesting": gen_nesting,
+    "globals": gen_globals,
+    "arrays": gen_arrays,
+}
+
+
+def generate(shape, size):
+    """返回 shape 和 size 对应的程序文本"""
+    return "\n".join(GENERATORS[shape](size)) + "\n"
+
+
+def main():
+    if len(sys.argv) not in (3, 4) or sys.argv[1] not in GENERATORS:
+        sys.exit(f"usage: {sys.argv[0]} <{'|'.join(SHAPES)}> <size> [output]")
+    text = generate(sys.argv[1], int(sys.argv[2]))
+    if len(sys.argv) == 4:
+        with open(sys.argv[3], "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
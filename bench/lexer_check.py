@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""用 --lexer check 对比三种词法分析器
+
+对 appends/lab0 下的样例和 gen_sysy.py 生成的每种 shape 运行 --lexer check，
+flex、SIMD 和逐字节扫描器给出的记号不一致时编译器报 "Lexer mismatch"。
+只有这种错误算失败：样例里本来就有语义错误的程序会在词法分析之后才失败，
+那时全部记号已经比较过了。
+
+用法: lexer_check.py [--compiler ./compiler] [--size N]
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import gen_sysy  # noqa: E402
+
+
+def check(compiler, source):
+    """返回 None 表示三种扫描器一致，否则返回编译器的诊断信息"""
+    proc = subprocess.run([compiler, source, os.devnull, "--lexer", "check"],
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    stderr = proc.stderr.decode(errors="replace")
+    if "Lexer mismatch" in stderr:
+        return stderr.strip()
+    return None
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description="differential test of the lexers")
+    parser.add_argument("--compiler", default=os.path.join(root, "compiler"))
+    parser.add_argument("--size", type=int, default=200, help="size of each generated shape")
+    args = parser.parse_args()
+
+    sources = sorted(glob.glob(os.path.join(root, "appends", "lab0", "*.sy")))
+    failed = 0
+    with tempfile.TemporaryDirectory(prefix="sysy-lexer-") as workdir:
+        for shape in gen_sysy.SHAPES:
+            path = os.path.join(workdir, f"{shape}_{args.size}.sy")
+            with open(path, "w") as f:
+                f.write(gen_sysy.generate(shape, args.size))
+            sources.append(path)
+
+        for source in sources:
+            error = check(args.compiler, source)
+            name = os.path.relpath(source, root) if source.startswith(root) else os.path.basename(source)
+            if error:
+                print(f"[FAIL] {name}: {error}")
+                failed += 1
+            else:
+                print(f"[ OK ] {name}")
+
+    print(f"{len(sources)} files, {failed} with lexer mismatches")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -2,6 +2,8 @@
 
 #include <unordered_map>
 
+#include "common.hpp"
+
 Module CFGBuilder::build(IR::Code code) {
   Module mod;
   IR::Code current_func;
@@ -9,14 +11,16 @@ Module CFGBuilder::build(IR::Code code) {
 #warning Global variable is not supported yet
 
   // 按函数分割IR代码
-  for (const auto &inst : code) {
-    if (auto func = std::dynamic_pointer_cast<IR::Function>(inst)) {
+  // 指令是侵入式链表的节点，所以逐条从 code 中摘下再挂到 current_func 上
+  while (!code.empty()) {
+    auto inst = code.pop_front();
+    if (inst->opcode == IR::Opcode::Function) {
       if (!current_func.empty()) {
-        mod.functions.push_back(build_single_func(current_func));
+        mod.functions.push_back(build_single_func(std::move(current_func)));
         current_func.clear();
       }
     }
-    else if (auto global = std::dynamic_pointer_cast<IR::Global>(inst)) {
+    else if (auto global = IR::dyn_cast<IR::Global>(inst)) {
       mod.globals.push_back(global);
       continue;
     }
@@ -24,7 +28,7 @@ Module CFGBuilder::build(IR::Code code) {
   }
 
   if (!current_func.empty()) {
-    mod.functions.push_back(build_single_func(current_func));
+    mod.functions.push_back(build_single_func(std::move(current_func)));
   }
 
   return mod;
@@ -42,18 +46,28 @@ FunctionPtr CFGBuilder::build_single_func(IR::Code code) {
 
 #warning Only one block is created for the whole function body now
 
+  // 新建的指令和函数体放在同一个 pool 中
+  auto ir_func = IR::dyn_cast<IR::Function>(code.front());
+  ASSERT(ir_func, "IR of a function must start with FUNCTION");
+  InstPool::Scope scope(*ir_func->pool);
+
+  // 每个 return 都跳到出口块，标签和返回值寄存器只驻留一次
+  static const Ident a0("a0");
+  Ident ret_label;
   BasicBlockPtr current_block = BasicBlock::create("entry");
-  for (const auto &inst : code) {
-    if (auto func = std::dynamic_pointer_cast<IR::Function>(inst)) {
-      func_name = func->name;
+  while (!code.empty()) {
+    auto inst = code.pop_front();
+    if (auto func = IR::dyn_cast<IR::Function>(inst)) {
+      func_name = func->name.str();
       current_block->label = func_name + ".entry";
+      ret_label = Ident(func_name + ".ret");
       current_block->ir_code.push_back(inst);
-    } else if (auto ret = std::dynamic_pointer_cast<IR::Return>(inst)) {
+    } else if (auto ret = IR::dyn_cast<IR::Return>(inst)) {
       if (ret->x.empty()) {
-        current_block->ir_code.push_back(IR::Goto::create(func_name + ".ret"));
+        current_block->ir_code.push_back(IR::Goto::create(ret_label));
       } else {
-        current_block->ir_code.push_back(IR::Assign::create("a0", ret->x));
-        current_block->ir_code.push_back(IR::Goto::create(func_name + ".ret"));
+        current_block->ir_code.push_back(IR::Assign::create(IR::Operand::name(a0), ret->x));
+        current_block->ir_code.push_back(IR::Goto::create(ret_label));
         ret_void = false;
       }
     } else {
@@ -65,19 +79,16 @@ FunctionPtr CFGBuilder::build_single_func(IR::Code code) {
 
   // 添加 exit block，统一处理函数退出
   auto exit_block = BasicBlock::create(func_name + ".ret");
-  exit_block->ir_code.push_back(IR::Label::create(func_name + ".ret"));
+  exit_block->ir_code.push_back(IR::Label::create(ret_label));
   if (!ret_void) {
-    exit_block->ir_code.push_back(IR::Return::create("a0"));
+    exit_block->ir_code.push_back(IR::Return::create(IR::Operand::name(a0)));
   } else {
     exit_block->ir_code.push_back(IR::Return::create());
   }
   blocks.push_back(exit_block);
   label_to_block[func_name + ".ret"] = exit_block;
 
-  return Function::create(func_name, blocks);
-}
-
-std::string CFGBuilder::new_label() {
-  static int label_count = 0;
-  return "LN" + std::to_string(label_count++);
+  auto func = Function::create(func_name, blocks);
+  func->pool = ir_func->pool;
+  return func;
 }
@@ -9,7 +9,6 @@ class CFGBuilder {
 
  private:
   FunctionPtr build_single_func(IR::Code code);
-  std::string new_label();
 };
 
 #endif  // ANALYSIS_CFG_BUILDER_HPP
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "control_flow.hpp"
 
+#include <algorithm>
+
 #include "common.hpp"
 
 int Function::alloc_temp(int size, ASM::Reg reg) {
@@ -10,13 +12,17 @@ int Function::alloc_temp(int size, ASM::Reg reg) {
     throw std::invalid_argument("Size must be positive");
   }
   
-  if (temp_offset.find(reg) != temp_offset.end()) {
-    return temp_offset[reg];
+  if (reg.id >= temp_offset.size()) {
+    size_t slots = std::max<size_t>(reg.id + 1, ASM::Reg::num_phys + vreg_count);
+    temp_offset.resize(slots, no_offset);
+  }
+  if (temp_offset[reg.id] != no_offset) {
+    return temp_offset[reg.id];
   }
 
   int offset = temp_stack_size;
   temp_stack_size += size;
-  temp_offset[reg] = offset;
+  temp_offset[reg.id] = offset;
   
   return offset;
 }
@@ -29,13 +35,17 @@ int Function::alloc_reg(int size, ASM::Reg reg) {
     throw std::invalid_argument("Size must be positive");
   }
 
-  if (reg_offset.find(reg) != reg_offset.end()) {
-    return reg_offset[reg];
+  if (reg.id >= reg_offset.size()) {
+    size_t slots = std::max<size_t>(reg.id + 1, ASM::Reg::num_phys + vreg_count);
+    reg_offset.resize(slots, no_offset);
+  }
+  if (reg_offset[reg.id] != no_offset) {
+    return reg_offset[reg.id];
   }
 
   int offset = -reg_stack_size; // 使用负数偏移量表示相对于 fp 的位置
   reg_stack_size += size;
-  reg_offset[reg] = offset;
+  reg_offset[reg.id] = offset;
 
   return offset;
 }
@@ -54,16 +64,13 @@ int Function::alloc_dec(int size) {
   return offset;
 }
 
-IR::Code Module::get_ir() const {
-  IR::Code code;
+void Module::print_ir(Writer &out) const {
   for (const auto &global : globals) {
-    code.push_back(global);
+    IR::print(out, global);
   }
   for (const auto &func : functions) {
     for (const auto &block : func->blocks) {
-      std::copy(block->ir_code.begin(), block->ir_code.end(),
-                std::back_inserter(code));
+      out << block->ir_code;
     }
   }
-  return code;
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #ifndef ANALYSIS_CONTROL_FLOW_HPP
 #define ANALYSIS_CONTROL_FLOW_HPP
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -8,6 +9,7 @@
 
 #include "codegen/asm.hpp"
 #include "ir/ir.hpp"
+#include "support/alloc_profile.hpp"
 
 class BasicBlock;
 using BasicBlockPtr = std::shared_ptr<BasicBlock>;
@@ -20,10 +22,11 @@ class BasicBlock {
   std::vector<BasicBlockPtr> predecessors;
 
   BasicBlock(std::string label, IR::Code ir_code = {})
-      : label(label), ir_code(ir_code) {}
+      : label(label), ir_code(std::move(ir_code)) {}
 
   static BasicBlockPtr create(std::string label, IR::Code ir_code = {}) {
-    return std::make_shared<BasicBlock>(label, ir_code);
+    AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
+    return std::make_shared<BasicBlock>(label, std::move(ir_code));
   }
 };
 
@@ -33,8 +36,18 @@ class Function {
  public:
   std::string name;
   std::vector<BasicBlockPtr> blocks;
-  std::map<ASM::Reg, int> temp_offset; // 临时变量偏移量映射表
-  std::map<ASM::Reg, int> reg_offset;  // 寄存器偏移量映射表
+
+  /// @brief pool that owns the IR and ASM instructions of the function
+  InstPool *pool = nullptr;
+  /// @brief marks a register that has no stack slot yet
+  static constexpr int no_offset = std::numeric_limits<int>::min();
+
+  // 按寄存器编号索引，no_offset 表示尚未分配
+  std::vector<int> temp_offset; // 临时变量偏移量映射表
+  std::vector<int> reg_offset;  // 寄存器偏移量映射表
+
+  /// @brief number of virtual registers used by the function
+  uint32_t vreg_count = 0;
 
   /// @brief stack size for temporary variables, in bytes
   int temp_stack_size = 0;
@@ -50,6 +63,7 @@ class Function {
 
   static FunctionPtr create(std::string name,
                             std::vector<BasicBlockPtr> blocks = {}) {
+    AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
     return std::make_shared<Function>(name, blocks);
   }
 
@@ -71,6 +85,10 @@ class Function {
 
 class Module {
  public:
+  /// @brief pools owning the instructions of every function and global
+  /// declared first so that they outlive everything pointing into them
+  std::vector<std::unique_ptr<InstPool>> pools;
+
   std::vector<FunctionPtr> functions;
   std::vector<IR::GlobalPtr> globals;
 #warning Have not support global variables yet
@@ -78,7 +96,10 @@ class Module {
   Module() = default;
   Module(std::vector<FunctionPtr> functions) : functions(functions) {}
 
-  IR::Code get_ir() const;
+  /// @brief print the IR of every global and function
+  /// instructions live in their blocks' intrusive lists, so they are printed
+  /// in place instead of being gathered into a new list
+  void print_ir(Writer &out) const;
 };
 
 #endif  // ANALYSIS_CONTROL_FLOW_HPP
\ No newline at end of file
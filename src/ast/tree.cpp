@@ -1,18 +1,72 @@
 #include "tree.hpp"
 
-void AST::Node::print_tree(std::string prefix, std::string info_prefix) {
-  std::cout << info_prefix << to_string() << " (line " << lineno << ")"
-            << std::endl;
-  auto children = get_children();
-  if (children.size() == 1) {
-    children[0]->print_tree(prefix + "    ", prefix + " └─ ");
-  } else {
-    for (size_t i = 0; i < children.size(); i++) {
-      if (i == children.size() - 1) {
-        children[i]->print_tree(prefix + "    ", prefix + " └─ ");
-      } else {
-        children[i]->print_tree(prefix + " │  ", prefix + " ├─ ");
-      }
+const char *AST::kind_name(Kind kind) {
+#define KIND_NAME(type) \
+  case Kind::type:      \
+    return #type;
+  switch (kind) {
+  KIND_NAME(IntConst)
+  KIND_NAME(LVal)
+  KIND_NAME(UnaryExp)
+  KIND_NAME(BinaryExp)
+  KIND_NAME(FuncCall)
+  KIND_NAME(Block)
+  KIND_NAME(AssignStmt)
+  KIND_NAME(ReturnStmt)
+  KIND_NAME(EmptyStmt)
+  KIND_NAME(IfStmt)
+  KIND_NAME(WhileStmt)
+  KIND_NAME(InitList)
+  KIND_NAME(InitVal)
+  KIND_NAME(VarDef)
+  KIND_NAME(VarDecl)
+  KIND_NAME(ArrayDims)
+  KIND_NAME(FuncFParam)
+  KIND_NAME(FuncFParams)
+  KIND_NAME(FuncDef)
+  KIND_NAME(CompUnit)
+  }
+#undef KIND_NAME
+  return "?";
+}
+
+std::string AST::Node::to_string() const {
+  std::string text;
+  Writer out(text);
+  print(out);
+  return text;
+}
+
+void AST::Node::print_tree(Writer &out) {
+  // 用显式栈代替递归：每层只记录下一个要访问的孩子和自己的缩进长度，
+  // 所有层的缩进共用一个字符串，打印一个节点不需要分配内存
+  struct Frame {
+    NodePtr node;
+    size_t next;
+    size_t prefix_length;
+  };
+  std::vector<Frame> stack;
+  std::string prefix;
+
+  print(out);
+  out << " (line " << lineno << ")\n";
+  stack.push_back({this, 0, 0});
+  while (!stack.empty()) {
+    Frame &frame = stack.back();
+    size_t count = frame.node->num_children();
+    if (frame.next == count) {
+      stack.pop_back();
+      continue;
     }
+    bool last = frame.next + 1 == count;
+    NodePtr child = frame.node->child(frame.next++);
+    prefix.resize(frame.prefix_length);
+
+    out << prefix << (last ? " └─ " : " ├─ ");
+    child->print(out);
+    out << " (line " << child->lineno << ")\n";
+
+    prefix += last ? "    " : " │  ";
+    stack.push_back({child, 0, prefix.size()});
   }
 }
@@ -4,166 +4,228 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common.hpp"
 #include "semantic/symbol_table.hpp"
-
-extern int yylineno;
+#include "support/ident.hpp"
+#include "support/writer.hpp"
 
 namespace AST {
 
+/// @brief Kind tag of every concrete AST node, used for O(1) dispatch
+enum class Kind {
+  IntConst,
+  LVal,
+  UnaryExp,
+  BinaryExp,
+  FuncCall,
+  Block,
+  AssignStmt,
+  ReturnStmt,
+  EmptyStmt,
+  IfStmt,
+  WhileStmt,
+  InitList,
+  InitVal,
+  VarDef,
+  VarDecl,
+  ArrayDims,
+  FuncFParam,
+  FuncFParams,
+  FuncDef,
+  CompUnit,
+};
+
+/// @brief name of a node kind, e.g. "BinaryExp"
+const char *kind_name(Kind kind);
+
+// AST nodes are owned by the Arena of their compilation unit (see parser.y)
+// and are freed together with it; a NodePtr is just a non-owning handle
 class Node;
-using NodePtr = std::shared_ptr<Node>;
+using NodePtr = Node *;
 class Node {
  public:
-  int lineno;
+  int lineno;  // set by the parser when the node is created
+  const Kind kind;
 
   SymbolPtr symbol;  // for semantic analysis
-  virtual std::vector<NodePtr> get_children() { return std::vector<NodePtr>(); }
-  void print_tree(std::string prefix = "", std::string info_prefix = "");
-  virtual std::string to_string() = 0;
-
-  Node() : lineno(yylineno) {}
+  /// @brief children in source order, indexed so that walking the tree
+  /// does not build a vector per node
+  virtual size_t num_children() const { return 0; }
+  virtual NodePtr child(size_t i) const { return nullptr; }
+  /// @brief print the subtree, one node per line
+  void print_tree(Writer &out);
+  /// @brief format this node alone, without children or newline
+  virtual void print(Writer &out) const = 0;
+  std::string to_string() const;
+
+  explicit Node(Kind kind) : lineno(0), kind(kind) {}
   virtual ~Node() = default;
 };
 
+/// @brief Base of every concrete node, stamps the node with its kind
+template <Kind K>
+class NodeOf : public Node {
+ public:
+  static constexpr Kind node_kind = K;
+  NodeOf() : Node(K) {}
+};
+
+/// @brief Checked downcast by kind tag, nullptr if node is not a T
+template <typename T>
+T *dyn_cast(Node *node) {
+  return node && node->kind == T::node_kind ? static_cast<T *>(node) : nullptr;
+}
+
+/// @brief print dimensions as "d1,d2,..."
+inline void print_dims(Writer &out, const std::vector<int> &dims) {
+  for (size_t i = 0; i < dims.size(); i++) {
+    if (i > 0) out << ',';
+    out << dims[i];
+  }
+}
+
 class IntConst;
-using IntConstPtr = std::shared_ptr<IntConst>;
-class IntConst : public Node {
+using IntConstPtr = IntConst *;
+class IntConst : public NodeOf<Kind::IntConst> {
  public:
   int value;
   IntConst(int value) : value(value) {}
-  std::string to_string() override {
-    return "IntConst <value: " + std::to_string(value) + ">";
+  void print(Writer &out) const override {
+    out << "IntConst <value: " << value << '>';
   }
 };
 
 class LVal;
-using LValPtr = std::shared_ptr<LVal>;
-class LVal : public Node {
+using LValPtr = LVal *;
+class LVal : public NodeOf<Kind::LVal> {
  public:
-  std::string ident;
+  Ident ident;
   std::vector<NodePtr> indexes;  // for array access
   std::vector<int> dims;  // for array access
-  LVal(std::string ident) : ident(ident) {}
-  std::string to_string() override { return "LVal <ident: " + ident + ", indexes: " + std::to_string(indexes.size()) + ">"; }
+  LVal(Ident ident) : ident(ident) {}
+  void print(Writer &out) const override { out << "LVal <ident: " << ident.str() << ", indexes: " << indexes.size() << '>'; }
   void add_index(NodePtr index) { indexes.push_back(index); }
 };
 
 class UnaryExp;
-using UnaryExpPtr = std::shared_ptr<UnaryExp>;
-class UnaryExp : public Node {
+using UnaryExpPtr = UnaryExp *;
+class UnaryExp : public NodeOf<Kind::UnaryExp> {
  public:
   BinaryOp op;
   NodePtr exp;
   UnaryExp(BinaryOp op, NodePtr exp) : op(op), exp(exp) {}
-  std::string to_string() override {
-    return "UnaryExp <op: " + std::string(op_to_string(op)) + ">";
+  void print(Writer &out) const override {
+    out << "UnaryExp <op: " << op_to_string(op) << '>';
   }
-  std::vector<NodePtr> get_children() override { return {exp}; }
+  size_t num_children() const override { return 1; }
+  NodePtr child(size_t i) const override { return exp; }
 };
 
 class BinaryExp;
-using BinaryExpPtr = std::shared_ptr<BinaryExp>;
-class BinaryExp : public Node {
+using BinaryExpPtr = BinaryExp *;
+class BinaryExp : public NodeOf<Kind::BinaryExp> {
  public:
   BinaryOp op;
   NodePtr left, right;
 
   BinaryExp(BinaryOp op, NodePtr left, NodePtr right)
       : op(op), left(left), right(right) {}
-  std::string to_string() override {
-    return "BinaryExp <op: " + std::string(op_to_string(op)) + ">";
+  void print(Writer &out) const override {
+    out << "BinaryExp <op: " << op_to_string(op) << '>';
   }
-  std::vector<NodePtr> get_children() override { return {left, right}; }
+  size_t num_children() const override { return 2; }
+  NodePtr child(size_t i) const override { return i == 0 ? left : right; }
 };
 
 class FuncCall;
-using FuncCallPtr = std::shared_ptr<FuncCall>;
-class FuncCall : public Node {
+using FuncCallPtr = FuncCall *;
+class FuncCall : public NodeOf<Kind::FuncCall> {
  public:
-  std::string name;
+  Ident name;
   std::vector<NodePtr> args;
   SymbolPtr symbol;
-  FuncCall(char const *name) : name(name) {}
+  FuncCall(Ident name) : name(name) {}
   FuncCall(NodePtr exp) { add_arg(exp); }
   void add_arg(NodePtr exp) { args.push_back(exp); }
-  std::string to_string() override { return "FuncCall <name: " + name + ">"; }
-  std::vector<NodePtr> get_children() override { return args; }
+  void print(Writer &out) const override { out << "FuncCall <name: " << name.str() << '>'; }
+  size_t num_children() const override { return args.size(); }
+  NodePtr child(size_t i) const override { return args[i]; }
 };
 
 class Block;
-using BlockPtr = std::shared_ptr<Block>;
-class Block : public Node {
+using BlockPtr = Block *;
+class Block : public NodeOf<Kind::Block> {
  public:
   std::vector<NodePtr> stmts;
   Block() {}
   Block(NodePtr stmt) { add_stmt(stmt); }
   void add_stmt(NodePtr stmt) { stmts.push_back(stmt); }
-  std::string to_string() override { return "Block"; }
-  std::vector<NodePtr> get_children() override { return stmts; }
+  void print(Writer &out) const override { out << "Block"; }
+  size_t num_children() const override { return stmts.size(); }
+  NodePtr child(size_t i) const override { return stmts[i]; }
 };
 
 class AssignStmt;
-using AssignStmtPtr = std::shared_ptr<AssignStmt>;
-class AssignStmt : public Node {
+using AssignStmtPtr = AssignStmt *;
+class AssignStmt : public NodeOf<Kind::AssignStmt> {
  public:
   LValPtr lval;
   NodePtr exp;
   AssignStmt(LValPtr lval, NodePtr exp) : lval(lval), exp(exp) {}
-  std::string to_string() override { return "AssignStmt"; }
-  std::vector<NodePtr> get_children() override { return {lval, exp}; }
+  void print(Writer &out) const override { out << "AssignStmt"; }
+  size_t num_children() const override { return 2; }
+  NodePtr child(size_t i) const override { return i == 0 ? lval : exp; }
 };
 
 class ReturnStmt;
-using ReturnStmtPtr = std::shared_ptr<ReturnStmt>;
-class ReturnStmt : public Node {
+using ReturnStmtPtr = ReturnStmt *;
+class ReturnStmt : public NodeOf<Kind::ReturnStmt> {
  public:
   NodePtr exp;
   ReturnStmt() : exp(nullptr) {}
   ReturnStmt(NodePtr exp) : exp(exp) {}
-  std::string to_string() override { return "ReturnStmt"; }
-  std::vector<NodePtr> get_children() override {
-    return exp ? std::vector<NodePtr>{exp} : std::vector<NodePtr>();
-  }
+  void print(Writer &out) const override { out << "ReturnStmt"; }
+  size_t num_children() const override { return exp ? 1 : 0; }
+  NodePtr child(size_t i) const override { return exp; }
 };
 
 class EmptyStmt;
-using EmptyStmtPtr = std::shared_ptr<EmptyStmt>;
-class EmptyStmt : public Node {
+using EmptyStmtPtr = EmptyStmt *;
+class EmptyStmt : public NodeOf<Kind::EmptyStmt> {
  public:
-  std::string to_string() override { return "EmptyStmt"; }
+  void print(Writer &out) const override { out << "EmptyStmt"; }
 };
 
 class IfStmt;
-using IfStmtPtr = std::shared_ptr<IfStmt>;
-class IfStmt : public Node {
+using IfStmtPtr = IfStmt *;
+class IfStmt : public NodeOf<Kind::IfStmt> {
  public:
   NodePtr cond, true_stmt, false_stmt;
   IfStmt(NodePtr cond, NodePtr true_stmt, NodePtr false_stmt=nullptr)
       : cond(cond), true_stmt(true_stmt), false_stmt(false_stmt) {}
-  std::string to_string() override { return "IfStmt"; }
-  std::vector<NodePtr> get_children() override {
-    if (false_stmt) {
-      return {cond, true_stmt, false_stmt};
-    }
-    return {cond, true_stmt};
+  void print(Writer &out) const override { out << "IfStmt"; }
+  size_t num_children() const override { return false_stmt ? 3 : 2; }
+  NodePtr child(size_t i) const override {
+    return i == 0 ? cond : i == 1 ? true_stmt : false_stmt;
   }
 };
 
 class WhileStmt;
-using WhileStmtPtr = std::shared_ptr<WhileStmt>;
-class WhileStmt : public Node {
+using WhileStmtPtr = WhileStmt *;
+class WhileStmt : public NodeOf<Kind::WhileStmt> {
  public:
   NodePtr cond, stmt;
   WhileStmt(NodePtr cond, NodePtr stmt) : cond(cond), stmt(stmt) {}
-  std::string to_string() override { return "WhileStmt"; }
-  std::vector<NodePtr> get_children() override { return {cond, stmt}; }
+  void print(Writer &out) const override { out << "WhileStmt"; }
+  size_t num_children() const override { return 2; }
+  NodePtr child(size_t i) const override { return i == 0 ? cond : stmt; }
 };
 
 // class InitElements;
-// using InitElementsPtr = std::shared_ptr<InitElements>;
+// using InitElementsPtr = InitElements *;
 // class InitElements : public Node {
 //  public:
 //   std::vector<NodePtr> elements;
@@ -174,27 +236,23 @@ class WhileStmt : public Node {
 // };
 
 class InitList;
-using InitListPtr = std::shared_ptr<InitList>;
-class InitList : public Node {
+using InitListPtr = InitList *;
+class InitList : public NodeOf<Kind::InitList> {
  public:
   std::vector<NodePtr> elements;
   InitList() {}
   InitList(NodePtr element) { add_element(element); }
   void add_element(NodePtr element) { elements.push_back(element); }
-  std::string to_string() override { return "InitList"; }
-  std::vector<NodePtr> get_children() override { return elements; }
+  void print(Writer &out) const override { out << "InitList"; }
+  size_t num_children() const override { return elements.size(); }
+  NodePtr child(size_t i) const override { return elements[i]; }
 };
 
 class InitVal;
-using InitValPtr = std::shared_ptr<InitVal>;
-class InitVal : public Node {
+using InitValPtr = InitVal *;
+class InitVal : public NodeOf<Kind::InitVal> {
  public:
   std::vector<NodePtr> inits;
-  InitVal() {
-    // empty list {}
-    auto empty_list = new InitList();
-    inits.push_back(std::shared_ptr<InitList>(empty_list));
-  }
   InitVal(NodePtr init) { add_val(init); }
   InitVal(InitValPtr list) {
     for (NodePtr init : list->inits) {
@@ -202,166 +260,151 @@ class InitVal : public Node {
     }
   }
   void add_val(NodePtr init) { inits.push_back(init); }
-  std::string to_string() override { return "InitVal"; }
-  std::vector<NodePtr> get_children() override { return inits; }
+  void print(Writer &out) const override { out << "InitVal"; }
+  size_t num_children() const override { return inits.size(); }
+  NodePtr child(size_t i) const override { return inits[i]; }
 };
 
 
 
 class VarDef;
-using VarDefPtr = std::shared_ptr<VarDef>;
-class VarDef : public Node {
+using VarDefPtr = VarDef *;
+class VarDef : public NodeOf<Kind::VarDef> {
  public:
-  std::string ident;
+  Ident ident;
   std::vector<int> dim;
   // init list
   InitValPtr inits=nullptr;
   
-  VarDef(char const *ident) : ident(ident) {}
-  VarDef(VarDefPtr var, int d) : ident(var->ident), dim(var->dim) { add_dim(d); }
-  VarDef(char const *ident, InitValPtr inits) : ident(ident), inits(inits) {};
-  VarDef(VarDefPtr var, int d, InitValPtr inits) : ident(var->ident), dim(var->dim), inits(inits) { add_dim(d); }
+  VarDef(Ident ident) : ident(ident) {}
+  VarDef(Ident ident, InitValPtr inits) : ident(ident), inits(inits) {};
   void add_dim (int d) { dim.push_back(d); }
-  std::string to_string() override { 
+  void print(Writer &out) const override { 
+    out << "VarDef <ident: " << ident.str();
     if (dim.size() > 0) {
-      std::string dim_str = "dim: (";
-      for (int d : dim) {
-        dim_str += std::to_string(d) + ",";
-      }
-      dim_str.pop_back();
-      dim_str += ")";
-      return "VarDef <ident: " + ident + ", " + dim_str + ">";
+      out << ", dim: (";
+      print_dims(out, dim);
+      out << ')';
     }
-    return "VarDef <ident: " + ident + ">"; 
-  }
-  std::vector<NodePtr> get_children() override {
-    if (inits) {
-      return {inits};
-    }
-    return {};
+    out << '>';
   }
+  size_t num_children() const override { return inits ? 1 : 0; }
+  NodePtr child(size_t i) const override { return inits; }
 };
 
 class VarDecl;
-using VarDeclPtr = std::shared_ptr<VarDecl>;
-class VarDecl : public Node {
+using VarDeclPtr = VarDecl *;
+class VarDecl : public NodeOf<Kind::VarDecl> {
  public:
   BasicType btype;
   std::vector<VarDefPtr> defs;
   VarDecl(VarDefPtr def) : btype(BasicType::Unknown) { add_def(def); }
   void add_def(VarDefPtr def) { defs.push_back(def); }
-  std::string to_string() override {
-    return "VarDecl <btype: " + std::string(type_to_string(btype)) + ">";
-  }
-  std::vector<NodePtr> get_children() override {
-    return std::vector<NodePtr>(defs.begin(), defs.end());
+  void print(Writer &out) const override {
+    out << "VarDecl <btype: " << type_to_string(btype) << '>';
   }
+  size_t num_children() const override { return defs.size(); }
+  NodePtr child(size_t i) const override { return defs[i]; }
 };
 
 class ArrayDims;
-using ArrayDimsPtr = std::shared_ptr<ArrayDims>;
-class ArrayDims : public Node {
+using ArrayDimsPtr = ArrayDims *;
+class ArrayDims : public NodeOf<Kind::ArrayDims> {
   public:
     std::vector<int> dims;
     ArrayDims(int d) { add_dim(d); }
     void add_dim(int dim) { dims.push_back(dim); }
-    std::string to_string() override {
-      std::string dim_str = "dims: (";
-      for (int d : dims) {
-        dim_str += std::to_string(d) + ",";
-      }
-      dim_str.pop_back();
-      dim_str += ")";
-      return "ArrayDims <" + dim_str + ">";
+    void print(Writer &out) const override {
+      out << "ArrayDims <dims: (";
+      print_dims(out, dims);
+      out << ")>";
     }
 };
 
 class FuncFParam;
-using FuncFParamPtr = std::shared_ptr<FuncFParam>;
-class FuncFParam : public Node {
+using FuncFParamPtr = FuncFParam *;
+class FuncFParam : public NodeOf<Kind::FuncFParam> {
   public:    
-    std::string ident;
+    Ident ident;
     std::vector<int> dim;
-    FuncFParam(char const *ident) : ident(ident) {}
-    FuncFParam(char const *ident, int emplace) : ident(ident) {
+    FuncFParam(Ident ident) : ident(ident) {}
+    FuncFParam(Ident ident, int emplace) : ident(ident) {
       dim.push_back(emplace);
     }
-    FuncFParam(char const *ident, ArrayDimsPtr dims) : ident(ident) {
+    FuncFParam(Ident ident, ArrayDimsPtr dims) : ident(ident) {
       dim.push_back(0);
       for (auto i : dims->dims) {
         dim.push_back(i);
       }
     }
-    std::string to_string() override {       
+    void print(Writer &out) const override {       
       if (dim.size() > 0) {
-        std::string dim_str = "dim: (";        
-        for (int d : dim) {
-          dim_str += std::to_string(d) + ",";
-        }
-        dim_str.pop_back();
-        dim_str += ")";
-        return "<btype: int, ident: " + ident + ", " + dim_str + ">";
+        out << "<btype: int, ident: " << ident.str() << ", dim: (";
+        print_dims(out, dim);
+        out << ")>";
+        return;
       }
-      return "<bytype: int, ident: " + ident + ">"; 
+      out << "<bytype: int, ident: " << ident.str() << '>'; 
     }    
 };
 
 class FuncFParams;
-using FuncFParamsPtr = std::shared_ptr<FuncFParams>;
-class FuncFParams : public Node {
+using FuncFParamsPtr = FuncFParams *;
+class FuncFParams : public NodeOf<Kind::FuncFParams> {
   public:
     std::vector<FuncFParamPtr> params;
     FuncFParams(FuncFParamPtr param) { add_param(param); }
     void add_param(FuncFParamPtr param) { params.push_back(param); }    
-    std::string to_string() override {
-      std::string params_str = "";
-      for (FuncFParamPtr param : params) {
-        params_str += param->to_string() + ", ";
+    void print(Writer &out) const override {
+      out << "Params { ";
+      for (size_t i = 0; i < params.size(); i++) {
+        if (i > 0) out << ", ";
+        params[i]->print(out);
       }
-      params_str.pop_back();
-      params_str.pop_back();
-      params_str += " }";
-      return "Params { " + params_str + ">";
+      out << " }>";
     }
 };
 
 class FuncDef;
-using FuncDefPtr = std::shared_ptr<FuncDef>;
-class FuncDef : public Node {
+using FuncDefPtr = FuncDef *;
+class FuncDef : public NodeOf<Kind::FuncDef> {
  public:
   BasicType return_btype;
-  std::string name;
+  Ident name;
   BlockPtr block;
   // to support params:
   FuncFParamsPtr params;
 
-  FuncDef(BasicType return_btype, char const *name, BlockPtr block)
-      : return_btype(return_btype), name(name), block(block) {}
+  FuncDef(BasicType return_btype, Ident name, BlockPtr block)
+      : return_btype(return_btype), name(name), block(block), params(nullptr) {}
   
-  FuncDef(BasicType return_btype, char const *name, BlockPtr block, FuncFParamsPtr params)  
+  FuncDef(BasicType return_btype, Ident name, BlockPtr block, FuncFParamsPtr params)  
       : return_btype(return_btype), name(name), block(block), params(params) {}
 
-  std::string to_string() override {
+  void print(Writer &out) const override {
     // add params
-    return "FuncDef <return_btype: " + std::string(type_to_string(return_btype)) + ", name: " + name + ">";
+    out << "FuncDef <return_btype: " << type_to_string(return_btype) << ", name: " << name.str() << '>';
   }
-  std::vector<NodePtr> get_children() override { 
-    if (params) {
-      return {params, block};
+  size_t num_children() const override { return params ? 2 : 1; }
+  NodePtr child(size_t i) const override { 
+    if (params && i == 0) {
+      return params;
     }
-    return {block};
+    return block;
   }
 };
 
 class CompUnit;
-using CompUnitPtr = std::shared_ptr<CompUnit>;
-class CompUnit : public Node {
+using CompUnitPtr = CompUnit *;
+class CompUnit : public NodeOf<Kind::CompUnit> {
  public:
   std::vector<NodePtr> units;  // FuncDef or VarDecl
+  CompUnit() = default;
   CompUnit(NodePtr unit) { add_unit(unit); }
   void add_unit(NodePtr unit) { units.push_back(unit); }
-  std::string to_string() override { return "CompUnit"; }
-  std::vector<NodePtr> get_children() override { return units; }
+  void print(Writer &out) const override { out << "CompUnit"; }
+  size_t num_children() const override { return units.size(); }
+  NodePtr child(size_t i) const override { return units[i]; }
 };
 
 #warning More AST nodes are needed
@@ -2,12 +2,20 @@
 #define CODEGEN_ASM_HPP
 
 #include <iostream>
-#include <list>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "support/ilist.hpp"
+#include "support/inst_builder.hpp"
+#include "support/inst_pool.hpp"
+#include "support/writer.hpp"
 namespace ASM {
 
 class Reg {
@@ -15,68 +23,194 @@ public:
     static const Reg zero, ra, sp, gp, tp, t0, t1, t2, fp, s1, a0, a1, a2, a3, a4,
         a5, a6, a7, s2, s3, s4, s5, s6, s7, s8, s9, s10, s11, t3, t4, t5, t6;
 
-    std::string name;
+    /// @brief 物理寄存器编号为 0-31（即 ABI 编号），虚拟寄存器从 32 开始
+    static constexpr uint32_t num_phys = 32;
 
-    Reg(std::string name) :
-        name(name), physical(false) {
-        static const std::set<std::string> physical_registers = {
-            "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "fp", "s1", "a0",
-            "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5",
-            "s6", "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+    uint32_t id;
 
-        if (physical_registers.find(name) != physical_registers.end()) {
-            physical = true;
+    constexpr Reg() :
+        id(0) {
+    }
+    constexpr explicit Reg(uint32_t id) :
+        id(id) {
+    }
+
+    /// @brief 第 n 个虚拟寄存器
+    static constexpr Reg virt(uint32_t n) {
+        return Reg(num_phys + n);
+    }
+    /// @brief 第 k 个参数寄存器 a0-a7
+    static constexpr Reg arg(int k) {
+        return Reg(10 + k);
+    }
+    /// @brief 按名字查找物理寄存器
+    /// @return 找不到时返回 false
+    static bool lookup(const std::string &name, Reg &reg) {
+        for (uint32_t i = 0; i < num_phys; i++) {
+            if (name == phys_names[i]) {
+                reg = Reg(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string name() const {
+        if (is_phys()) {
+            return phys_names[id];
+        }
+        return "v" + std::to_string(id - num_phys);
+    }
+    void print(Writer &out) const {
+        if (is_phys()) {
+            out << phys_names[id];
+        } else {
+            out << 'v' << id - num_phys;
         }
     }
 
-    bool operator==(const Reg &other) const {
-        return name == other.name && physical == other.physical;
+    constexpr bool operator==(const Reg &other) const {
+        return id == other.id;
     }
-    bool operator!=(const Reg &other) const {
-        return !(*this == other);
+    constexpr bool operator!=(const Reg &other) const {
+        return id != other.id;
     }
-    bool operator<(const Reg &other) const {
-        return name < other.name || (name == other.name && physical < other.physical);
+    constexpr bool operator<(const Reg &other) const {
+        return id < other.id;
     }
-    bool is_phys() const {
-        return physical;
+    constexpr bool is_phys() const {
+        return id < num_phys;
     }
 
 private:
-    bool physical;
-    Reg(std::string name, bool physical) :
-        name(name), physical(physical) {
+    static constexpr const char *phys_names[num_phys] = {
+        "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "fp", "s1", "a0",
+        "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5",
+        "s6", "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+};
+
+inline constexpr Reg Reg::zero(0), Reg::ra(1), Reg::sp(2), Reg::gp(3),
+    Reg::tp(4), Reg::t0(5), Reg::t1(6), Reg::t2(7), Reg::fp(8), Reg::s1(9),
+    Reg::a0(10), Reg::a1(11), Reg::a2(12), Reg::a3(13), Reg::a4(14),
+    Reg::a5(15), Reg::a6(16), Reg::a7(17), Reg::s2(18), Reg::s3(19),
+    Reg::s4(20), Reg::s5(21), Reg::s6(22), Reg::s7(23), Reg::s8(24),
+    Reg::s9(25), Reg::s10(26), Reg::s11(27), Reg::t3(28), Reg::t4(29),
+    Reg::t5(30), Reg::t6(31);
+
+/// @brief 定长的小寄存器集合，用于 get_uses / get_defs
+/// 一条指令涉及的寄存器不会超过 capacity 个，因此不需要堆分配
+class RegSet {
+public:
+    static constexpr size_t capacity = 16;
+
+    RegSet() = default;
+    RegSet(std::initializer_list<Reg> regs) {
+        for (const auto &reg : regs) {
+            insert(reg);
+        }
     }
+
+    void insert(Reg reg) {
+        if (contains(reg)) {
+            return;
+        }
+        assert(count < capacity && "RegSet overflow");
+        regs[count++] = reg;
+    }
+    bool contains(Reg reg) const {
+        return std::find(begin(), end(), reg) != end();
+    }
+    size_t size() const {
+        return count;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    const Reg *begin() const {
+        return regs;
+    }
+    const Reg *end() const {
+        return regs + count;
+    }
+
+private:
+    Reg regs[capacity];
+    uint8_t count = 0;
 };
 
-inline const Reg Reg::zero("zero", true), Reg::ra("ra", true),
-    Reg::sp("sp", true), Reg::gp("gp", true), Reg::tp("tp", true),
-    Reg::t0("t0", true), Reg::t1("t1", true), Reg::t2("t2", true),
-    Reg::fp("fp", true), Reg::s1("s1", true), Reg::a0("a0", true),
-    Reg::a1("a1", true), Reg::a2("a2", true), Reg::a3("a3", true),
-    Reg::a4("a4", true), Reg::a5("a5", true), Reg::a6("a6", true),
-    Reg::a7("a7", true), Reg::s2("s2", true), Reg::s3("s3", true),
-    Reg::s4("s4", true), Reg::s5("s5", true), Reg::s6("s6", true),
-    Reg::s7("s7", true), Reg::s8("s8", true), Reg::s9("s9", true),
-    Reg::s10("s10", true), Reg::s11("s11", true), Reg::t3("t3", true),
-    Reg::t4("t4", true), Reg::t5("t5", true), Reg::t6("t6", true);
+/// @brief 寄存器映射 (old_reg -> new_reg)，按寄存器编号索引的稠密表
+/// 未设置的寄存器映射到自身
+class RegMap {
+public:
+    void set(Reg from, Reg to) {
+        if (from.id >= map.size()) {
+            size_t old_size = map.size();
+            map.resize(from.id + 1);
+            for (size_t i = old_size; i < map.size(); i++) {
+                map[i] = Reg(i);
+            }
+        }
+        map[from.id] = to;
+    }
+    bool contains(Reg reg) const {
+        return reg.id < map.size() && map[reg.id] != reg;
+    }
+    Reg operator[](Reg reg) const {
+        return reg.id < map.size() ? map[reg.id] : reg;
+    }
+
+private:
+    std::vector<Reg> map;
+};
 
-using RegMap = std::map<Reg, Reg>;
+/// @brief 汇编指令的操作码，每种指令一个
+enum class Opcode {
+    Arith,
+    ArithImm,
+    Mv,
+    Li,
+    La,
+    Load,
+    Store,
+    Branch,
+    Jump,
+    Call,
+    Ret,
+    Label,
+    GlobalLabel,
+    Function,
+    Zero,
+    Word,
+};
 
+// 汇编指令由所属函数的 InstPool 持有，并串在侵入式链表中
 class Inst;
-using InstPtr = std::shared_ptr<Inst>;
-class Inst {
+using InstPtr = Inst *;
+class Inst : public IListNode<Inst> {
 public:
-    virtual std::string to_string() const = 0;
+    const Opcode opcode;
+
+    explicit Inst(Opcode opcode) :
+        opcode(opcode) {
+    }
     virtual ~Inst() = default; // make the class polymorphic
 
+    /// @brief 把指令直接格式化到 out 中，不含缩进和换行
+    virtual void print(Writer &out) const = 0;
+    std::string to_string() const {
+        std::string text;
+        Writer out(text);
+        print(out);
+        return text;
+    }
+
     /// @brief 获取指令使用的寄存器
     /// @return 使用的寄存器集合
-    virtual std::set<Reg> get_uses() const = 0;
+    virtual RegSet get_uses() const = 0;
 
     /// @brief 获取指令定义的寄存器
     /// @return 定义的寄存器集合
-    virtual std::set<Reg> get_defs() const = 0;
+    virtual RegSet get_defs() const = 0;
 
     /// @brief 替换指令使用的寄存器
     /// @param reg_map 寄存器映射 (old_reg -> new_reg)
@@ -94,10 +228,26 @@ public:
     }
 };
 
+/// @brief Base of every concrete instruction, stamps it with its opcode
+template <Opcode O>
+class InstOf : public Inst {
+public:
+    static constexpr Opcode inst_opcode = O;
+    InstOf() :
+        Inst(O) {
+    }
+};
+
+/// @brief Checked downcast by opcode, nullptr if inst is not a T
+template <typename T>
+T *dyn_cast(Inst *inst) {
+    return inst && inst->opcode == T::inst_opcode ? static_cast<T *>(inst) : nullptr;
+}
+
 // 算数指令
 class Arith;
-using ArithPtr = std::shared_ptr<Arith>;
-class Arith : public Inst {
+using ArithPtr = Arith *;
+class Arith : public InstOf<Opcode::Arith> {
 public:
     // enum class BinaryOp { Add, Sub, Not, Mul, Div, Mod, And, Or, Eq, Ne, Lt, Gt, Le, Ge };
     enum class Op {
@@ -121,11 +271,11 @@ public:
         rd(rd), rs1(rs1), rs2(rs2), op(op) {
     }
     static ArithPtr create(Reg rd, Reg rs1, Reg rs2, Op op) {
-        return std::make_shared<Arith>(rd, rs1, rs2, op);
+        return InstPool::current().create<Arith>(rd, rs1, rs2, op);
     }
 
-    std::string to_string() const override {
-        std::string op_str;
+    void print(Writer &out) const override {
+        const char *op_str = "";
         switch (op) {
         case Op::Add:
             op_str = "add";
@@ -160,34 +310,33 @@ public:
         default:
             assert(false && "Unknown arithmetic operation");
         }
-        return op_str + " " + rd.name + ", " + rs1.name + ", " + rs2.name;
+        out << op_str << ' ';
+        rd.print(out);
+        out << ", ";
+        rs1.print(out);
+        out << ", ";
+        rs2.print(out);
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs1, rs2};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs1) != reg_map.end()) {
-            rs1 = reg_map.at(rs1);
-        }
-        if (reg_map.find(rs2) != reg_map.end()) {
-            rs2 = reg_map.at(rs2);
-        }
+        rs1 = reg_map[rs1];
+        rs2 = reg_map[rs2];
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 // 算数立即数指令
 class ArithImm;
-using ArithImmPtr = std::shared_ptr<ArithImm>;
-class ArithImm : public Inst {
+using ArithImmPtr = ArithImm *;
+class ArithImm : public InstOf<Opcode::ArithImm> {
 public:
     enum class Op {
         Addi,
@@ -211,11 +360,11 @@ public:
         rd(rd), rs1(rs1), imm(imm), op(op) {
     }
     static ArithImmPtr create(Reg rd, Reg rs1, int imm, Op op) {
-        return std::make_shared<ArithImm>(rd, rs1, imm, op);
+        return InstPool::current().create<ArithImm>(rd, rs1, imm, op);
     }
 
-    std::string to_string() const override {
-        std::string op_str;
+    void print(Writer &out) const override {
+        const char *op_str = "";
         int modified_imm = imm;
         switch (op) {
         case Op::Addi:
@@ -235,30 +384,30 @@ public:
             op_str = "rem";
             break;
         }
-        return op_str + " " + rd.name + ", " + rs1.name + ", " + std::to_string(modified_imm);
+        out << op_str << ' ';
+        rd.print(out);
+        out << ", ";
+        rs1.print(out);
+        out << ", " << modified_imm;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs1};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs1) != reg_map.end()) {
-            rs1 = reg_map.at(rs1);
-        }
+        rs1 = reg_map[rs1];
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 class Mv;
-using MvPtr = std::shared_ptr<Mv>;
-class Mv : public Inst {
+using MvPtr = Mv *;
+class Mv : public InstOf<Opcode::Mv> {
 public:
     Reg rd, rs;
 
@@ -266,34 +415,33 @@ public:
         rd(rd), rs(rs) {
     }
     static MvPtr create(Reg rd, Reg rs) {
-        return std::make_shared<Mv>(rd, rs);
+        return InstPool::current().create<Mv>(rd, rs);
     }
 
-    std::string to_string() const override {
-        return "mv " + rd.name + ", " + rs.name;
+    void print(Writer &out) const override {
+        out << "mv ";
+        rd.print(out);
+        out << ", ";
+        rs.print(out);
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs) != reg_map.end()) {
-            rs = reg_map.at(rs);
-        }
+        rs = reg_map[rs];
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 class Li;
-using LiPtr = std::shared_ptr<Li>;
-class Li : public Inst {
+using LiPtr = Li *;
+class Li : public InstOf<Opcode::Li> {
 public:
     Reg rd;
     int imm;
@@ -302,31 +450,31 @@ public:
         rd(rd), imm(imm) {
     }
     static LiPtr create(Reg rd, int imm) {
-        return std::make_shared<Li>(rd, imm);
+        return InstPool::current().create<Li>(rd, imm);
     }
 
-    std::string to_string() const override {
-        return "li " + rd.name + ", " + std::to_string(imm);
+    void print(Writer &out) const override {
+        out << "li ";
+        rd.print(out);
+        out << ", " << imm;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 class La;
-using LaPtr = std::shared_ptr<La>;
-class La : public Inst {
+using LaPtr = La *;
+class La : public InstOf<Opcode::La> {
 public:
     Reg rd;
     std::string label;
@@ -335,33 +483,33 @@ public:
         rd(rd), label(label) {
     }
     static LaPtr create(Reg rd, std::string label) {
-        return std::make_shared<La>(rd, label);
+        return InstPool::current().create<La>(rd, label);
     }
 
-    std::string to_string() const override {
-        return "la " + rd.name + ", " + label;
+    void print(Writer &out) const override {
+        out << "la ";
+        rd.print(out);
+        out << ", " << label;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 // Memory 相关指令
 // rd = M[rs1 + offset]
 class Load;
-using LoadPtr = std::shared_ptr<Load>;
-class Load : public Inst {
+using LoadPtr = Load *;
+class Load : public InstOf<Opcode::Load> {
 public:
     Reg rd, rs1;
     int offset;
@@ -370,35 +518,35 @@ public:
         rd(rd), rs1(rs1), offset(offset) {
     }
     static LoadPtr create(Reg rd, Reg rs1, int offset) {
-        return std::make_shared<Load>(rd, rs1, offset);
+        return InstPool::current().create<Load>(rd, rs1, offset);
     }
 
-    std::string to_string() const override {
-        return "lw " + rd.name + ", " + std::to_string(offset) + "(" + rs1.name + ")";
+    void print(Writer &out) const override {
+        out << "lw ";
+        rd.print(out);
+        out << ", " << offset << '(';
+        rs1.print(out);
+        out << ')';
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs1};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {rd};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs1) != reg_map.end()) {
-            rs1 = reg_map.at(rs1);
-        }
+        rs1 = reg_map[rs1];
     }
     void replace_defs(const RegMap &reg_map) override {
-        if (reg_map.find(rd) != reg_map.end()) {
-            rd = reg_map.at(rd);
-        }
+        rd = reg_map[rd];
     }
 };
 
 // M[rs1 + offset] = rs2
 class Store;
-using StorePtr = std::shared_ptr<Store>;
-class Store : public Inst {
+using StorePtr = Store *;
+class Store : public InstOf<Opcode::Store> {
 public:
     Reg rs1, rs2;
     int offset;
@@ -407,26 +555,26 @@ public:
         rs1(rs1), rs2(rs2), offset(offset) {
     }
     static StorePtr create(Reg rs1, Reg rs2, int offset) {
-        return std::make_shared<Store>(rs1, rs2, offset);
+        return InstPool::current().create<Store>(rs1, rs2, offset);
     }
 
-    std::string to_string() const override {
-        return "sw " + rs2.name + ", " + std::to_string(offset) + "(" + rs1.name + ")";
+    void print(Writer &out) const override {
+        out << "sw ";
+        rs2.print(out);
+        out << ", " << offset << '(';
+        rs1.print(out);
+        out << ')';
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs1, rs2};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs1) != reg_map.end()) {
-            rs1 = reg_map.at(rs1);
-        }
-        if (reg_map.find(rs2) != reg_map.end()) {
-            rs2 = reg_map.at(rs2);
-        }
+        rs1 = reg_map[rs1];
+        rs2 = reg_map[rs2];
     }
     void replace_defs(const RegMap &reg_map) override {
     }
@@ -434,8 +582,8 @@ public:
 
 // 条件分支指令
 class Branch;
-using BranchPtr = std::shared_ptr<Branch>;
-class Branch : public Inst {
+using BranchPtr = Branch *;
+class Branch : public InstOf<Opcode::Branch> {
 public:
     enum class Op {
         Beq, // ==
@@ -454,11 +602,11 @@ public:
         rs1(rs1), rs2(rs2), label(label), op(op) {
     }
     static BranchPtr create(Reg rs1, Reg rs2, std::string label, Op op) {
-        return std::make_shared<Branch>(rs1, rs2, label, op);
+        return InstPool::current().create<Branch>(rs1, rs2, label, op);
     }
 
-    std::string to_string() const override {
-        std::string op_str;
+    void print(Writer &out) const override {
+        const char *op_str = "";
         switch (op) {
         case Op::Beq:
             op_str = "beq";
@@ -479,30 +627,30 @@ public:
             op_str = "bge";
             break;
         }
-        return op_str + " " + rs1.name + ", " + rs2.name + ", " + label;
+        out << op_str << ' ';
+        rs1.print(out);
+        out << ", ";
+        rs2.print(out);
+        out << ", " << label;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {rs1, rs2};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
-        if (reg_map.find(rs1) != reg_map.end()) {
-            rs1 = reg_map.at(rs1);
-        }
-        if (reg_map.find(rs2) != reg_map.end()) {
-            rs2 = reg_map.at(rs2);
-        }
+        rs1 = reg_map[rs1];
+        rs2 = reg_map[rs2];
     }
     void replace_defs(const RegMap &reg_map) override {
     }
 };
 
 class Jump;
-using JumpPtr = std::shared_ptr<Jump>;
-class Jump : public Inst {
+using JumpPtr = Jump *;
+class Jump : public InstOf<Opcode::Jump> {
 public:
     std::string label;
 
@@ -510,17 +658,17 @@ public:
         label(label) {
     }
     static JumpPtr create(std::string label) {
-        return std::make_shared<Jump>(label);
+        return InstPool::current().create<Jump>(label);
     }
 
-    std::string to_string() const override {
-        return "j " + label;
+    void print(Writer &out) const override {
+        out << "j " << label;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -531,8 +679,8 @@ public:
 
 // 函数指令
 class Call;
-using CallPtr = std::shared_ptr<Call>;
-class Call : public Inst {
+using CallPtr = Call *;
+class Call : public InstOf<Opcode::Call> {
 public:
     std::string func;
 
@@ -540,18 +688,18 @@ public:
         func(func) {
     }
     static CallPtr create(std::string func) {
-        return std::make_shared<Call>(func);
+        return InstPool::current().create<Call>(func);
     }
 
-    std::string to_string() const override {
-        return "call " + func;
+    void print(Writer &out) const override {
+        out << "call " << func;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {Reg::a0, Reg::a1, Reg::a2, Reg::a3,
                 Reg::a4, Reg::a5, Reg::a6, Reg::a7};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         // 调用者保存寄存器和返回值寄存器
         return {Reg::ra, Reg::t0, Reg::t1, Reg::t2, Reg::t3, Reg::t4,
                 Reg::t5, Reg::t6, Reg::a0, Reg::a1, Reg::a2, Reg::a3,
@@ -564,23 +712,23 @@ public:
 };
 
 class Ret;
-using RetPtr = std::shared_ptr<Ret>;
-class Ret : public Inst {
+using RetPtr = Ret *;
+class Ret : public InstOf<Opcode::Ret> {
 public:
     Ret() {
     }
     static RetPtr create() {
-        return std::make_shared<Ret>();
+        return InstPool::current().create<Ret>();
     }
 
-    std::string to_string() const override {
-        return "ret";
+    void print(Writer &out) const override {
+        out << "ret";
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {Reg::a0, Reg::ra}; // 返回值寄存器和返回地址
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -591,8 +739,8 @@ public:
 
 // 标签
 class Label;
-using LabelPtr = std::shared_ptr<Label>;
-class Label : public Inst {
+using LabelPtr = Label *;
+class Label : public InstOf<Opcode::Label> {
 public:
     std::string label;
 
@@ -600,17 +748,17 @@ public:
         label(label) {
     }
     static LabelPtr create(std::string label) {
-        return std::make_shared<Label>(label);
+        return InstPool::current().create<Label>(label);
     }
 
-    std::string to_string() const override {
-        return label + ":";
+    void print(Writer &out) const override {
+        out << label << ':';
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -620,8 +768,8 @@ public:
 };
 
 class GlobalLabel;
-using GlobalLabelPtr = std::shared_ptr<GlobalLabel>;
-class GlobalLabel : public Inst {
+using GlobalLabelPtr = GlobalLabel *;
+class GlobalLabel : public InstOf<Opcode::GlobalLabel> {
 public:
     std::string label;
 
@@ -629,17 +777,17 @@ public:
         label(label) {
     }
     static GlobalLabelPtr create(std::string label) {
-        return std::make_shared<GlobalLabel>(label);
+        return InstPool::current().create<GlobalLabel>(label);
     }
 
-    std::string to_string() const override {
-        return ".globl " + label;
+    void print(Writer &out) const override {
+        out << ".globl " << label;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -650,8 +798,8 @@ public:
 
 // 函数入口
 class Function;
-using FunctionPtr = std::shared_ptr<Function>;
-class Function : public Inst {
+using FunctionPtr = Function *;
+class Function : public InstOf<Opcode::Function> {
 public:
     std::string function;
 
@@ -659,17 +807,17 @@ public:
         function(function) {
     }
     static FunctionPtr create(std::string function) {
-        return std::make_shared<Function>(function);
+        return InstPool::current().create<Function>(function);
     }
 
-    std::string to_string() const override {
-        return function + ":";
+    void print(Writer &out) const override {
+        out << function << ':';
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -680,8 +828,8 @@ public:
 
 // .zero 指令
 class Zero;
-using ZeroPtr = std::shared_ptr<Zero>;
-class Zero : public Inst {
+using ZeroPtr = Zero *;
+class Zero : public InstOf<Opcode::Zero> {
 public:
     int size;
 
@@ -689,17 +837,17 @@ public:
         size(size) {
     }
     static ZeroPtr create(int size) {
-        return std::make_shared<Zero>(size);
+        return InstPool::current().create<Zero>(size);
     }
 
-    std::string to_string() const override {
-        return ".zero " + std::to_string(size);
+    void print(Writer &out) const override {
+        out << ".zero " << size;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -710,8 +858,8 @@ public:
 
 // .word 指令
 class Word;
-using WordPtr = std::shared_ptr<Word>;
-class Word : public Inst {
+using WordPtr = Word *;
+class Word : public InstOf<Opcode::Word> {
 public:
     int value;
 
@@ -719,17 +867,17 @@ public:
         value(value) {
     }
     static WordPtr create(int value) {
-        return std::make_shared<Word>(value);
+        return InstPool::current().create<Word>(value);
     }
 
-    std::string to_string() const override {
-        return ".word " + std::to_string(value);
+    void print(Writer &out) const override {
+        out << ".word " << value;
     }
 
-    std::set<Reg> get_uses() const override {
+    RegSet get_uses() const override {
         return {};
     }
-    std::set<Reg> get_defs() const override {
+    RegSet get_defs() const override {
         return {};
     }
     void replace_uses(const RegMap &reg_map) override {
@@ -738,19 +886,22 @@ public:
     }
 };
 
-using Code = std::list<InstPtr>;
+using Code = IList<Inst>;
+
+/// @brief inserts instructions into a Code list at an insertion point
+using Builder = InstBuilder<Inst>;
 
 } // namespace ASM
 
-inline std::ostream &operator<<(std::ostream &os, const ASM::Code &code) {
+inline Writer &operator<<(Writer &out, const ASM::Code &code) {
     for (const auto &inst : code) {
-        if (auto label = std::dynamic_pointer_cast<ASM::Label>(inst)) {
-            os << label->to_string() << std::endl;
-        } else {
-            os << "    " << inst->to_string() << std::endl;
+        if (inst->opcode != ASM::Opcode::Label && inst->opcode != ASM::Opcode::Function) {
+            out << "    ";
         }
+        inst->print(out);
+        out << '\n';
     }
-    return os;
+    return out;
 }
 
 #endif // CODEGEN_ASM_HPP
\ No newline at end of file
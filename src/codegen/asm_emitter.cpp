@@ -1,7 +1,30 @@
 #include "asm_emitter.hpp"
 #include <algorithm>
 
+#include "support/statistics.hpp"
+
 void ASMEmitter::emit(const Module &mod) {
+    emitData(mod);
+    for (const auto &func : mod.functions) {
+        emit(func);
+    }
+}
+
+void ASMEmitter::emitData(const Module &mod) {
+    emitPrelude();
+
+    // 添加 .data 段
+    output << "    .data\n";
+
+    for (const auto &global : mod.globals) {
+        emit(global);
+    }
+
+    // 添加 .text 段
+    output << "\n    .text\n";
+}
+
+void ASMEmitter::emitPrelude() {
     // 添加 Venus 的 read 和 write 系统调用
     if (use_venus) {
         output << R"(
@@ -21,24 +44,12 @@ write:
 
 )";
     }
-
-    // 添加 .data 段
-    output << "    " << ".data" << std::endl;
-
-    for (const auto &global : mod.globals) {
-        emit(global);
-    }
-
-    // 添加 .text 段
-    output << std::endl
-           << "    " << ".text" << std::endl;
-    for (const auto &func : mod.functions) {
-        emit(func);
-    }
 }
 
 void ASMEmitter::emit(const FunctionPtr &func) {
     current_func = func; // 设置当前函数
+    emitted = expansions = 0;
+    InstPool::Scope scope(*func->pool); // prologue 和 epilogue 也放在函数的 pool 中
     int stack_size = func->temp_stack_size + func->reg_stack_size;
     reg_map = func->reg_map; // 设置当前函数的寄存器映射
 
@@ -51,9 +62,19 @@ void ASMEmitter::emit(const FunctionPtr &func) {
 
     // 添加 epilogue，处理 sp, ra, fp 等寄存器
     emitEpilogue(func->blocks.back());
+
+    if (Statistics::global().is_enabled()) {
+        auto &stats = Statistics::global();
+        stats.add(func->name, "asm.insts", emitted);
+        stats.add(func->name, "asm.imm_expansions", expansions);
+        stats.add(func->name, "frame.bytes", func->temp_stack_size + func->reg_stack_size);
+    }
 }
 
 void ASMEmitter::emit(const IR::GlobalPtr &global) {
+    // 全局变量的指令输出后就不再需要，用一个临时 pool 存放
+    InstPool pool;
+    InstPool::Scope scope(pool);
     auto code = selectGlobal(global);
     for (const auto &inst : code) {
         emit(inst);
@@ -69,11 +90,14 @@ void ASMEmitter::emit(const BasicBlockPtr &block) {
 
 void ASMEmitter::emitEpilogue(const BasicBlockPtr &block) {
     // label
-    output << block->label << ":" << std::endl;
+    output << block->label << ":\n";
     ASM::Code code;
-    auto node = std::dynamic_pointer_cast<IR::Return>(block->ir_code.back());
+    auto node = IR::dyn_cast<IR::Return>(block->ir_code.back());
     if (!node->x.empty()) {
-        code.push_back(ASM::Mv::create(ASM::Reg::a0, ASM::Reg(node->x)));
+        // cfg builder 已经把返回值放在 a0 中
+        ASM::Reg ret_reg = ASM::Reg::a0;
+        ASM::Reg::lookup(node->x.to_string(), ret_reg);
+        code.push_back(ASM::Mv::create(ASM::Reg::a0, ret_reg));
     }
 
     // Epilogue - 函数退出栈帧清理
@@ -93,82 +117,101 @@ void ASMEmitter::emitEpilogue(const BasicBlockPtr &block) {
     for (const auto &inst : code) {
         emit(inst);
     }
-    output << std::endl;
+    output << '\n';
 }
 
 void ASMEmitter::emit(const ASM::InstPtr &inst) {
     inst->replace_all(reg_map);
-    if (type_of<ASM::Label>(inst) || type_of<ASM::Function>(inst)) {
-        output << inst->to_string() << std::endl;
-        if (type_of<ASM::Function>(inst)) {
-            // Prologue - 函数入口栈帧设置
-            fp_offset = current_func->alloc_temp(4, ASM::Reg::fp); // 为帧指针分配空间
-            ra_offset = current_func->alloc_temp(4, ASM::Reg::ra); // 为返回地址分配空间
-
-            // 1. 调整栈指针，为栈帧分配空间
-            int stack_size = current_func->temp_stack_size + current_func->reg_stack_size;
-            ASM::Code code;
-            code.push_back(ASM::ArithImm::create(ASM::Reg::sp, ASM::Reg::sp, -stack_size, ASM::ArithImm::Op::Addi));
-
-            // 2. 保存返回地址和帧指针
-            code.push_back(ASM::Store::create(ASM::Reg::sp, ASM::Reg::ra, ra_offset)); // ra 保存到 sp + stack_size - 4
-            code.push_back(ASM::Store::create(ASM::Reg::sp, ASM::Reg::fp, fp_offset)); // fp 保存到 sp + stack_size - 8
-
-            // 3. 设置帧指针
-            code.push_back(ASM::ArithImm::create(ASM::Reg::fp, ASM::Reg::sp, stack_size, ASM::ArithImm::Op::Addi));
-
-            // 输出 prologue 指令
+    ASM::Code code;
+    switch (inst->opcode) {
+    case ASM::Opcode::Label:
+        print(inst);
+        break;
+    case ASM::Opcode::Function: {
+        print(inst);
+        // Prologue - 函数入口栈帧设置
+        fp_offset = current_func->alloc_temp(4, ASM::Reg::fp); // 为帧指针分配空间
+        ra_offset = current_func->alloc_temp(4, ASM::Reg::ra); // 为返回地址分配空间
+
+        // 1. 调整栈指针，为栈帧分配空间
+        int stack_size = current_func->temp_stack_size + current_func->reg_stack_size;
+        code.push_back(ASM::ArithImm::create(ASM::Reg::sp, ASM::Reg::sp, -stack_size, ASM::ArithImm::Op::Addi));
+
+        // 2. 保存返回地址和帧指针
+        code.push_back(ASM::Store::create(ASM::Reg::sp, ASM::Reg::ra, ra_offset)); // ra 保存到 sp + stack_size - 4
+        code.push_back(ASM::Store::create(ASM::Reg::sp, ASM::Reg::fp, fp_offset)); // fp 保存到 sp + stack_size - 8
+
+        // 3. 设置帧指针
+        code.push_back(ASM::ArithImm::create(ASM::Reg::fp, ASM::Reg::sp, stack_size, ASM::ArithImm::Op::Addi));
+
+        // 输出 prologue 指令
+        for (const auto &p : code) {
+            emit(p);
+        }
+        break;
+    }
+    // 检查是否有过大的立即数
+    case ASM::Opcode::ArithImm: {
+        auto arith_inst = static_cast<ASM::ArithImm *>(inst);
+        if (arith_inst->imm < -2048 || arith_inst->imm > 2047) {
+            expansions++;
+            ASM::Reg temp_reg = ASM::Reg::t4; // 使用除了t0,t1,t2外一个临时寄存器
+            code.push_back(ASM::Li::create(ASM::Reg(temp_reg), arith_inst->imm));
+            code.push_back(ASM::Arith::create(arith_inst->rd, arith_inst->rs1, temp_reg, static_cast<ASM::Arith::Op>(arith_inst->op)));
+
             for (const auto &p : code) {
                 emit(p);
             }
-        }
-    } else {
-        // 检查是否有过大的立即数
-        ASM::Code code;
-        if (type_of<ASM::ArithImm>(inst)) {
-            auto arith_inst = std::dynamic_pointer_cast<ASM::ArithImm>(inst);
-            if (arith_inst->imm < -2048 || arith_inst->imm > 2047) {
-                ASM::Reg temp_reg = ASM::Reg::t4; // 使用除了t0,t1,t2外一个临时寄存器
-                code.push_back(ASM::Li::create(ASM::Reg(temp_reg), arith_inst->imm));
-                code.push_back(ASM::Arith::create(arith_inst->rd, arith_inst->rs1, temp_reg, static_cast<ASM::Arith::Op>(arith_inst->op)));
-
-                for (const auto &p : code) {
-                    emit(p);
-                }
-            } else
-                output << "    " << inst->to_string() << std::endl;
-        } else if (type_of<ASM::Store>(inst)) {
-            auto store_inst = std::dynamic_pointer_cast<ASM::Store>(inst);
-            if (store_inst->offset < -2048 || store_inst->offset > 2047) {
-                ASM::Reg temp_reg = ASM::Reg::t4; // 使用除了t0,t1,t2外一个临时寄存器
-                code.push_back(ASM::Li::create(ASM::Reg(temp_reg), store_inst->offset));
-                code.push_back(ASM::Arith::create(temp_reg, store_inst->rs1, temp_reg, ASM::Arith::Op::Add));
-                code.push_back(ASM::Store::create(temp_reg, store_inst->rs2, 0));
-
-                for (const auto &p : code) {
-                    emit(p);
-                }
-            } else
-                output << "    " << inst->to_string() << std::endl;
-        } else if (type_of<ASM::Load>(inst)) {
-            auto load_inst = std::dynamic_pointer_cast<ASM::Load>(inst);
-            if (load_inst->offset < -2048 || load_inst->offset > 2047) {
-                ASM::Reg temp_reg = ASM::Reg::t4;
-                code.push_back(ASM::Li::create(temp_reg, load_inst->offset));
-                code.push_back(ASM::Arith::create(temp_reg, load_inst->rs1, temp_reg, ASM::Arith::Op::Add));
-                code.push_back(ASM::Load::create(load_inst->rd, temp_reg, 0));
-
-                for (const auto &p : code) {
-                    emit(p);
-                }
-            } else
-                output << "    " << inst->to_string() << std::endl;
-        }
+        } else
+            print(inst);
+        break;
+    }
+    case ASM::Opcode::Store: {
+        auto store_inst = static_cast<ASM::Store *>(inst);
+        if (store_inst->offset < -2048 || store_inst->offset > 2047) {
+            expansions++;
+            ASM::Reg temp_reg = ASM::Reg::t4; // 使用除了t0,t1,t2外一个临时寄存器
+            code.push_back(ASM::Li::create(ASM::Reg(temp_reg), store_inst->offset));
+            code.push_back(ASM::Arith::create(temp_reg, store_inst->rs1, temp_reg, ASM::Arith::Op::Add));
+            code.push_back(ASM::Store::create(temp_reg, store_inst->rs2, 0));
 
-        else {
-            output << "    " << inst->to_string() << std::endl;
-        }
+            for (const auto &p : code) {
+                emit(p);
+            }
+        } else
+            print(inst);
+        break;
+    }
+    case ASM::Opcode::Load: {
+        auto load_inst = static_cast<ASM::Load *>(inst);
+        if (load_inst->offset < -2048 || load_inst->offset > 2047) {
+            expansions++;
+            ASM::Reg temp_reg = ASM::Reg::t4;
+            code.push_back(ASM::Li::create(temp_reg, load_inst->offset));
+            code.push_back(ASM::Arith::create(temp_reg, load_inst->rs1, temp_reg, ASM::Arith::Op::Add));
+            code.push_back(ASM::Load::create(load_inst->rd, temp_reg, 0));
+
+            for (const auto &p : code) {
+                emit(p);
+            }
+        } else
+            print(inst);
+        break;
+    }
+    default:
+        print(inst);
+        break;
+    }
+}
+
+void ASMEmitter::print(const ASM::InstPtr &inst) {
+    // 标签和函数入口顶格，其余指令缩进
+    if (inst->opcode != ASM::Opcode::Label && inst->opcode != ASM::Opcode::Function) {
+        output << "    ";
+        emitted++;
     }
+    inst->print(output);
+    output << '\n';
 }
 
 ASM::Code ASMEmitter::selectGlobal(const IR::GlobalPtr &node) {
@@ -176,7 +219,7 @@ ASM::Code ASMEmitter::selectGlobal(const IR::GlobalPtr &node) {
     // GLOBAL x: #k -> x:, .zero k
     // GLOBAL x: #k = #v1, #v2, ... -> x:, .word v1, v2, ...
 
-    code.push_back(ASM::Label::create(node->name));
+    code.push_back(ASM::Label::create(node->name.str()));
 
     if (node->values.empty() || std::all_of(node->values.begin(), node->values.end(), [](int v) { return v == 0; })) {
         // 全零初始化，使用 .word 0 * k times
@@ -8,24 +8,33 @@
 
 class ASMEmitter {
 public:
-    ASMEmitter(bool use_venus = false, std::ostream &output = std::cout) :
+    ASMEmitter(Writer &output, bool use_venus = false) :
         use_venus(use_venus), output(output) {
     }
     void emit(const Module &mod);
+    /// @brief 输出函数之前的部分：Venus 的系统调用、.data 段和全局变量，以及 .text
+    void emitData(const Module &mod);
+    void emit(const FunctionPtr &func);
+    /// @brief Venus 的 read 和 write 系统调用，use_venus 时才输出
+    void emitPrelude();
+    void emit(const IR::GlobalPtr &global);
 
 private:
     bool use_venus;
-    std::ostream &output;
+    Writer &output;
     ASM::RegMap reg_map;
     FunctionPtr current_func;
     int fp_offset = 0; // Frame pointer offset
     int ra_offset = 0; // Return address offset
+    // --stats 的计数，每个函数输出完后计入
+    long emitted = 0;    // 输出的指令条数，不含标签
+    long expansions = 0; // 因立即数或偏移过大而展开的指令条数
 
-    void emit(const FunctionPtr &func);
-    void emit(const IR::GlobalPtr &global);
     void emit(const BasicBlockPtr &block);
     void emitEpilogue(const BasicBlockPtr &block);
     void emit(const ASM::InstPtr &inst);
+    /// @brief 输出一条指令，不再展开
+    void print(const ASM::InstPtr &inst);
 
     ASM::Code selectGlobal(const IR::GlobalPtr &node);
 };
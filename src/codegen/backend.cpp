@@ -0,0 +1,117 @@
+#include "backend.hpp"
+
+#include <algorithm>
+#include <optional>
+
+#include "codegen/asm_emitter.hpp"
+#include "codegen/inst_selector.hpp"
+#include "codegen/reg_allocator.hpp"
+#include "support/alloc_profile.hpp"
+#include "support/statistics.hpp"
+#include "support/thread_pool.hpp"
+#include "support/time_report.hpp"
+
+void Backend::compile(Module &mod) {
+    buffers.assign(mod.functions.size(), std::string());
+    pre_ra.assign(keep_pre_ra ? mod.functions.size() : 0, std::string());
+    if (jobs <= 1 || mod.functions.size() <= 1) {
+        for (size_t i = 0; i < mod.functions.size(); i++) {
+            compile(mod.functions[i], i);
+        }
+        return;
+    }
+
+    // 每个任务只写自己的 buffers[i] 和 pre_ra[i]，不需要加锁
+    ThreadPool pool(std::min<size_t>(jobs, mod.functions.size()));
+    for (size_t i = 0; i < mod.functions.size(); i++) {
+        pool.submit([this, &mod, i] { compile(mod.functions[i], i); });
+    }
+    pool.wait();
+}
+
+void Backend::compile(FunctionPtr &func, size_t index) {
+    // 选择器、分配器和输出器都带有当前函数的状态，每个函数各用一份
+    std::optional<TimeReport::Scope> timer(std::in_place, "select", func->name);
+    auto inst_selector = InstSelector();
+    inst_selector.select(func);
+    timer.reset();
+    if (Statistics::global().is_enabled()) {
+        Statistics::global().add(func->name, "asm.vregs", func->vreg_count);
+    }
+
+    if (keep_pre_ra) {
+        Writer dump(pre_ra[index]);
+        for (const auto &block : func->blocks) {
+            dump << block->asm_code;
+        }
+    }
+
+    timer.emplace("regalloc", func->name);
+    auto reg_allocator = RegAllocator();
+    reg_allocator.allocate(func);
+
+    timer.emplace("emit", func->name);
+    AllocProfile::Tag tag(AllocProfile::Category::Output);
+    Writer output(buffers[index]);
+    auto asm_emitter = ASMEmitter(output, use_venus);
+    asm_emitter.emit(func);
+}
+
+void Backend::write(const Module &mod, Writer &output) {
+    TimeReport::Scope timer("write");
+    AllocProfile::Tag tag(AllocProfile::Category::Output);
+    auto asm_emitter = ASMEmitter(output, use_venus);
+    asm_emitter.emitData(mod);
+    // 各函数的汇编已经格式化好，不再复制，由 writev 直接写出
+    for (const auto &buffer : buffers) {
+        output.append_ref(buffer);
+    }
+    output.flush();
+}
+
+void Backend::print_pre_ra(Writer &output) const {
+    for (const auto &dump : pre_ra) {
+        output << dump;
+    }
+}
+
+void Backend::stream(Module &mod, Writer &output) {
+    if (!mod.globals.empty()) {
+        switch_section(Section::Data, output);
+        TimeReport::Scope timer("write");
+        AllocProfile::Tag tag(AllocProfile::Category::Output);
+        auto asm_emitter = ASMEmitter(output, use_venus);
+        for (const auto &global : mod.globals) {
+            asm_emitter.emit(global);
+        }
+    }
+    if (!mod.functions.empty()) {
+        compile(mod);
+        switch_section(Section::Text, output);
+        TimeReport::Scope timer("write");
+        // 缓冲区会被下一个单元的 compile 覆盖，所以立即写出，不复制
+        for (const auto &buffer : buffers) {
+            output.append_ref(buffer);
+        }
+        output.flush();
+    }
+}
+
+void Backend::finish_stream(Writer &output) {
+    switch_section(Section::Text, output);
+    output.flush();
+}
+
+void Backend::switch_section(Section to, Writer &output) {
+    if (section == Section::None) {
+        // 第一次输出：与 write 一样先输出系统调用和 .data
+        auto asm_emitter = ASMEmitter(output, use_venus);
+        asm_emitter.emitPrelude();
+        output << "    .data\n";
+        section = Section::Data;
+    }
+    if (section != to) {
+        output << (to == Section::Data ? "\n    .data\n" : "\n    .text\n");
+        section = to;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef CODEGEN_BACKEND_HPP
+#define CODEGEN_BACKEND_HPP
+
+#include <string>
+#include <vector>
+
+#include "analysis/control_flow.hpp"
+#include "support/writer.hpp"
+
+/// @brief 后端：指令选择、寄存器分配和汇编输出
+/// 各个函数互不依赖，jobs > 1 时每个函数在线程池中独立完成这三步，
+/// 结果写入各自的缓冲区，最后按源码顺序拼接，输出与线程数无关
+class Backend {
+public:
+    /// @param keep_pre_ra 保留寄存器分配之前的汇编，供 print_pre_ra 输出
+    Backend(bool use_venus = false, unsigned jobs = 1, bool keep_pre_ra = false) :
+        use_venus(use_venus), jobs(jobs), keep_pre_ra(keep_pre_ra) {
+    }
+
+    /// @brief 为每个函数生成汇编，保存在缓冲区中
+    void compile(Module &mod);
+    /// @brief 输出数据段，再按源码顺序输出各函数的汇编，返回前写完
+    void write(const Module &mod, Writer &output);
+    /// @brief 按源码顺序输出各函数寄存器分配之前的汇编，使用虚拟寄存器
+    void print_pre_ra(Writer &output) const;
+
+    /// @brief 流式输出：编译 mod 并立即写出它的全局变量和函数，
+    /// 需要时在 .data 和 .text 之间切换；mod 随后即可释放
+    /// 全局变量都在函数之前时，输出与 compile 加 write 完全相同
+    void stream(Module &mod, Writer &output);
+    /// @brief 结束流式输出并 flush
+    void finish_stream(Writer &output);
+
+private:
+    bool use_venus;
+    unsigned jobs;
+    bool keep_pre_ra;
+    std::vector<std::string> buffers; // 与 mod.functions 一一对应
+    std::vector<std::string> pre_ra;  // 同上，只在 keep_pre_ra 时填写
+    // 流式输出当前所在的段
+    enum class Section { None, Data, Text } section = Section::None;
+
+    /// @brief 流式输出时切换到 to 段
+    void switch_section(Section to, Writer &output);
+
+    void compile(FunctionPtr &func, size_t index);
+};
+
+#endif // CODEGEN_BACKEND_HPP
@@ -20,28 +20,30 @@ void InstSelector::select(FunctionPtr &func) {
     // 设置当前函数
     // 如果是 DEC，需要调用当前函数中的 alloc_temp，在栈上分配空间
     current_func = func;
+    InstPool::Scope scope(*func->pool); // 汇编指令和 IR 放在同一个 pool 中
+    temp_regs.clear();
+    name_regs.clear();
     for (auto &block : func->blocks) {
-        block->asm_code = select(block->ir_code);
+        // 指令直接生成到 block 的 asm_code 末尾
+        builder.set_insert_point(block->asm_code);
+        select(block->ir_code);
     }
 }
 
-ASM::Code InstSelector::select(const IR::Code &ir_code) {
-    ASM::Code asm_code;
+void InstSelector::select(const IR::Code &ir_code) {
     for (const auto &node : ir_code) {
-        auto code = select(node);
-        asm_code.insert(asm_code.end(), code.begin(), code.end());
+        select(node);
     }
-    return asm_code;
 }
 
-ASM::Code InstSelector::select(const IR::NodePtr &node) {
-#define SELECT_NODE(type)                                     \
-    if (auto p = std::dynamic_pointer_cast<IR::type>(node)) { \
-        return select##type(p);                               \
-    }
+void InstSelector::select(const IR::NodePtr &node) {
+#define SELECT_NODE(type)   \
+    case IR::Opcode::type: \
+        return select##type(static_cast<IR::type *>(node));
 
-    // 对于每种不同类型的 IR 节点，调用相应的 select 函数
+    // 对于每种不同类型的 IR 节点，按 opcode 调用相应的 select 函数
     // 如果你添加了新的 IR 节点类型，记得在这里添加对应的 select 函数
+    switch (node->opcode) {
     SELECT_NODE(LoadAddr)
     SELECT_NODE(Dec)
     SELECT_NODE(Store)
@@ -58,98 +60,104 @@ ASM::Code InstSelector::select(const IR::NodePtr &node) {
     SELECT_NODE(Arg)
     SELECT_NODE(Return)
     SELECT_NODE(If)
+    default:
+        break;
+    }
 
 #warning Add more IR node types if needed
 
     assert(false && "Unknown IR node type");
 }
 
-ASM::Code InstSelector::selectLoadImm(const IR::LoadImmPtr &node) {
-    ASM::Code code;
+ASM::Reg InstSelector::reg(const IR::Operand &operand) {
+    if (operand.is_temp()) {
+        auto it = temp_regs.find(operand.value());
+        if (it == temp_regs.end()) {
+            it = temp_regs.emplace(operand.value(), ASM::Reg::virt(current_func->vreg_count++)).first;
+        }
+        return it->second;
+    }
+    assert(operand.is_name() && "Operand has no register");
+    auto it = name_regs.find(operand.ident());
+    if (it == name_regs.end()) {
+        ASM::Reg phys;
+        if (!ASM::Reg::lookup(operand.ident().str(), phys)) {
+            phys = ASM::Reg::virt(current_func->vreg_count++);
+        }
+        it = name_regs.emplace(operand.ident(), phys).first;
+    }
+    return it->second;
+}
+
+void InstSelector::selectLoadImm(const IR::LoadImmPtr &node) {
     // a = #t	-> li reg(a), t
-    code.push_back(ASM::Li::create(ASM::Reg(node->x), node->k));
-    return code;
+    builder.emit<ASM::Li>(reg(node->x), node->k);
 }
 
-ASM::Code InstSelector::selectAssign(const IR::AssignPtr &node) {
-    ASM::Code code;
+void InstSelector::selectAssign(const IR::AssignPtr &node) {
     // a = b	-> mv reg(a), reg(b)
-    code.push_back(ASM::Mv::create(ASM::Reg(node->x), ASM::Reg(node->y)));
-    return code;
+    builder.emit<ASM::Mv>(reg(node->x), reg(node->y));
 }
 
-ASM::Code InstSelector::selectBinary(const IR::BinaryPtr &node) {
-    ASM::Code code;
+void InstSelector::selectBinary(const IR::BinaryPtr &node) {
     // a = b + c	-> add reg(a), reg(b), reg(c)
     // a = b + #num -> addi reg(a), reg(b), t
-    if (node->y[0] == '#' || node->z[0] == '#') {
+    if (node->y.is_imm() || node->z.is_imm()) {
         // 如果是加法或者减法：
         //  立即数操作
         if (node->op == BinaryOp::Add || node->op == BinaryOp::Sub) {
-            if (node->y[0] == '#') {
+            if (node->y.is_imm()) {
                 // b 是立即数
-                int num = std::stoi(node->y.substr(1));
-                code.push_back(ASM::ArithImm::create(
-                    ASM::Reg(node->x), ASM::Reg(node->z), num, static_cast<ASM::ArithImm::Op>(node->op)));
+                int num = node->y.value();
+                builder.emit<ASM::ArithImm>(
+                    reg(node->x), reg(node->z), num, static_cast<ASM::ArithImm::Op>(node->op));
             } else {
                 // c 是立即数
-                int num = std::stoi(node->z.substr(1));
-                code.push_back(ASM::ArithImm::create(
-                    ASM::Reg(node->x), ASM::Reg(node->y), num, static_cast<ASM::ArithImm::Op>(node->op)));
+                int num = node->z.value();
+                builder.emit<ASM::ArithImm>(
+                    reg(node->x), reg(node->y), num, static_cast<ASM::ArithImm::Op>(node->op));
             }
         } else {
-            code.push_back(ASM::Li::create(ASM::Reg::t0, std::stoi(node->z.substr(1))));
-            code.push_back(ASM::Arith::create(
-                ASM::Reg(node->x), ASM::Reg(node->y), ASM::Reg::t0, static_cast<ASM::Arith::Op>(node->op)));
+            builder.emit<ASM::Li>(ASM::Reg::t0, node->z.value());
+            builder.emit<ASM::Arith>(
+                reg(node->x), reg(node->y), ASM::Reg::t0, static_cast<ASM::Arith::Op>(node->op));
         }
     } else {
-        code.push_back(ASM::Arith::create(
-            ASM::Reg(node->x), ASM::Reg(node->y), ASM::Reg(node->z), static_cast<ASM::Arith::Op>(node->op)));
+        builder.emit<ASM::Arith>(
+            reg(node->x), reg(node->y), reg(node->z), static_cast<ASM::Arith::Op>(node->op));
     }
-    return code;
 }
 
-ASM::Code InstSelector::selectUnary(const IR::UnaryPtr &node) {
-    ASM::Code code;
+void InstSelector::selectUnary(const IR::UnaryPtr &node) {
     // a = -b	-> sub reg(a), zero, reg(b)
 
-    code.push_back(ASM::Arith::create(
-        ASM::Reg(node->x), ASM::Reg::zero, ASM::Reg(node->y), static_cast<ASM::Arith::Op>(node->op)));
-    return code;
+    builder.emit<ASM::Arith>(
+        reg(node->x), ASM::Reg::zero, reg(node->y), static_cast<ASM::Arith::Op>(node->op));
 }
 
-ASM::Code InstSelector::selectLabel(const IR::LabelPtr &node) {
-    ASM::Code code;
+void InstSelector::selectLabel(const IR::LabelPtr &node) {
     // LABEL label:	-> label:
 
-    code.push_back(ASM::Label::create(node->label));
-    return code;
+    builder.emit<ASM::Label>(node->label.str());
 }
 
-ASM::Code InstSelector::selectGoto(const IR::GotoPtr &node) {
-    ASM::Code code;
+void InstSelector::selectGoto(const IR::GotoPtr &node) {
     // GOTO label	-> j label
 
-    code.push_back(ASM::Jump::create(node->label));
-    return code;
+    builder.emit<ASM::Jump>(node->label.str());
 }
 
-ASM::Code InstSelector::selectFunction(const IR::FunctionPtr &node) {
-    ASM::Code code;
+void InstSelector::selectFunction(const IR::FunctionPtr &node) {
     // FUNCTION func:	-> func:
     // FUNCTION func:	-> func:
 
     // 函数标签
-    code.push_back(ASM::GlobalLabel::create(node->name));
-    code.push_back(ASM::Function::create(node->name));
-
-    return code;
+    builder.emit<ASM::GlobalLabel>(node->name.str());
+    builder.emit<ASM::Function>(node->name.str());
 }
 
 // 修改 selectCall 以处理调用者的栈帧管理
-ASM::Code InstSelector::selectCall(const IR::CallPtr &node) {
-    ASM::Code code;
-
+void InstSelector::selectCall(const IR::CallPtr &node) {
     // 调用者需要保存临时寄存器（如果使用了的话）
     // 这里保存 t0-t2（根据实际使用情况可以优化）
     std::vector<ASM::Reg> caller_saved_regs = {ASM::Reg::t0, ASM::Reg::t1, ASM::Reg::t2};
@@ -158,176 +166,132 @@ ASM::Code InstSelector::selectCall(const IR::CallPtr &node) {
     for (const auto &reg : caller_saved_regs) {
         // 为每个需要保存的寄存器分配栈空间
         int offset = current_func->alloc_temp(4, reg);
-        code.push_back(ASM::Store::create(ASM::Reg::sp, reg, offset));
+        builder.emit<ASM::Store>(ASM::Reg::sp, reg, offset);
         saved_count++;
     }
 
     // 调用函数
-    code.push_back(ASM::Call::create(node->func));
+    builder.emit<ASM::Call>(node->func.str());
 
     // 如果有返回值，将其从 a0 移动到目标寄存器
     if (!node->x.empty()) {
-        code.push_back(ASM::Mv::create(ASM::Reg(node->x), ASM::Reg::a0));
+        builder.emit<ASM::Mv>(reg(node->x), ASM::Reg::a0);
     }
 
     // 恢复临时寄存器
     for (const auto &reg : caller_saved_regs) {
-        int offset = current_func->temp_offset[reg]; // 获取之前分配的偏移
-        code.push_back(ASM::Load::create(reg, ASM::Reg::sp, offset));
+        int offset = current_func->temp_offset[reg.id]; // 获取之前分配的偏移
+        builder.emit<ASM::Load>(reg, ASM::Reg::sp, offset);
     }
-
-    return code;
 }
 
-ASM::Code InstSelector::selectArg(const IR::ArgPtr &node) {
-    ASM::Code code;
-
+void InstSelector::selectArg(const IR::ArgPtr &node) {
     if (node->k < 8) {
         // 前8个参数放入寄存器 a0-a7
-        code.push_back(ASM::Mv::create(ASM::Reg("a" + std::to_string(node->k)), ASM::Reg(node->x)));
+        builder.emit<ASM::Mv>(ASM::Reg::arg(node->k), reg(node->x));
     } else {
         // 超过8个参数的部分需要存储到调用者的栈帧中
         // 这需要在调用前为参数分配栈空间
-        int offset = current_func->alloc_temp(4, ASM::Reg(node->x));
-        code.push_back(ASM::Store::create(ASM::Reg::sp, ASM::Reg(node->x), offset));
+        int offset = current_func->alloc_temp(4, reg(node->x));
+        builder.emit<ASM::Store>(ASM::Reg::sp, reg(node->x), offset);
     }
-
-    return code;
 }
 
 // 添加 Param 指令的处理
-ASM::Code InstSelector::selectParam(const IR::ParamPtr &node) {
-    ASM::Code code;
+void InstSelector::selectParam(const IR::ParamPtr &node) {
     // PARAM x -> mv reg(x), ak
     // 从参数寄存器中读取参数到虚拟寄存器
 
     if (node->k < 8) {
         // 前8个参数从寄存器 a0-a7 中读取
-        code.push_back(ASM::Mv::create(ASM::Reg(node->x), ASM::Reg("a" + std::to_string(node->k))));
+        builder.emit<ASM::Mv>(reg(node->x), ASM::Reg::arg(node->k));
     } else {
         // 超过8个参数的部分从栈中读取
         int offset = 4 * (node->k - 8); // 每个参数4字节
-        code.push_back(ASM::Load::create(ASM::Reg(node->x), ASM::Reg::fp, offset));
+        builder.emit<ASM::Load>(reg(node->x), ASM::Reg::fp, offset);
     }
-
-    return code;
 }
 
 // 修改 selectReturn 以处理函数返回
-ASM::Code InstSelector::selectReturn(const IR::ReturnPtr &node) {
-    ASM::Code code;
-
+void InstSelector::selectReturn(const IR::ReturnPtr &node) {
     // 已经在 cfg builder 中统一为一个 exit call
     // 因此只有 exit block 里有 return 语句
     // 在 asm emitter 中对每个函数处理时
     // 会忽略 exit block 并添加 epilogue
     // 因此这里不需要处理
-
-    // 如果有返回值，将其移动到 a0
-    // if (!node->x.empty()) {
-    //     code.push_back(ASM::Mv::create(ASM::Reg::a0, ASM::Reg(node->x)));
-    // }
-
-    // // Epilogue - 函数退出栈帧清理
-    // // 1. 恢复返回地址和帧指针
-    // code.push_back(ASM::Load::create(ASM::Reg::ra, ASM::Reg::sp, 12));
-    // code.push_back(ASM::Load::create(ASM::Reg::fp, ASM::Reg::sp, 8));
-
-    // // 2. 调整栈指针，释放栈帧空间
-    // code.push_back(ASM::ArithImm::create(ASM::Reg::sp, ASM::Reg::sp, 16, ASM::ArithImm::Op::Addi));
-
-    // // 3. 返回
-    // code.push_back(ASM::Ret::create());
-
-    return code;
 }
 
-ASM::Code InstSelector::selectIf(const IR::IfPtr &node) {
-    ASM::Code code;
+void InstSelector::selectIf(const IR::IfPtr &node) {
     // IF x op y GOTO label -> branch_op reg(x), reg(y), label
 
     switch (node->op) {
     case BinaryOp::Gt:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Bgt));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Bgt);
         break;
     case BinaryOp::Lt:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Blt));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Blt);
         break;
     case BinaryOp::Ge:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Bge));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Bge);
         break;
     case BinaryOp::Le:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Ble));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Ble);
         break;
     case BinaryOp::Eq:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Beq));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Beq);
         break;
     case BinaryOp::Ne:
-        code.push_back(ASM::Branch::create(ASM::Reg(node->t1), ASM::Reg(node->t2), node->label, ASM::Branch::Op::Bne));
+        builder.emit<ASM::Branch>(reg(node->t1), reg(node->t2), node->label.str(), ASM::Branch::Op::Bne);
         break;
     default:
         assert(false && "Unsupported branch operation");
     }
-
-    return code;
 }
 
-ASM::Code InstSelector::selectDec(const IR::DecPtr &node) {
-    ASM::Code code;
+void InstSelector::selectDec(const IR::DecPtr &node) {
     // DEC x #k -> 在栈上分配 k 个字节，将起始地址存入 x
 
     int offset = current_func->alloc_dec(node->size);
 
     // 计算栈上地址：sp + offset
     // addi reg(x), sp, offset
-    code.push_back(ASM::ArithImm::create(ASM::Reg(node->name), ASM::Reg::sp, offset, ASM::ArithImm::Op::Addi));
-
-    return code;
+    builder.emit<ASM::ArithImm>(reg(node->name), ASM::Reg::sp, offset, ASM::ArithImm::Op::Addi);
 }
 
-ASM::Code InstSelector::selectLoadAddr(const IR::LoadAddrPtr &node) {
-    ASM::Code code;
+void InstSelector::selectLoadAddr(const IR::LoadAddrPtr &node) {
     // x = &y -> la reg(x), y
 
-    code.push_back(ASM::La::create(ASM::Reg(node->x), node->label));
-
-    return code;
+    builder.emit<ASM::La>(reg(node->x), node->label.str());
 }
 
-ASM::Code InstSelector::selectStore(const IR::StorePtr &node) {
-    ASM::Code code;
+void InstSelector::selectStore(const IR::StorePtr &node) {
     // *x = y -> sw reg(y), 0(reg(x))
     // *(x + #k) = y -> sw reg(y), k(reg(x))
 
     // 检查偏移量是否在12位立即数范围内 (-2048 到 2047)
     if (node->offset >= -2048 && node->offset <= 2047) {
-        code.push_back(ASM::Store::create(ASM::Reg(node->addr), ASM::Reg(node->value), node->offset));
+        builder.emit<ASM::Store>(reg(node->addr), reg(node->value), node->offset);
     } else {
         // 偏移量超出范围，需要先计算地址
         ASM::Reg temp_reg = ASM::Reg::t0; // 使用一个临时寄存器
-        code.push_back(ASM::Li::create(ASM::Reg(temp_reg), node->offset));
-        code.push_back(ASM::Arith::create(ASM::Reg(temp_reg), ASM::Reg(node->addr), ASM::Reg(temp_reg), ASM::Arith::Op::Add));
-        code.push_back(ASM::Store::create(ASM::Reg(temp_reg), ASM::Reg(node->value), 0));
+        builder.emit<ASM::Li>(ASM::Reg(temp_reg), node->offset);
+        builder.emit<ASM::Arith>(ASM::Reg(temp_reg), reg(node->addr), ASM::Reg(temp_reg), ASM::Arith::Op::Add);
+        builder.emit<ASM::Store>(ASM::Reg(temp_reg), reg(node->value), 0);
     }
-
-    return code;
 }
 
-ASM::Code InstSelector::selectLoad(const IR::LoadPtr &node) {
-    ASM::Code code;
+void InstSelector::selectLoad(const IR::LoadPtr &node) {
     // x = *y -> lw reg(x), 0(reg(y))
     // x = *(y + #k) -> lw reg(x), k(reg(y))
 
     // 检查偏移量是否在12位立即数范围内 (-2048 到 2047)
     if (node->offset >= -2048 && node->offset <= 2047) {
-        code.push_back(ASM::Load::create(ASM::Reg(node->x), ASM::Reg(node->addr), node->offset));
+        builder.emit<ASM::Load>(reg(node->x), reg(node->addr), node->offset);
     } else {
         // 偏移量超出范围，需要先计算地址
         ASM::Reg temp_reg = ASM::Reg::t0; // 使用一个临时寄存器
-        code.push_back(ASM::Li::create(ASM::Reg(temp_reg), node->offset));
-        code.push_back(ASM::Arith::create(ASM::Reg(temp_reg), ASM::Reg(node->addr), ASM::Reg(temp_reg), ASM::Arith::Op::Add));
-        code.push_back(ASM::Load::create(ASM::Reg(node->x), ASM::Reg(temp_reg), 0));
+        builder.emit<ASM::Li>(ASM::Reg(temp_reg), node->offset);
+        builder.emit<ASM::Arith>(ASM::Reg(temp_reg), reg(node->addr), ASM::Reg(temp_reg), ASM::Arith::Op::Add);
+        builder.emit<ASM::Load>(reg(node->x), ASM::Reg(temp_reg), 0);
     }
-
-    return code;
 }
\ No newline at end of file
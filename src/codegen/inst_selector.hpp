@@ -3,6 +3,8 @@
 
 class ASMEmitter;
 
+#include <unordered_map>
+
 #include "analysis/control_flow.hpp"
 #include "asm.hpp"
 #include "ir/ir.hpp"
@@ -10,31 +12,41 @@ class ASMEmitter;
 class InstSelector {
  public:
   void select(Module &mod);
+  void select(FunctionPtr &func);
 
  private:
   std::string func_name;
   FunctionPtr current_func;
-  void select(FunctionPtr &func);
-  ASM::Code select(const IR::Code &ir_code);
-  ASM::Code select(const IR::NodePtr &node);
-  ASM::Code selectLoadImm(const IR::LoadImmPtr &node);
-  ASM::Code selectAssign(const IR::AssignPtr &node);
-  ASM::Code selectBinary(const IR::BinaryPtr &node);
-  ASM::Code selectUnary(const IR::UnaryPtr &node);
-  ASM::Code selectLabel(const IR::LabelPtr &node);
-  ASM::Code selectGoto(const IR::GotoPtr &node);
-  ASM::Code selectFunction(const IR::FunctionPtr &node);
-  ASM::Code selectCall(const IR::CallPtr &node);
-  ASM::Code selectArg(const IR::ArgPtr &node);
-  ASM::Code selectReturn(const IR::ReturnPtr &node); 
-  ASM::Code selectIf(const IR::IfPtr &node);
-  ASM::Code selectGlobal(const IR::GlobalPtr &node);
-  ASM::Code selectDec(const IR::DecPtr &node);
-  ASM::Code selectLoadAddr(const IR::LoadAddrPtr &node);
-  ASM::Code selectStore(const IR::StorePtr &node);
-  ASM::Code selectLoad(const IR::LoadPtr &node);
-
-  ASM::Code selectParam(const IR::ParamPtr &node);
+  void select(const IR::Code &ir_code);
+  void select(const IR::NodePtr &node);
+  void selectLoadImm(const IR::LoadImmPtr &node);
+  void selectAssign(const IR::AssignPtr &node);
+  void selectBinary(const IR::BinaryPtr &node);
+  void selectUnary(const IR::UnaryPtr &node);
+  void selectLabel(const IR::LabelPtr &node);
+  void selectGoto(const IR::GotoPtr &node);
+  void selectFunction(const IR::FunctionPtr &node);
+  void selectCall(const IR::CallPtr &node);
+  void selectArg(const IR::ArgPtr &node);
+  void selectReturn(const IR::ReturnPtr &node); 
+  void selectIf(const IR::IfPtr &node);
+  void selectGlobal(const IR::GlobalPtr &node);
+  void selectDec(const IR::DecPtr &node);
+  void selectLoadAddr(const IR::LoadAddrPtr &node);
+  void selectStore(const IR::StorePtr &node);
+  void selectLoad(const IR::LoadPtr &node);
+
+  void selectParam(const IR::ParamPtr &node);
+
+  /// @brief 操作数对应的寄存器
+  /// 每个函数内按首次出现的顺序给 temp 和变量编号虚拟寄存器，
+  /// 名字恰好是物理寄存器（如 a0）的变量直接映射到物理寄存器
+  ASM::Reg reg(const IR::Operand &operand);
+
+  /// @brief 插入点在当前 block 的 asm_code 末尾
+  ASM::Builder builder;
+  std::unordered_map<int, ASM::Reg> temp_regs;
+  std::unordered_map<Ident, ASM::Reg> name_regs;
 };
 
 #endif  // CODEGEN_INST_SELECTOR_HPP
\ No newline at end of file
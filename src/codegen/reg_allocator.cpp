@@ -1,8 +1,11 @@
 #include "reg_allocator.hpp"
 
 #include <cassert>
+#include <iterator>
 #include <set>
 
+#include "support/statistics.hpp"
+
 void RegAllocator::allocate(Module &mod) {
     for (auto &func : mod.functions) {
         allocate(func);
@@ -21,35 +24,46 @@ void RegAllocator::allocate(FunctionPtr &func) {
     // 在这里实现寄存器分配算法，将结果保存在 reg_map 中
     // tips: 对于朴素的仅用到三个寄存器的算法，可能用不到 reg_map
 
+    spill_loads = spill_stores = 0;
+    InstPool::Scope scope(*func->pool);
     for (auto &block : func->blocks) {
-        block->asm_code = allocate(block->asm_code, available_regs, reg_map, func);
+        allocate(block->asm_code, available_regs, reg_map, func);
     }
 
     func->reg_map = reg_map;
+
+    if (Statistics::global().is_enabled()) {
+        Statistics::global().add(func->name, "spill.loads", spill_loads);
+        Statistics::global().add(func->name, "spill.stores", spill_stores);
+    }
 }
 
-ASM::Code RegAllocator::allocate(ASM::Code &asm_code,
-                                 std::set<ASM::Reg> &available_regs,
-                                 ASM::RegMap &reg_map,
-                                 FunctionPtr &func) {
-    ASM::Code asm_code_allocated;
-    for (auto &inst : asm_code) {
-        auto inst_allocated = allocate(inst, available_regs, reg_map, func);
-        asm_code_allocated.insert(asm_code_allocated.end(), inst_allocated.begin(),
-                                  inst_allocated.end());
+void RegAllocator::allocate(ASM::Code &asm_code,
+                            std::set<ASM::Reg> &available_regs,
+                            ASM::RegMap &reg_map,
+                            FunctionPtr &func) {
+    // 原地改写指令流：lw 插在当前指令之前，sw 插在当前指令之后，
+    // 然后直接跳到原来的下一条指令，新插入的指令不会被再次处理
+    for (auto it = asm_code.begin(); it != asm_code.end();) {
+        auto next = std::next(it);
+        reload.set_insert_point(asm_code, it);
+        spill.set_insert_point(asm_code, next);
+        allocate(*it, available_regs, reg_map, func);
+        it = next;
     }
-    return asm_code_allocated;
 }
 
-ASM::Code RegAllocator::allocate(ASM::InstPtr &inst,
-                                 std::set<ASM::Reg> &available_regs,
-                                 ASM::RegMap &reg_map,
-                                 FunctionPtr &func) {
+void RegAllocator::allocate(ASM::InstPtr inst,
+                            std::set<ASM::Reg> &available_regs,
+                            ASM::RegMap &reg_map,
+                            FunctionPtr &func) {
 #define ALLOCATE_INST(type)                                      \
-    if (auto p = std::dynamic_pointer_cast<ASM::type>(inst)) {   \
+    case ASM::Opcode::type: {                                    \
+        auto p = static_cast<ASM::type *>(inst);                 \
         return allocate##type(p, available_regs, reg_map, func); \
     }
-    // 对于每种不同类型的 ASM 指令，调用相应的 allocate 函数
+    // 对于每种不同类型的 ASM 指令，按 opcode 调用相应的 allocate 函数
+    switch (inst->opcode) {
     ALLOCATE_INST(Arith)
     ALLOCATE_INST(ArithImm)
     ALLOCATE_INST(Mv)
@@ -66,16 +80,19 @@ ASM::Code RegAllocator::allocate(ASM::InstPtr &inst,
     ALLOCATE_INST(La)
     ALLOCATE_INST(Branch) // 添加这一行
     ALLOCATE_INST(GlobalLabel)
+    default:
+        break;
+    }
 
 #warning Add more ASM instruction types if needed
 
     assert(false && "Unknown ASM instruction type");
 }
 
-ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
-                                      std::set<ASM::Reg> &available_regs,
-                                      ASM::RegMap &reg_map,
-                                      FunctionPtr &func) {
+void RegAllocator::allocateArith(ASM::ArithPtr inst,
+                                 std::set<ASM::Reg> &available_regs,
+                                 ASM::RegMap &reg_map,
+                                 FunctionPtr &func) {
     // 对于每条汇编指令，为其中的虚拟寄存器分配空间并在语句前后添加 lw 和 sw 指令
     /*
       # Example: a = b + c
@@ -84,8 +101,6 @@ ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
       add t0, t1, t2      # add reg(a), reg(b), reg(c)
       sw t0, 4(sp)        # store a
     */
-    ASM::Code asm_code_allocated;
-
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1; // 物理寄存器不需要分配空间
 
@@ -105,8 +120,8 @@ ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
         phys_rs1 = get_temp_reg(1); // 使用 t1 作为临时寄存器
 
         // 生成load指令
-        auto load_inst = ASM::Load::create(phys_rs1, ASM::Reg::sp, offset);
-        asm_code_allocated.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs1, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 同理处理 rs2
@@ -116,8 +131,8 @@ ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
         phys_rs2 = get_temp_reg(2); // 使用 t2 作为临时寄存器
 
         // 生成load指令
-        auto load_inst = ASM::Load::create(phys_rs2, ASM::Reg::sp, offset);
-        asm_code_allocated.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs2, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rd
@@ -128,16 +143,17 @@ ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
         phys_rd = get_temp_reg(0); // 使用 t0 作为临时寄存器
     }
 
-    // 生成算术指令
-    auto arith_inst = ASM::Arith::create(phys_rd, phys_rs1, phys_rs2, inst->op);
-    asm_code_allocated.push_back(arith_inst);
-
     // 如果 rd 是虚拟寄存器，则需要将结果存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        asm_code_allocated.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
+    inst->rs1 = phys_rs1;
+    inst->rs2 = phys_rs2;
+
     // 更新寄存器映射
     // reg_map.emplace(inst->rd, phys_rd);
     // if (!inst->rs1.is_phys()) {
@@ -146,16 +162,12 @@ ASM::Code RegAllocator::allocateArith(ASM::ArithPtr &inst,
     // if (!inst->rs2.is_phys()) {
     //   reg_map.emplace(inst->rs2, phys_rs2);
     // }
-
-    return asm_code_allocated;
 }
 
-ASM::Code RegAllocator::allocateArithImm(ASM::ArithImmPtr &inst,
-                                         std::set<ASM::Reg> &available_regs,
-                                         ASM::RegMap &reg_map,
-                                         FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateArithImm(ASM::ArithImmPtr inst,
+                                    std::set<ASM::Reg> &available_regs,
+                                    ASM::RegMap &reg_map,
+                                    FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -171,8 +183,8 @@ ASM::Code RegAllocator::allocateArithImm(ASM::ArithImmPtr &inst,
     if (!inst->rs1.is_phys()) {
         int offset = get_stack_offset(inst->rs1);
         phys_rs1 = get_temp_reg(1);
-        auto load_inst = ASM::Load::create(phys_rs1, ASM::Reg::sp, offset);
-        result.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs1, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rd
@@ -183,25 +195,21 @@ ASM::Code RegAllocator::allocateArithImm(ASM::ArithImmPtr &inst,
         phys_rd = get_temp_reg(0);
     }
 
-    // 生成立即数算术指令
-    auto arith_imm_inst = ASM::ArithImm::create(phys_rd, phys_rs1, inst->imm, inst->op);
-    result.push_back(arith_imm_inst);
-
     // 如果 rd 是虚拟寄存器，存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        result.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
-    return result;
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
+    inst->rs1 = phys_rs1;
 }
 
-ASM::Code RegAllocator::allocateMv(ASM::MvPtr &inst,
-                                   std::set<ASM::Reg> &available_regs,
-                                   ASM::RegMap &reg_map,
-                                   FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateMv(ASM::MvPtr inst,
+                              std::set<ASM::Reg> &available_regs,
+                              ASM::RegMap &reg_map,
+                              FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -217,8 +225,8 @@ ASM::Code RegAllocator::allocateMv(ASM::MvPtr &inst,
     if (!inst->rs.is_phys()) {
         int offset = get_stack_offset(inst->rs);
         phys_rs = get_temp_reg(1);
-        auto load_inst = ASM::Load::create(phys_rs, ASM::Reg::sp, offset);
-        result.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rd
@@ -229,25 +237,21 @@ ASM::Code RegAllocator::allocateMv(ASM::MvPtr &inst,
         phys_rd = get_temp_reg(0);
     }
 
-    // 生成 mv 指令
-    auto mv_inst = ASM::Mv::create(phys_rd, phys_rs);
-    result.push_back(mv_inst);
-
     // 如果 rd 是虚拟寄存器，存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        result.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
-    return result;
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
+    inst->rs = phys_rs;
 }
 
-ASM::Code RegAllocator::allocateLi(ASM::LiPtr &inst,
-                                   std::set<ASM::Reg> &available_regs,
-                                   ASM::RegMap &reg_map,
-                                   FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateLi(ASM::LiPtr inst,
+                              std::set<ASM::Reg> &available_regs,
+                              ASM::RegMap &reg_map,
+                              FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -266,25 +270,20 @@ ASM::Code RegAllocator::allocateLi(ASM::LiPtr &inst,
         phys_rd = get_temp_reg(0);
     }
 
-    // 生成 li 指令
-    auto li_inst = ASM::Li::create(phys_rd, inst->imm);
-    result.push_back(li_inst);
-
     // 如果 rd 是虚拟寄存器，存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        result.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
-    return result;
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
 }
 
-ASM::Code RegAllocator::allocateLa(ASM::LaPtr &inst,
-                                   std::set<ASM::Reg> &available_regs,
-                                   ASM::RegMap &reg_map,
-                                   FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateLa(ASM::LaPtr inst,
+                              std::set<ASM::Reg> &available_regs,
+                              ASM::RegMap &reg_map,
+                              FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -303,25 +302,20 @@ ASM::Code RegAllocator::allocateLa(ASM::LaPtr &inst,
         phys_rd = get_temp_reg(0);
     }
 
-    // 生成 la 指令
-    auto la_inst = ASM::La::create(phys_rd, inst->label);
-    result.push_back(la_inst);
-
     // 如果 rd 是虚拟寄存器，存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        result.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
-    return result;
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
 }
 
-ASM::Code RegAllocator::allocateLoad(ASM::LoadPtr &inst,
-                                     std::set<ASM::Reg> &available_regs,
-                                     ASM::RegMap &reg_map,
-                                     FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateLoad(ASM::LoadPtr inst,
+                                std::set<ASM::Reg> &available_regs,
+                                ASM::RegMap &reg_map,
+                                FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -337,8 +331,8 @@ ASM::Code RegAllocator::allocateLoad(ASM::LoadPtr &inst,
     if (!inst->rs1.is_phys()) {
         int offset = get_stack_offset(inst->rs1);
         phys_rs1 = get_temp_reg(1);
-        auto load_base_inst = ASM::Load::create(phys_rs1, ASM::Reg::sp, offset);
-        result.push_back(load_base_inst);
+        reload.emit<ASM::Load>(phys_rs1, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rd
@@ -349,25 +343,21 @@ ASM::Code RegAllocator::allocateLoad(ASM::LoadPtr &inst,
         phys_rd = get_temp_reg(0);
     }
 
-    // 生成 load 指令
-    auto load_inst = ASM::Load::create(phys_rd, phys_rs1, inst->offset);
-    result.push_back(load_inst);
-
     // 如果 rd 是虚拟寄存器，存回栈
     if (!inst->rd.is_phys()) {
-        auto store_inst = ASM::Store::create(ASM::Reg::sp, phys_rd, rd_offset);
-        result.push_back(store_inst);
+        spill.emit<ASM::Store>(ASM::Reg::sp, phys_rd, rd_offset);
+        spill_stores++;
     }
 
-    return result;
+    // 原地改写为物理寄存器
+    inst->rd = phys_rd;
+    inst->rs1 = phys_rs1;
 }
 
-ASM::Code RegAllocator::allocateStore(ASM::StorePtr &inst,
-                                      std::set<ASM::Reg> &available_regs,
-                                      ASM::RegMap &reg_map,
-                                      FunctionPtr &func) {
-    ASM::Code result;
-
+void RegAllocator::allocateStore(ASM::StorePtr inst,
+                                 std::set<ASM::Reg> &available_regs,
+                                 ASM::RegMap &reg_map,
+                                 FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -383,8 +373,8 @@ ASM::Code RegAllocator::allocateStore(ASM::StorePtr &inst,
     if (!inst->rs1.is_phys()) {
         int offset = get_stack_offset(inst->rs1);
         phys_rs1 = get_temp_reg(1);
-        auto load_base_inst = ASM::Load::create(phys_rs1, ASM::Reg::sp, offset);
-        result.push_back(load_base_inst);
+        reload.emit<ASM::Load>(phys_rs1, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rs2 (源数据寄存器)
@@ -392,82 +382,70 @@ ASM::Code RegAllocator::allocateStore(ASM::StorePtr &inst,
     if (!inst->rs2.is_phys()) {
         int offset = get_stack_offset(inst->rs2);
         phys_rs2 = get_temp_reg(2);
-        auto load_src_inst = ASM::Load::create(phys_rs2, ASM::Reg::sp, offset);
-        result.push_back(load_src_inst);
+        reload.emit<ASM::Load>(phys_rs2, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
-    // 生成 store 指令
-    auto store_inst = ASM::Store::create(phys_rs1, phys_rs2, inst->offset);
-    result.push_back(store_inst);
-
-    return result;
+    // 原地改写为物理寄存器
+    inst->rs1 = phys_rs1;
+    inst->rs2 = phys_rs2;
 }
 
-// 对于不涉及寄存器分配的指令，直接返回原指令
-ASM::Code RegAllocator::allocateLabel(ASM::LabelPtr &inst,
-                                      std::set<ASM::Reg> &available_regs,
-                                      ASM::RegMap &reg_map,
-                                      FunctionPtr &func) {
-    return {inst};
-}
-
-ASM::Code RegAllocator::allocateFunction(ASM::FunctionPtr &inst,
-                                         std::set<ASM::Reg> &available_regs,
-                                         ASM::RegMap &reg_map,
-                                         FunctionPtr &func) {
-    return {inst};
+// 对于不涉及寄存器分配的指令，保持原样
+void RegAllocator::allocateLabel(ASM::LabelPtr inst,
+                                 std::set<ASM::Reg> &available_regs,
+                                 ASM::RegMap &reg_map,
+                                 FunctionPtr &func) {
 }
 
-ASM::Code RegAllocator::allocateCall(ASM::CallPtr &inst,
-                                     std::set<ASM::Reg> &available_regs,
-                                     ASM::RegMap &reg_map,
-                                     FunctionPtr &func) {
-    // Call 指令涉及参数寄存器，但这里使用朴素分配，直接返回
-    return {inst};
+void RegAllocator::allocateFunction(ASM::FunctionPtr inst,
+                                    std::set<ASM::Reg> &available_regs,
+                                    ASM::RegMap &reg_map,
+                                    FunctionPtr &func) {
 }
 
-ASM::Code RegAllocator::allocateJump(ASM::JumpPtr &inst,
-                                     std::set<ASM::Reg> &available_regs,
-                                     ASM::RegMap &reg_map,
-                                     FunctionPtr &func) {
-    return {inst};
+void RegAllocator::allocateCall(ASM::CallPtr inst,
+                                std::set<ASM::Reg> &available_regs,
+                                ASM::RegMap &reg_map,
+                                FunctionPtr &func) {
+    // Call 指令涉及参数寄存器，但这里使用朴素分配，保持原样
 }
 
-ASM::Code RegAllocator::allocateRet(ASM::RetPtr &inst,
-                                    std::set<ASM::Reg> &available_regs,
-                                    ASM::RegMap &reg_map,
-                                    FunctionPtr &func) {
-    return {inst};
+void RegAllocator::allocateJump(ASM::JumpPtr inst,
+                                std::set<ASM::Reg> &available_regs,
+                                ASM::RegMap &reg_map,
+                                FunctionPtr &func) {
 }
 
-ASM::Code RegAllocator::allocateZero(ASM::ZeroPtr &inst,
-                                     std::set<ASM::Reg> &available_regs,
-                                     ASM::RegMap &reg_map,
-                                     FunctionPtr &func) {
-    return {inst};
+void RegAllocator::allocateRet(ASM::RetPtr inst,
+                               std::set<ASM::Reg> &available_regs,
+                               ASM::RegMap &reg_map,
+                               FunctionPtr &func) {
 }
 
-ASM::Code RegAllocator::allocateWord(ASM::WordPtr &inst,
-                                     std::set<ASM::Reg> &available_regs,
-                                     ASM::RegMap &reg_map,
-                                     FunctionPtr &func) {
-    return {inst};
+void RegAllocator::allocateZero(ASM::ZeroPtr inst,
+                                std::set<ASM::Reg> &available_regs,
+                                ASM::RegMap &reg_map,
+                                FunctionPtr &func) {
 }
 
-ASM::Code RegAllocator::allocateGlobalLabel(ASM::GlobalLabelPtr &inst,
-                                            std::set<ASM::Reg> &available_regs,
-                                            ASM::RegMap &reg_map,
-                                            FunctionPtr &func) {
-    return {inst};
+void RegAllocator::allocateWord(ASM::WordPtr inst,
+                                std::set<ASM::Reg> &available_regs,
+                                ASM::RegMap &reg_map,
+                                FunctionPtr &func) {
 }
 
-// 添加 Branch 指令的分配函数
-ASM::Code RegAllocator::allocateBranch(ASM::BranchPtr &inst,
+void RegAllocator::allocateGlobalLabel(ASM::GlobalLabelPtr inst,
                                        std::set<ASM::Reg> &available_regs,
                                        ASM::RegMap &reg_map,
                                        FunctionPtr &func) {
-    ASM::Code result;
+}
 
+// 添加 Branch 指令的分配函数
+void RegAllocator::allocateBranch(ASM::BranchPtr inst,
+                                  std::set<ASM::Reg> &available_regs,
+                                  ASM::RegMap &reg_map,
+                                  FunctionPtr &func) {
     auto get_stack_offset = [&](const ASM::Reg &reg) -> int {
         if (reg.is_phys()) return -1;
         return func->alloc_temp(4, reg);
@@ -483,8 +461,8 @@ ASM::Code RegAllocator::allocateBranch(ASM::BranchPtr &inst,
     if (!inst->rs1.is_phys()) {
         int offset = get_stack_offset(inst->rs1);
         phys_rs1 = get_temp_reg(1);
-        auto load_inst = ASM::Load::create(phys_rs1, ASM::Reg::sp, offset);
-        result.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs1, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
     // 处理 rs2
@@ -492,13 +470,11 @@ ASM::Code RegAllocator::allocateBranch(ASM::BranchPtr &inst,
     if (!inst->rs2.is_phys()) {
         int offset = get_stack_offset(inst->rs2);
         phys_rs2 = get_temp_reg(2);
-        auto load_inst = ASM::Load::create(phys_rs2, ASM::Reg::sp, offset);
-        result.push_back(load_inst);
+        reload.emit<ASM::Load>(phys_rs2, ASM::Reg::sp, offset);
+        spill_loads++;
     }
 
-    // 生成 branch 指令
-    auto branch_inst = ASM::Branch::create(phys_rs1, phys_rs2, inst->label, inst->op);
-    result.push_back(branch_inst);
-
-    return result;
+    // 原地改写为物理寄存器
+    inst->rs1 = phys_rs1;
+    inst->rs2 = phys_rs2;
 }
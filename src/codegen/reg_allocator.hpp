@@ -9,44 +9,52 @@ class RegAllocator {
 public:
     void allocate(Module &mod);
     void allocate(FunctionPtr &func);
-    ASM::Code allocate(ASM::Code &asm_code, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                       FunctionPtr &func);
-    ASM::Code allocate(ASM::InstPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                       FunctionPtr &func);
+    void allocate(ASM::Code &asm_code, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                  FunctionPtr &func);
+    void allocate(ASM::InstPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                  FunctionPtr &func);
 
 private:
-    ASM::Code allocateArith(ASM::ArithPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                            FunctionPtr &func);
-    ASM::Code allocateArithImm(ASM::ArithImmPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                               FunctionPtr &func);
-    ASM::Code allocateMv(ASM::MvPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                         FunctionPtr &func);
-    ASM::Code allocateLi(ASM::LiPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                         FunctionPtr &func);
-    ASM::Code allocateLa(ASM::LaPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                         FunctionPtr &func);
-    ASM::Code allocateLoad(ASM::LoadPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                           FunctionPtr &func);
-    ASM::Code allocateStore(ASM::StorePtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                            FunctionPtr &func);
-    ASM::Code allocateJump(ASM::JumpPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                           FunctionPtr &func);
-    ASM::Code allocateBranch(ASM::BranchPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                             FunctionPtr &func);
-    ASM::Code allocateCall(ASM::CallPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                           FunctionPtr &func);
-    ASM::Code allocateRet(ASM::RetPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
+    void allocateArith(ASM::ArithPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                       FunctionPtr &func);
+    void allocateArithImm(ASM::ArithImmPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
                           FunctionPtr &func);
-    ASM::Code allocateLabel(ASM::LabelPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                            FunctionPtr &func);
-    ASM::Code allocateFunction(ASM::FunctionPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                               FunctionPtr &func);
-    ASM::Code allocateZero(ASM::ZeroPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                           FunctionPtr &func);
-    ASM::Code allocateWord(ASM::WordPtr &inst, std::set<ASM::Reg> &available_regs, std::map<ASM::Reg, ASM::Reg> &reg_map,
-                           FunctionPtr &func);
-    ASM::Code allocateGlobalLabel(ASM::GlobalLabelPtr &inst, std::set<ASM::Reg> &available_regs,
-                                  std::map<ASM::Reg, ASM::Reg> &reg_map, FunctionPtr &func);
+    void allocateMv(ASM::MvPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                    FunctionPtr &func);
+    void allocateLi(ASM::LiPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                    FunctionPtr &func);
+    void allocateLa(ASM::LaPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                    FunctionPtr &func);
+    void allocateLoad(ASM::LoadPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                      FunctionPtr &func);
+    void allocateStore(ASM::StorePtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                       FunctionPtr &func);
+    void allocateJump(ASM::JumpPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                      FunctionPtr &func);
+    void allocateBranch(ASM::BranchPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                        FunctionPtr &func);
+    void allocateCall(ASM::CallPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                      FunctionPtr &func);
+    void allocateRet(ASM::RetPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                     FunctionPtr &func);
+    void allocateLabel(ASM::LabelPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                       FunctionPtr &func);
+    void allocateFunction(ASM::FunctionPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                          FunctionPtr &func);
+    void allocateZero(ASM::ZeroPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                      FunctionPtr &func);
+    void allocateWord(ASM::WordPtr inst, std::set<ASM::Reg> &available_regs, ASM::RegMap &reg_map,
+                      FunctionPtr &func);
+    void allocateGlobalLabel(ASM::GlobalLabelPtr inst, std::set<ASM::Reg> &available_regs,
+                             ASM::RegMap &reg_map, FunctionPtr &func);
+
+    /// @brief 插入点在当前指令之前，用于从栈中读出虚拟寄存器
+    ASM::Builder reload;
+    /// @brief 插入点在当前指令之后，用于把结果写回栈
+    ASM::Builder spill;
+    /// @brief 插入的 lw 和 sw 条数，分配完一个函数后计入 --stats
+    long spill_loads = 0;
+    long spill_stores = 0;
 };
 
 #endif // CODEGEN_REG_ALLOCATOR_HPP
\ No newline at end of file
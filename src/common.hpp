@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 
 // 基本类型枚举
@@ -61,13 +63,22 @@ inline bool type_of(const std::shared_ptr<U> &node) {
   return std::dynamic_pointer_cast<T>(node) != nullptr;
 }
 
-#define ASSERT(expr, msg)                                                \
-  do {                                                                   \
-    if (!(expr)) {                                                       \
-      std::cerr << "Assertion failed at " << __FILE__ << ":" << __LINE__ \
-                << " (" << #expr << "): " << msg << std::endl;           \
-      std::exit(1);                                                      \
-    }                                                                    \
+/// @brief error in the program being compiled, raised by ASSERT
+/// thrown rather than exiting, so batch and server modes can report the
+/// failed unit and carry on with the next one
+class CompileError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+#define ASSERT(expr, msg)                                                 \
+  do {                                                                    \
+    if (!(expr)) {                                                        \
+      std::ostringstream assert_msg_;                                     \
+      assert_msg_ << "Assertion failed at " << __FILE__ << ":" << __LINE__ \
+                  << " (" << #expr << "): " << msg;                       \
+      throw CompileError(assert_msg_.str());                              \
+    }                                                                     \
   } while (0)
 
 #endif  // COMMON_HPP
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include "support/thread_pool.hpp"
+#include "support/trace.hpp"
+
+namespace {
+
+/// @brief 提前映射源文件的队列
+/// 读线程按输入顺序把文件映射进内存并预读，队列满时等待，
+/// 这样前面的单元在编译时，后面的文件已经在内存里了
+class ReadAhead {
+public:
+    struct Item {
+        size_t index;
+        std::optional<SourceBuffer> source;
+        std::string error; // 读取失败的原因
+    };
+
+    ReadAhead(const std::vector<std::string> &inputs, size_t capacity) :
+        inputs(inputs), capacity(std::max<size_t>(capacity, 1)), reader([this] { read_all(); }) {
+    }
+
+    ~ReadAhead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        reader.join();
+    }
+
+    /// @brief 取下一个文件，全部取完后返回 false
+    bool next(Item &item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return !ready.empty() || finished; });
+        if (ready.empty()) {
+            return false;
+        }
+        item = std::move(ready.front());
+        ready.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+private:
+    const std::vector<std::string> &inputs;
+    size_t capacity;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Item> ready;
+    bool finished = false;
+    bool stopping = false;
+    std::thread reader;
+
+    void read_all() {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            Item item{i, std::nullopt, ""};
+            try {
+                item.source = SourceBuffer::map_file(inputs[i]);
+            } catch (const std::exception &e) {
+                item.error = e.what();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return ready.size() < capacity || stopping; });
+            if (stopping) {
+                break;
+            }
+            ready.push_back(std::move(item));
+            changed.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        changed.notify_all();
+    }
+};
+
+} // namespace
+
+std::vector<std::string> BatchCompiler::read_list(const std::string &list_file) {
+    std::ifstream list(list_file);
+    if (!list) {
+        throw std::runtime_error("Cannot open file list: " + list_file);
+    }
+    std::vector<std::string> inputs;
+    std::string line;
+    while (std::getline(list, line)) {
+        auto begin = line.find_first_not_of(" \t\r");
+        auto end = line.find_last_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        inputs.push_back(line.substr(begin, end - begin + 1));
+    }
+    return inputs;
+}
+
+std::string BatchCompiler::output_path(const std::string &input) const {
+    std::filesystem::path path(input);
+    path.replace_extension(options.output_ir ? ".ir" : ".s");
+    if (output_dir.empty()) {
+        return path.string();
+    }
+    return (std::filesystem::path(output_dir) / path.filename()).string();
+}
+
+BatchCompiler::Result BatchCompiler::compile(const std::string &input, SourceBuffer &source) {
+    Result result;
+    Trace::Scope trace("compile", input);
+    try {
+        auto mod = compile_frontend(source, options);
+        if (mod) {
+            Writer output(Writer::open_file(output_path(input)), true);
+            // 并行度已经体现在同时编译的多个单元上，单元内部不再分线程
+            auto unit_options = options;
+            unit_options.jobs = 1;
+            compile_backend(*mod, unit_options, output);
+        }
+        result.ok = true;
+    } catch (const std::exception &e) {
+        result.message = e.what();
+    }
+    return result;
+}
+
+int BatchCompiler::run(const std::vector<std::string> &inputs, std::ostream &report) {
+    // 不同的输入可能落到同一个输出文件（例如 --output-dir 下同名的文件），
+    // 并行写同一个文件会丢掉其中一个结果，所以在开始编译前就拒绝
+    std::map<std::string, const std::string *> outputs;
+    for (const auto &input : inputs) {
+        auto path = std::filesystem::path(output_path(input)).lexically_normal().string();
+        auto [it, inserted] = outputs.emplace(path, &input);
+        if (!inserted) {
+            throw std::runtime_error("Inputs " + *it->second + " and " + input +
+                                     " would both be written to " + path);
+        }
+    }
+
+    if (!output_dir.empty()) {
+        std::filesystem::create_directories(output_dir);
+    }
+
+    std::vector<Result> results(inputs.size());
+    workers = std::max(workers, 1u);
+    {
+        ReadAhead read_ahead(inputs, 2 * workers);
+        ThreadPool pool(workers);
+        for (unsigned i = 0; i < workers; i++) {
+            pool.submit([&] {
+                ReadAhead::Item item;
+                while (read_ahead.next(item)) {
+                    auto &result = results[item.index];
+                    if (!item.error.empty()) {
+                        result.message = item.error;
+                        continue;
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    result = compile(inputs[item.index], *item.source);
+                    result.seconds = std::chrono::duration<double>(
+                                         std::chrono::steady_clock::now() - start)
+                                         .count();
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // 按输入顺序汇总
+    int failed = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const auto &result = results[i];
+        if (result.ok) {
+            report << "[ OK ] " << inputs[i] << " (" << std::fixed << std::setprecision(1)
+                   << result.seconds * 1000 << " ms)" << std::endl;
+        } else {
+            report << "[FAIL] " << inputs[i] << ": " << result.message << std::endl;
+            failed++;
+        }
+    }
+    report << inputs.size() << " files, " << inputs.size() - failed << " succeeded, " << failed
+           << " failed" << std::endl;
+    return failed;
+}
@@ -0,0 +1,45 @@
+#ifndef DRIVER_BATCH_HPP
+#define DRIVER_BATCH_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "driver/compiler.hpp"
+#include "support/source_buffer.hpp"
+
+/// @brief 在一个进程里编译多个源文件
+/// 读文件由单独的线程提前进行，各单元在线程池中并行编译，
+/// 一个单元出错不影响其他单元
+class BatchCompiler {
+public:
+    /// @param output_dir 输出目录，为空时输出到源文件旁边
+    /// @param workers 同时编译的单元数
+    BatchCompiler(const CompileOptions &options, std::string output_dir, unsigned workers) :
+        options(options), output_dir(std::move(output_dir)), workers(workers) {
+    }
+
+    /// @brief 编译所有输入，并把每个文件的结果汇总输出到 report
+    /// @return 失败的单元数
+    int run(const std::vector<std::string> &inputs, std::ostream &report);
+
+    /// @brief 读取列表文件，每行一个路径，忽略空行和 # 开头的行
+    static std::vector<std::string> read_list(const std::string &list_file);
+
+private:
+    CompileOptions options;
+    std::string output_dir;
+    unsigned workers;
+
+    /// @brief 一个单元的编译结果
+    struct Result {
+        bool ok = false;
+        std::string message; // 失败原因
+        double seconds = 0;
+    };
+
+    std::string output_path(const std::string &input) const;
+    Result compile(const std::string &input, SourceBuffer &source);
+};
+
+#endif // DRIVER_BATCH_HPP
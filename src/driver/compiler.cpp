@@ -0,0 +1,225 @@
+#include "compiler.hpp"
+
+#include <string>
+#include <vector>
+
+#include "analysis/cfg_builder.hpp"
+#include "ast/tree.hpp"
+#include "codegen/backend.hpp"
+#include "ir/ir_translator.hpp"
+#include "parser/parser.hpp"
+#include "semantic/type_checker.hpp"
+#include "support/arena.hpp"
+#include "support/statistics.hpp"
+#include "support/time_report.hpp"
+#include "support/trace.hpp"
+
+namespace {
+
+/// @brief --verbose 时输出一行进度信息
+void progress(const CompileOptions &options, std::ostream *log, const char *message) {
+    if (log && options.verbose) {
+        *log << message << std::endl;
+    }
+}
+
+/// @brief --stats：按种类统计 AST 节点数
+void count_ast(AST::NodePtr root) {
+    long counts[static_cast<size_t>(AST::Kind::CompUnit) + 1] = {};
+    std::vector<AST::NodePtr> stack = {root};
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        counts[static_cast<size_t>(node->kind)]++;
+        for (size_t i = 0; i < node->num_children(); i++) {
+            if (auto child = node->child(i)) {
+                stack.push_back(child);
+            }
+        }
+    }
+    for (size_t kind = 0; kind < std::size(counts); kind++) {
+        if (counts[kind] > 0) {
+            Statistics::global().add({}, std::string("ast.") + AST::kind_name(AST::Kind(kind)),
+                                     counts[kind]);
+        }
+    }
+}
+
+/// @brief --stats：每个函数的基本块数和按 opcode 统计的 IR 指令数
+void count_ir(const Module &mod) {
+    auto &stats = Statistics::global();
+    for (const auto &func : mod.functions) {
+        long counts[static_cast<size_t>(IR::Opcode::Load) + 1] = {};
+        long total = 0;
+        for (const auto &block : func->blocks) {
+            for (const auto &node : block->ir_code) {
+                counts[static_cast<size_t>(node->opcode)]++;
+                total++;
+            }
+        }
+        stats.add(func->name, "cfg.blocks", func->blocks.size());
+        stats.add(func->name, "ir.insts", total);
+        for (size_t opcode = 0; opcode < std::size(counts); opcode++) {
+            if (counts[opcode] > 0) {
+                stats.add(func->name,
+                          std::string("ir.") + IR::opcode_name(IR::Opcode(opcode)),
+                          counts[opcode]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+std::optional<Module> compile_frontend(SourceBuffer &source, const CompileOptions &options,
+                                       std::ostream *log) {
+    // 每个线程一个 arena：离开前端时销毁本单元的 AST，但内存块保留给
+    // 同一线程的下一个单元，批量和服务模式下不必反复向系统申请
+    thread_local Arena ast_arena;
+    struct ResetAST {
+        ~ResetAST() {
+            ast_arena.reset();
+        }
+    } reset_ast;
+    Trace::Scope trace("frontend");
+
+    // 每个阶段一个计时区间，emplace 下一个阶段时上一个阶段结束
+    std::optional<TimeReport::Scope> timer(std::in_place, "lex+parse");
+    auto root = parse(source, ast_arena, options.lexer);
+    timer.reset();
+    if (!root) {
+        return std::nullopt;
+    }
+
+    if (log && options.dump_ast) {
+        Writer out(*log);
+        root->print_tree(out);
+    }
+    if (Statistics::global().is_enabled()) {
+        count_ast(root);
+    }
+    progress(options, log, "Parse succeeded");
+
+    timer.emplace("typecheck");
+    auto type_checker = TypeChecker();
+    type_checker.check(root);
+    timer.reset();
+    progress(options, log, "Semantic check passed");
+
+    timer.emplace("translate");
+    auto ir_translator = IRTranslator();
+    auto ir = ir_translator.translate(root);
+    timer.reset();
+    progress(options, log, "IR generated");
+
+    timer.emplace("cfg");
+    auto cfg_builder = CFGBuilder();
+    auto mod = cfg_builder.build(std::move(ir));
+    mod.pools = ir_translator.take_pools();
+    timer.reset();
+    if (Statistics::global().is_enabled()) {
+        count_ir(mod);
+    }
+    progress(options, log, "Control flow graph generated");
+
+    if (log && options.dump_ir) {
+        Writer out(*log);
+        mod.print_ir(out);
+    }
+
+    return mod;
+}
+
+void compile_backend(Module &mod, const CompileOptions &options, Writer &output,
+                     std::ostream *log) {
+    if (options.output_ir) {
+        mod.print_ir(output);
+        output.flush();
+        return;
+    }
+
+    // 指令选择、寄存器分配和汇编生成按函数并行，输出按源码顺序拼接
+    Trace::Scope trace("backend");
+    bool dump_pre_ra = log && options.dump_asm_pre_ra;
+    auto backend = Backend(options.use_venus, options.jobs, dump_pre_ra);
+    backend.compile(mod);
+    if (dump_pre_ra) {
+        Writer out(*log);
+        backend.print_pre_ra(out);
+    }
+    progress(options, log, "Instruction selection done");
+    progress(options, log, "Register allocation done");
+
+    backend.write(mod, output);
+    progress(options, log, "Assembly generated");
+}
+
+void compile_streaming(SourceBuffer &source, const CompileOptions &options, Writer &output,
+                       std::ostream *log) {
+    // 整个文件共用一个 arena，每个单元处理完后 parse 把它退回到单元开始之前，
+    // 类型检查器和 IR 翻译器则跨单元保留符号表和全局变量的信息
+    Arena ast_arena;
+    auto type_checker = TypeChecker();
+    auto ir_translator = IRTranslator();
+    auto cfg_builder = CFGBuilder();
+    bool dump_pre_ra = log && options.dump_asm_pre_ra;
+    auto backend = Backend(options.use_venus, 1, dump_pre_ra);
+    bool stats = Statistics::global().is_enabled();
+
+    // 单元的前端在回调中完成；回调返回后 parse 才释放它的 AST，所以后端推迟到
+    // 下一个单元的回调或分析结束时，最大的函数做后端时不必同时持有它的 AST
+    std::optional<Module> pending;
+    auto compile_pending = [&] {
+        if (!pending) {
+            return;
+        }
+        if (options.output_ir) {
+            pending->print_ir(output);
+        } else {
+            backend.stream(*pending, output);
+            if (dump_pre_ra) {
+                Writer out(*log);
+                backend.print_pre_ra(out);
+            }
+        }
+        pending.reset();
+    };
+
+    auto compile_unit = [&](AST::NodePtr unit) {
+        compile_pending();
+        if (stats) {
+            count_ast(unit);
+        }
+        if (log && options.dump_ast) {
+            Writer out(*log);
+            unit->print_tree(out);
+        }
+
+        std::optional<TimeReport::Scope> timer(std::in_place, "typecheck");
+        type_checker.check(unit);
+        timer.emplace("translate");
+        auto ir = ir_translator.translateUnit(unit);
+        timer.emplace("cfg");
+        pending = cfg_builder.build(std::move(ir));
+        pending->pools = ir_translator.take_pools();
+        timer.reset();
+
+        if (stats) {
+            count_ir(*pending);
+        }
+        if (log && options.dump_ir) {
+            Writer out(*log);
+            pending->print_ir(out);
+        }
+    };
+
+    Trace::Scope trace("stream");
+    parse(source, ast_arena, options.lexer, compile_unit);
+    compile_pending();
+    if (options.output_ir) {
+        output.flush();
+    } else {
+        backend.finish_stream(output);
+    }
+    progress(options, log, "Assembly generated");
+}
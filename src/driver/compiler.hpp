@@ -0,0 +1,50 @@
+#ifndef DRIVER_COMPILER_HPP
+#define DRIVER_COMPILER_HPP
+
+#include <optional>
+#include <ostream>
+
+#include "analysis/control_flow.hpp"
+#include "lexer/lexer.hpp"
+#include "support/source_buffer.hpp"
+#include "support/writer.hpp"
+
+/// @brief 编译一个单元时的选项
+struct CompileOptions {
+    bool output_ir = false;
+    bool use_venus = false;
+    unsigned jobs = 1; // 后端并行处理函数的线程数
+    LexerKind lexer = LexerKind::Flex;
+    bool stream = false; // 逐个顶层单元编译并输出，见 compile_streaming
+    // 以下输出都写到 log，默认都关闭
+    bool verbose = false;         // 各阶段完成时的进度信息
+    bool dump_ast = false;        // 语法树
+    bool dump_ir = false;         // 构建 CFG 之后的 IR
+    bool dump_asm_pre_ra = false; // 寄存器分配之前的汇编
+};
+
+/// @brief 前端：词法语法分析、语义检查、IR 生成和 CFG 构建
+/// 不依赖全局状态，多个线程可以同时编译不同的单元；
+/// 返回后 AST 已经释放，Module 不再引用 AST
+/// @param source 源码，扫描器直接在其中工作
+/// @param log 进度信息和各种转储的输出位置，nullptr 表示不输出
+/// @return 源文件为空时返回 std::nullopt
+/// 出错时抛出异常，语义错误为 CompileError
+std::optional<Module> compile_frontend(SourceBuffer &source, const CompileOptions &options,
+                                       std::ostream *log = nullptr);
+
+/// @brief 后端：按 options 输出 IR，或者生成汇编
+/// 不同单元的后端可以同时运行；返回前 output 已经 flush
+void compile_backend(Module &mod, const CompileOptions &options, Writer &output,
+                     std::ostream *log = nullptr);
+
+/// @brief 流式编译：每个全局声明或函数一分析完，就完成语义检查、IR 生成、
+/// CFG 构建、指令选择、寄存器分配和输出，然后释放它的 AST、IR 和汇编，
+/// 再分析下一个。内存峰值只与最大的函数有关，与整个文件的大小无关
+/// 函数依次编译，不使用 options.jobs；全局变量都在函数之前时，
+/// 输出与 compile_frontend 加 compile_backend 相同
+/// 出错时抛出异常，此时 output 中可能已经有了之前单元的输出
+void compile_streaming(SourceBuffer &source, const CompileOptions &options, Writer &output,
+                       std::ostream *log = nullptr);
+
+#endif // DRIVER_COMPILER_HPP
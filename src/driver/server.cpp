@@ -0,0 +1,279 @@
+#include "server.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <stdexcept>
+
+#include "driver/compiler.hpp"
+#include "support/source_buffer.hpp"
+#include "support/thread_pool.hpp"
+#include "support/trace.hpp"
+
+namespace {
+
+// 单个请求的源码上限，防止错误的长度字段让服务端分配过多内存
+constexpr size_t max_source_size = 64 << 20;
+// 请求开始后，客户端最多这么久不发数据；空闲的连接不受限制，它们不占工作线程
+constexpr int read_timeout_seconds = 10;
+
+/// @brief 解析请求头 "<mode> <length>"
+bool parse_header(const std::string &line, CompileOptions &options, size_t &length) {
+    std::istringstream header(line);
+    std::string mode;
+    if (!(header >> mode >> length) || length > max_source_size) {
+        return false;
+    }
+    if (mode == "ir") {
+        options.output_ir = true;
+    } else if (mode == "venus") {
+        options.use_venus = true;
+    } else if (mode != "asm") {
+        return false;
+    }
+    return true;
+}
+
+/// @brief 编译一个请求，返回是否成功，结果或诊断信息写入 output
+bool compile_request(std::string &&text, const CompileOptions &options, std::string &output) {
+    Trace::Scope trace("request");
+    try {
+        SourceBuffer source(std::move(text));
+        auto mod = compile_frontend(source, options);
+        output.clear();
+        if (mod) {
+            Writer result(output);
+            compile_backend(*mod, options, result);
+        }
+        return true;
+    } catch (const std::exception &e) {
+        output = e.what();
+        return false;
+    }
+}
+
+} // namespace
+
+/// @brief 带缓冲地读写一个连接
+class CompileServer::Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {
+    }
+
+    ~Connection() {
+        close(fd);
+    }
+
+    /// @brief 读到 \n 为止（不含 \n），连接关闭或行过长时返回 false
+    bool read_line(std::string &line) {
+        line.clear();
+        char c;
+        while (read_byte(c)) {
+            if (c == '\n') {
+                return true;
+            }
+            if (line.size() >= 64) {
+                return false;
+            }
+            line.push_back(c);
+        }
+        return false;
+    }
+
+    /// @brief 恰好读 size 个字节
+    bool read_exact(std::string &data, size_t size) {
+        data.resize(size);
+        size_t done = std::min(size, buffered());
+        std::memcpy(data.data(), buffer + begin, done);
+        begin += done;
+        while (done < size) {
+            ssize_t n = recv(fd, data.data() + done, size - done, 0);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    int descriptor() const {
+        return fd;
+    }
+
+    /// @brief 缓冲区里是否已经有下一个请求的数据，有则不必再等 poll
+    bool has_buffered() const {
+        return buffered() > 0;
+    }
+
+    bool write_all(const std::string &data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            // 客户端提前断开时不要收到 SIGPIPE
+            ssize_t n = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    char buffer[4096];
+    size_t begin = 0;
+    size_t end = 0;
+
+    size_t buffered() const {
+        return end - begin;
+    }
+
+    bool read_byte(char &c) {
+        if (begin == end) {
+            ssize_t n;
+            do {
+                n = recv(fd, buffer, sizeof(buffer), 0);
+            } while (n < 0 && errno == EINTR);
+            if (n <= 0) {
+                return false;
+            }
+            begin = 0;
+            end = n;
+        }
+        c = buffer[begin++];
+        return true;
+    }
+};
+
+void CompileServer::run() {
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Cannot create socket: " + std::string(strerror(errno)));
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socket_path);
+    }
+    std::strcpy(addr.sun_path, socket_path.c_str());
+    unlink(socket_path.c_str()); // 上次运行留下的 socket 文件
+    if (bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        listen(listener, SOMAXCONN) < 0) {
+        throw std::runtime_error("Cannot listen on " + socket_path + ": " + strerror(errno));
+    }
+
+    // 工作线程处理完一个请求后把连接交回来，并写一个字节唤醒 poll
+    int wake[2];
+    // 两端都不阻塞：管道满时 poll 本来就会醒，读到空为止即可
+    if (pipe2(wake, O_NONBLOCK | O_CLOEXEC) < 0) {
+        throw std::runtime_error("Cannot create pipe: " + std::string(strerror(errno)));
+    }
+    std::mutex returned_mutex;
+    std::vector<std::shared_ptr<Connection>> returned;
+
+    // 本线程只等待：新连接和空闲连接上的数据都由 poll 发现，
+    // 每个请求单独交给线程池，空闲的连接不占工作线程
+    ThreadPool pool(workers);
+    std::unordered_map<int, std::shared_ptr<Connection>> idle;
+    auto submit = [&](std::shared_ptr<Connection> connection) {
+        pool.submit([&, connection] {
+            if (serve(*connection)) {
+                std::lock_guard<std::mutex> lock(returned_mutex);
+                returned.push_back(connection);
+            }
+            char byte = 0;
+            while (write(wake[1], &byte, 1) < 0 && errno == EINTR) {
+            }
+        });
+    };
+
+    std::vector<pollfd> fds;
+    for (;;) {
+        fds.assign({{wake[0], POLLIN, 0}, {listener, POLLIN, 0}});
+        for (auto &[fd, connection] : idle) {
+            fds.push_back({fd, POLLIN, 0});
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Poll failed: " + std::string(strerror(errno)));
+        }
+
+        if (fds[0].revents) {
+            char bytes[64];
+            while (read(wake[0], bytes, sizeof(bytes)) > 0) {
+            }
+            std::vector<std::shared_ptr<Connection>> ready;
+            {
+                std::lock_guard<std::mutex> lock(returned_mutex);
+                ready.swap(returned);
+            }
+            for (auto &connection : ready) {
+                // 客户端可能一次发来了多个请求，剩下的已经在缓冲区里
+                if (connection->has_buffered()) {
+                    submit(connection);
+                } else {
+                    idle.emplace(connection->descriptor(), connection);
+                }
+            }
+        }
+
+        if (fds[1].revents) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (errno != EINTR && errno != ECONNABORTED) {
+                    throw std::runtime_error("Accept failed: " + std::string(strerror(errno)));
+                }
+            } else {
+                timeval timeout{read_timeout_seconds, 0};
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                idle.emplace(client, std::make_shared<Connection>(client));
+            }
+        }
+
+        for (size_t i = 2; i < fds.size(); i++) {
+            if (fds[i].revents) {
+                auto it = idle.find(fds[i].fd);
+                submit(it->second);
+                idle.erase(it);
+            }
+        }
+    }
+}
+
+bool CompileServer::serve(Connection &connection) {
+    // 输出格式由请求决定；每个请求只占一个线程，后端不再分线程
+    CompileOptions options = base_options;
+    options.output_ir = options.use_venus = false;
+    options.jobs = 1;
+    std::string line, source, output;
+    if (!connection.read_line(line)) {
+        return false;
+    }
+    size_t length;
+    if (!parse_header(line, options, length)) {
+        const std::string message = "Malformed request header";
+        connection.write_all("error " + std::to_string(message.size()) + "\n" + message);
+        return false;
+    }
+    if (!connection.read_exact(source, length)) {
+        return false;
+    }
+    bool ok = compile_request(std::move(source), options, output);
+    std::string response = (ok ? "ok " : "error ") + std::to_string(output.size()) + "\n";
+    return connection.write_all(response) && connection.write_all(output);
+}
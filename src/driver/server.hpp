@@ -0,0 +1,45 @@
+#ifndef DRIVER_SERVER_HPP
+#define DRIVER_SERVER_HPP
+
+#include <string>
+
+#include "driver/compiler.hpp"
+
+/// @brief 常驻的编译服务，监听一个 Unix domain socket
+/// 进程只启动一次，内置函数的符号表和 AST 的 arena 在请求之间保留。
+/// 主线程用 poll 等待新连接和空闲连接上的请求，每个请求单独交给线程池，
+/// 所以保持连接但不发请求的客户端不占工作线程；请求发到一半停下的客户端
+/// 在读超时后被断开
+///
+/// 标识符表 (Ident) 是整个进程共享的，只增不减：每种不同的拼写存一份，
+/// 所以服务端的内存随所有请求中出现过的不同标识符个数增长，而不是随请求数增长
+///
+/// 协议：一个连接上可以依次发送多个请求，客户端关闭连接即结束
+///   请求：<mode> <length>\n<source>
+///         mode 为 asm、venus 或 ir，length 为 source 的字节数
+///   响应：<status> <length>\n<payload>
+///         status 为 ok 时 payload 是汇编或 IR，为 error 时是诊断信息
+class CompileServer {
+public:
+    /// @param options 请求共用的选项，输出格式由每个请求自己指定
+    /// @param workers 同时编译的请求数
+    CompileServer(std::string socket_path, const CompileOptions &options, unsigned workers) :
+        socket_path(std::move(socket_path)), base_options(options), workers(workers) {
+    }
+
+    /// @brief 绑定 socket 并处理请求，不会返回；出错时抛出异常
+    [[noreturn]] void run();
+
+private:
+    class Connection;
+
+    std::string socket_path;
+    CompileOptions base_options;
+    unsigned workers;
+
+    /// @brief 读取并回应连接上的一个请求
+    /// @return 连接是否还能继续使用；返回 false 时由调用者丢弃连接
+    bool serve(Connection &connection);
+};
+
+#endif // DRIVER_SERVER_HPP
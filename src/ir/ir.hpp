@@ -2,257 +2,425 @@
 #define IR_IR_HPP
 
 #include <iostream>
-#include <list>
 #include <memory>
 #include <string>
 #include <vector>
-#include <numeric>
 
 #include "common.hpp"
+#include "support/ident.hpp"
+#include "support/ilist.hpp"
+#include "support/inst_pool.hpp"
+#include "support/writer.hpp"
 
 namespace IR {
 
+/// @brief IR operand
+/// Temps are dense integer ids, named variables are interned identifiers and
+/// immediates carry their value directly, so no operand owns a string.
+class Operand {
+ public:
+  enum class Kind : uint8_t { None, Temp, Name, Imm };
+
+  Operand() = default;
+
+  static Operand temp(int id) { return Operand(Kind::Temp, id); }
+  static Operand name(Ident ident) { return Operand(Kind::Name, 0, ident); }
+  static Operand imm(int value) { return Operand(Kind::Imm, value); }
+
+  Kind kind() const { return kind_; }
+  bool empty() const { return kind_ == Kind::None; }
+  bool is_temp() const { return kind_ == Kind::Temp; }
+  bool is_name() const { return kind_ == Kind::Name; }
+  bool is_imm() const { return kind_ == Kind::Imm; }
+
+  /// @brief temp id or immediate value
+  int value() const { return value_; }
+  Ident ident() const { return ident_; }
+
+  bool operator==(const Operand &other) const {
+    return kind_ == other.kind_ && value_ == other.value_ &&
+           ident_ == other.ident_;
+  }
+  bool operator!=(const Operand &other) const { return !(*this == other); }
+
+  void print(Writer &out) const {
+    switch (kind_) {
+      case Kind::Temp:
+        out << 'T' << value_;
+        break;
+      case Kind::Name:
+        out << ident_.str();
+        break;
+      case Kind::Imm:
+        out << '#' << value_;
+        break;
+      default:
+        break;
+    }
+  }
+  std::string to_string() const {
+    std::string text;
+    Writer out(text);
+    print(out);
+    return text;
+  }
+
+ private:
+  Kind kind_ = Kind::None;
+  int value_ = 0;
+  Ident ident_;
+
+  Operand(Kind kind, int value, Ident ident = Ident())
+      : kind_(kind), value_(value), ident_(ident) {}
+};
+
+/// @brief IR 指令的操作码，每种指令一个
+enum class Opcode {
+  LoadImm,
+  Assign,
+  Binary,
+  Unary,
+  Label,
+  Goto,
+  Function,
+  Call,
+  Arg,
+  Param,
+  Return,
+  If,
+  Global,
+  Dec,
+  LoadAddr,
+  Store,
+  Load,
+};
+
+/// @brief name of an opcode, e.g. "Binary"
+inline const char *opcode_name(Opcode opcode) {
+#define OPCODE_NAME(type) \
+  case Opcode::type:      \
+    return #type;
+  switch (opcode) {
+  OPCODE_NAME(LoadImm)
+  OPCODE_NAME(Assign)
+  OPCODE_NAME(Binary)
+  OPCODE_NAME(Unary)
+  OPCODE_NAME(Label)
+  OPCODE_NAME(Goto)
+  OPCODE_NAME(Function)
+  OPCODE_NAME(Call)
+  OPCODE_NAME(Arg)
+  OPCODE_NAME(Param)
+  OPCODE_NAME(Return)
+  OPCODE_NAME(If)
+  OPCODE_NAME(Global)
+  OPCODE_NAME(Dec)
+  OPCODE_NAME(LoadAddr)
+  OPCODE_NAME(Store)
+  OPCODE_NAME(Load)
+  }
+#undef OPCODE_NAME
+  return "?";
+}
+
+// IR instructions are owned by the InstPool of their function and linked
+// into intrusive lists; a NodePtr is just a non-owning handle
 class Node;
-using NodePtr = std::shared_ptr<Node>;
-class Node {
+using NodePtr = Node *;
+class Node : public IListNode<Node> {
  public:
-  virtual std::string to_string() const = 0;
+  const Opcode opcode;
+
+  explicit Node(Opcode opcode) : opcode(opcode) {}
   virtual ~Node() = default;  // make the class polymorphic
+
+  /// @brief format the instruction into out, without indentation or newline
+  virtual void print(Writer &out) const = 0;
+  std::string to_string() const {
+    std::string text;
+    Writer out(text);
+    print(out);
+    return text;
+  }
+};
+
+/// @brief Base of every concrete instruction, stamps it with its opcode
+template <Opcode O>
+class NodeOf : public Node {
+ public:
+  static constexpr Opcode node_opcode = O;
+  NodeOf() : Node(O) {}
 };
 
+/// @brief Checked downcast by opcode, nullptr if node is not a T
+template <typename T>
+T *dyn_cast(Node *node) {
+  return node && node->opcode == T::node_opcode ? static_cast<T *>(node)
+                                                : nullptr;
+}
+
 class LoadImm;
-using LoadImmPtr = std::shared_ptr<LoadImm>;
-class LoadImm : public Node {
+using LoadImmPtr = LoadImm *;
+class LoadImm : public NodeOf<Opcode::LoadImm> {
  public:
-  std::string x;
+  Operand x;
   int k;
 
-  LoadImm(const std::string &x, int k) : x(x), k(k) {}
-  static LoadImmPtr create(const std::string &x, int k) {
-    return std::make_shared<LoadImm>(x, k);
+  LoadImm(const Operand &x, int k) : x(x), k(k) {}
+  static LoadImmPtr create(const Operand &x, int k) {
+    return InstPool::current().create<LoadImm>(x, k);
   }
 
-  std::string to_string() const override {
-    return x + " = #" + std::to_string(k);
+  void print(Writer &out) const override {
+    x.print(out);
+    out << " = #" << k;
   }
 };
 
 class Assign;
-using AssignPtr = std::shared_ptr<Assign>;
-class Assign : public Node {
+using AssignPtr = Assign *;
+class Assign : public NodeOf<Opcode::Assign> {
  public:
-  std::string x;
-  std::string y;
+  Operand x;
+  Operand y;
 
-  Assign(const std::string &x, const std::string &y) : x(x), y(y) {}
-  static AssignPtr create(const std::string &x, const std::string &y) {
-    return std::make_shared<Assign>(x, y);
+  Assign(const Operand &x, const Operand &y) : x(x), y(y) {}
+  static AssignPtr create(const Operand &x, const Operand &y) {
+    return InstPool::current().create<Assign>(x, y);
   }
 
-  std::string to_string() const override { return x + " = " + y; }
+  void print(Writer &out) const override {
+    x.print(out);
+    out << " = ";
+    y.print(out);
+  }
 };
 
 class Binary;
-using BinaryPtr = std::shared_ptr<Binary>;
-class Binary : public Node {
+using BinaryPtr = Binary *;
+class Binary : public NodeOf<Opcode::Binary> {
  public:
-  std::string x;
-  std::string y;
+  Operand x;
+  Operand y;
   BinaryOp op;
-  std::string z;
+  Operand z;
 
-  Binary(const std::string &x, const std::string &y, const BinaryOp &op,
-         const std::string &z)
+  Binary(const Operand &x, const Operand &y, const BinaryOp &op,
+         const Operand &z)
       : x(x), y(y), op(op), z(z) {}
 
-  static BinaryPtr create(const std::string &x, const std::string &y,
-                          const BinaryOp &op, const std::string &z) {
-    return std::make_shared<Binary>(x, y, op, z);
+  static BinaryPtr create(const Operand &x, const Operand &y,
+                          const BinaryOp &op, const Operand &z) {
+    return InstPool::current().create<Binary>(x, y, op, z);
   }
 
-  std::string to_string() const override {
-    return x + " = " + y + " " + op_to_string(op) + " " + z;
+  void print(Writer &out) const override {
+    x.print(out);
+    out << " = ";
+    y.print(out);
+    out << ' ' << op_to_string(op) << ' ';
+    z.print(out);
   }
 };
 
 class Unary;
-using UnaryPtr = std::shared_ptr<Unary>;
-class Unary : public Node {
+using UnaryPtr = Unary *;
+class Unary : public NodeOf<Opcode::Unary> {
  public:
-  std::string x;
+  Operand x;
   BinaryOp op;
-  std::string y;
+  Operand y;
 
-  Unary(const std::string &x, const BinaryOp &op, const std::string &y)
+  Unary(const Operand &x, const BinaryOp &op, const Operand &y)
       : x(x), op(op), y(y) {}
 
-  static UnaryPtr create(const std::string &x, const BinaryOp &op,
-                         const std::string &y) {
-    return std::make_shared<Unary>(x, op, y);
+  static UnaryPtr create(const Operand &x, const BinaryOp &op,
+                         const Operand &y) {
+    return InstPool::current().create<Unary>(x, op, y);
   }
 
-  std::string to_string() const override {
-    return x + " = " + op_to_string(op) + " " + y;
+  void print(Writer &out) const override {
+    x.print(out);
+    out << " = " << op_to_string(op) << ' ';
+    y.print(out);
   }
 };
 
 class Label;
-using LabelPtr = std::shared_ptr<Label>;
-class Label : public Node {
+using LabelPtr = Label *;
+class Label : public NodeOf<Opcode::Label> {
  public:
-  std::string label;
+  Ident label;
 
-  Label(const std::string &label) : label(label) {}
+  Label(Ident label) : label(label) {}
 
-  static LabelPtr create(const std::string &label) {
-    return std::make_shared<Label>(label);
+  static LabelPtr create(Ident label) {
+    return InstPool::current().create<Label>(label);
   }
 
-  std::string to_string() const override { return "LABEL " + label + ":"; }
+  void print(Writer &out) const override {
+    out << "LABEL " << label.str() << ':';
+  }
 };
 
 class Goto;
-using GotoPtr = std::shared_ptr<Goto>;
-class Goto : public Node {
+using GotoPtr = Goto *;
+class Goto : public NodeOf<Opcode::Goto> {
  public:
-  std::string label;
+  Ident label;
 
-  Goto(const std::string &label) : label(label) {}
+  Goto(Ident label) : label(label) {}
 
-  static GotoPtr create(const std::string &label) {
-    return std::make_shared<Goto>(label);
+  static GotoPtr create(Ident label) {
+    return InstPool::current().create<Goto>(label);
   }
 
-  std::string to_string() const override { return "GOTO " + label; }
+  void print(Writer &out) const override { out << "GOTO " << label.str(); }
 };
 
 class Function;
-using FunctionPtr = std::shared_ptr<Function>;
-class Function : public Node {
+using FunctionPtr = Function *;
+class Function : public NodeOf<Opcode::Function> {
  public:
-  std::string name;
+  Ident name;
+  /// @brief pool that owns the instructions of this function
+  InstPool *pool;
 
-  Function(const std::string &func) : name(func) {}
+  Function(Ident func) : name(func), pool(&InstPool::current()) {}
 
-  static FunctionPtr create(const std::string &func) {
-    return std::make_shared<Function>(func);
+  static FunctionPtr create(Ident func) {
+    return InstPool::current().create<Function>(func);
   }
 
-  std::string to_string() const override { return "FUNCTION " + name + ":"; }
+  void print(Writer &out) const override {
+    out << "FUNCTION " << name.str() << ':';
+  }
 };
 
 class Call;
-using CallPtr = std::shared_ptr<Call>;
-class Call : public Node {
+using CallPtr = Call *;
+class Call : public NodeOf<Opcode::Call> {
  public:
-  std::string func;
-  std::string x;  // 返回值存放的位置，空字符串表示无返回值
+  Ident func;
+  Operand x;  // 返回值存放的位置，空操作数表示无返回值
 
-  Call(const std::string &func) : func(func) {}
-  Call(const std::string &x, const std::string &func) : func(func), x(x) {}
+  Call(Ident func) : func(func) {}
+  Call(const Operand &x, Ident func) : func(func), x(x) {}
 
-  static CallPtr create(const std::string &func) {
-    return std::make_shared<Call>(func);
+  static CallPtr create(Ident func) {
+    return InstPool::current().create<Call>(func);
   }
-  static CallPtr create(const std::string &x, const std::string &func) {
-    return std::make_shared<Call>(x, func);
+  static CallPtr create(const Operand &x, Ident func) {
+    return InstPool::current().create<Call>(x, func);
   }
 
-  std::string to_string() const override {
-    if (x.empty()) {
-      return "CALL " + func;
+  void print(Writer &out) const override {
+    if (!x.empty()) {
+      x.print(out);
+      out << " = ";
     }
-    return x + " = CALL " + func;
+    out << "CALL " << func.str();
   }
 };
 
 class Arg;
-using ArgPtr = std::shared_ptr<Arg>;
-class Arg : public Node {
+using ArgPtr = Arg *;
+class Arg : public NodeOf<Opcode::Arg> {
  public:
-  std::string x;
-  std::string func;
+  Operand x;
+  Ident func;
   int k;
 
-  Arg(const std::string &x, const std::string &func, int k)
+  Arg(const Operand &x, Ident func, int k)
       : x(x), func(func), k(k) {}
 
-  static ArgPtr create(const std::string &x, const std::string &func, int k) {
-    return std::make_shared<Arg>(x, func, k);
+  static ArgPtr create(const Operand &x, Ident func, int k) {
+    return InstPool::current().create<Arg>(x, func, k);
   }
 
-  std::string to_string() const override { return "ARG " + x; }
+  void print(Writer &out) const override {
+    out << "ARG ";
+    x.print(out);
+  }
 };
 
 class Param;
-using ParamPtr = std::shared_ptr<Param>;
-class Param : public Node {
+using ParamPtr = Param *;
+class Param : public NodeOf<Opcode::Param> {
  public:
-  std::string x;
-  std::string func;
+  Operand x;
+  Ident func;
   int k;
 
-  Param(const std::string &x, const std::string &func, int k)
+  Param(const Operand &x, Ident func, int k)
       : x(x), func(func), k(k) {}
   
-  static ParamPtr create(const std::string &x, const std::string &func, int k) {
-    return std::make_shared<Param>(x, func, k);
+  static ParamPtr create(const Operand &x, Ident func, int k) {
+    return InstPool::current().create<Param>(x, func, k);
   }
 
-  std::string to_string() const override { return "PARAM " + x; }
+  void print(Writer &out) const override {
+    out << "PARAM ";
+    x.print(out);
+  }
 };
 
 class Return;
-using ReturnPtr = std::shared_ptr<Return>;
-class Return : public Node {
+using ReturnPtr = Return *;
+class Return : public NodeOf<Opcode::Return> {
  public:
-  std::string x;  // 返回值，空字符串表示无返回值
+  Operand x;  // 返回值，空操作数表示无返回值
 
-  Return(const std::string &x = "") : x(x) {}
+  Return(const Operand &x = Operand()) : x(x) {}
 
-  static ReturnPtr create(const std::string &x = "") {
-    return std::make_shared<Return>(x);
+  static ReturnPtr create(const Operand &x = Operand()) {
+    return InstPool::current().create<Return>(x);
   }
 
-  std::string to_string() const override {
-    if (x.empty()) {
-      return "RETURN";
+  void print(Writer &out) const override {
+    out << "RETURN";
+    if (!x.empty()) {
+      out << ' ';
+      x.print(out);
     }
-    return "RETURN " + x;
   }
 };
 
 class If;
-using IfPtr = std::shared_ptr<If>;
-class If : public Node {
+using IfPtr = If *;
+class If : public NodeOf<Opcode::If> {
  public:
   BinaryOp op;
-  std::string t1;
-  std::string t2;
-  std::string label;
-  If(const BinaryOp &op, const std::string &t1, const std::string &t2,
-     const std::string &label)
+  Operand t1;
+  Operand t2;
+  Ident label;
+  If(const BinaryOp &op, const Operand &t1, const Operand &t2,
+     Ident label)
       : op(op), t1(t1), t2(t2), label(label) {}
 
-  static IfPtr create(const BinaryOp &op, const std::string &t1,
-                      const std::string &t2, const std::string &label) {
-    return std::make_shared<If>(op, t1, t2, label);
+  static IfPtr create(const BinaryOp &op, const Operand &t1,
+                      const Operand &t2, Ident label) {
+    return InstPool::current().create<If>(op, t1, t2, label);
   }
 
-  std::string to_string() const override {
-    return "IF " + t1 + " " + op_to_string(op) + " " + t2 + " GOTO " + label;
+  void print(Writer &out) const override {
+    out << "IF ";
+    t1.print(out);
+    out << ' ' << op_to_string(op) << ' ';
+    t2.print(out);
+    out << " GOTO " << label.str();
   }
 };
 
 class Global;
-using GlobalPtr = std::shared_ptr<Global>;
-class Global : public Node {
+using GlobalPtr = Global *;
+class Global : public NodeOf<Opcode::Global> {
  public:
-  std::string name;
+  Ident name;
   int size;
   std::vector<int> values;
 
-  Global(const std::string &name, int size, const std::vector<int> &values = {})
+  Global(Ident name, int size, const std::vector<int> &values = {})
       : name(name), size(size), values(values) {
     if (values.empty()) {
       this->values = std::vector<int>(size / 4, 0);
@@ -263,122 +431,139 @@ class Global : public Node {
     }
   }
 
-  static GlobalPtr create(const std::string &name, int size, const std::vector<int> &values = {}) {
-    return std::make_shared<Global>(name, size, values);
+  static GlobalPtr create(Ident name, int size, const std::vector<int> &values = {}) {
+    return InstPool::current().create<Global>(name, size, values);
   }
 
-  std::string to_string() const override {
-    std::string values_str;
-    if (!values.empty()) {
-      values_str = " = " + std::accumulate(values.begin() + 1, values.end(),
-        "#" + std::to_string(values[0]),
-        [](const std::string &a, int b) { return a + ", #" + std::to_string(b); });
+  void print(Writer &out) const override {
+    out << "GLOBAL " << name.str() << ": #" << size;
+    for (size_t i = 0; i < values.size(); i++) {
+      out << (i == 0 ? " = #" : ", #") << values[i];
     }
-    return "GLOBAL " + name + ": #" + std::to_string(size) + values_str;
   }
 };
 
 class Dec;
-using DecPtr = std::shared_ptr<Dec>;
-class Dec : public Node {
+using DecPtr = Dec *;
+class Dec : public NodeOf<Opcode::Dec> {
  public:
-  std::string name;
+  Operand name;
   int size;
 
-  Dec(const std::string &name, int size) : name(name), size(size) {}
+  Dec(const Operand &name, int size) : name(name), size(size) {}
 
-  static DecPtr create(const std::string &name, int size) {
-    return std::make_shared<Dec>(name, size);
+  static DecPtr create(const Operand &name, int size) {
+    return InstPool::current().create<Dec>(name, size);
   }
 
-  std::string to_string() const override {
-    return "DEC " + name + " #" + std::to_string(size);
+  void print(Writer &out) const override {
+    out << "DEC ";
+    name.print(out);
+    out << " #" << size;
   }
 };
 
 class LoadAddr;
-using LoadAddrPtr = std::shared_ptr<LoadAddr>;
-class LoadAddr : public Node {
+using LoadAddrPtr = LoadAddr *;
+class LoadAddr : public NodeOf<Opcode::LoadAddr> {
  public:
-  std::string x;
-  std::string label;
+  Operand x;
+  Ident label;
 
-  LoadAddr(const std::string &x, const std::string &label) : x(x), label(label) {}
+  LoadAddr(const Operand &x, Ident label) : x(x), label(label) {}
 
-  static LoadAddrPtr create(const std::string &x, const std::string &label) {
-    return std::make_shared<LoadAddr>(x, label);
+  static LoadAddrPtr create(const Operand &x, Ident label) {
+    return InstPool::current().create<LoadAddr>(x, label);
   }
 
-  std::string to_string() const override {
-    return x + " = &" + label;
+  void print(Writer &out) const override {
+    x.print(out);
+    out << " = &" << label.str();
   }
 };
 
 class Store;
-using StorePtr = std::shared_ptr<Store>;
-class Store : public Node {
+using StorePtr = Store *;
+class Store : public NodeOf<Opcode::Store> {
  public:
-  std::string addr;
-  std::string value;
+  Operand addr;
+  Operand value;
   int offset;
 
-  Store(const std::string &addr, const std::string &value, int offset = 0)
+  Store(const Operand &addr, const Operand &value, int offset = 0)
       : addr(addr), value(value), offset(offset) {}
 
-  static StorePtr create(const std::string &addr, const std::string &value, int offset = 0) {
-    return std::make_shared<Store>(addr, value, offset);
+  static StorePtr create(const Operand &addr, const Operand &value, int offset = 0) {
+    return InstPool::current().create<Store>(addr, value, offset);
   }
 
-  std::string to_string() const override {
+  void print(Writer &out) const override {
     if (offset == 0) {
-      return "*" + addr + " = " + value;
+      out << '*';
+      addr.print(out);
+    } else {
+      out << "*(";
+      addr.print(out);
+      out << " + #" << offset << ')';
     }
-    return "*(" + addr + " + #" + std::to_string(offset) + ") = " + value;
+    out << " = ";
+    value.print(out);
   }
 };
 
 class Load;
-using LoadPtr = std::shared_ptr<Load>;
-class Load : public Node {
+using LoadPtr = Load *;
+class Load : public NodeOf<Opcode::Load> {
  public:
-  std::string x;
-  std::string addr;
+  Operand x;
+  Operand addr;
   int offset;
 
-  Load(const std::string &x, const std::string &addr, int offset = 0)
+  Load(const Operand &x, const Operand &addr, int offset = 0)
       : x(x), addr(addr), offset(offset) {}
 
-  static LoadPtr create(const std::string &x, const std::string &addr, int offset = 0) {
-    return std::make_shared<Load>(x, addr, offset);
+  static LoadPtr create(const Operand &x, const Operand &addr, int offset = 0) {
+    return InstPool::current().create<Load>(x, addr, offset);
   }
 
-  std::string to_string() const override {
+  void print(Writer &out) const override {
+    x.print(out);
     if (offset == 0) {
-      return x + " = *" + addr;
+      out << " = *";
+      addr.print(out);
+    } else {
+      out << " = *(";
+      addr.print(out);
+      out << " + #" << offset << ')';
     }
-    return x + " = *(" + addr + " + #" + std::to_string(offset) + ")";
   }
 };
 
-using Code = std::list<NodePtr>;
+using Code = IList<Node>;
+
+inline void print(Writer &out, const Node *node) {
+  switch (node->opcode) {
+    case Opcode::Function:
+    case Opcode::Global:
+      break;
+    case Opcode::Label:
+      out << "  ";
+      break;
+    default:
+      out << "    ";
+      break;
+  }
+  node->print(out);
+  out << '\n';
+}
 
 }  // namespace IR
 
-inline std::ostream &operator<<(std::ostream &os, const IR::Code &code) {
+inline Writer &operator<<(Writer &out, const IR::Code &code) {
   for (const auto &node : code) {
-    if (auto func = std::dynamic_pointer_cast<IR::Function>(node)) {
-      os << func->to_string() << std::endl;
-    } 
-    else if (auto global = std::dynamic_pointer_cast<IR::Global>(node)) {
-      os << global->to_string() << std::endl;
-    }
-    else if (auto label = std::dynamic_pointer_cast<IR::Label>(node)) {
-      os << "  " << label->to_string() << std::endl;
-    } else {
-      os << "    " << node->to_string() << std::endl;
-    }
+    IR::print(out, node);
   }
-  return os;
+  return out;
 }
 
 #endif  // IR_IR_HPP
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef IR_IR_BUILDER_HPP
+#define IR_IR_BUILDER_HPP
+
+#include "ir/ir.hpp"
+#include "support/inst_builder.hpp"
+
+namespace IR {
+
+/// @brief IR builder used by the translator
+using Builder = InstBuilder<Node>;
+
+}  // namespace IR
+
+#endif  // IR_IR_BUILDER_HPP
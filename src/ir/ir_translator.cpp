@@ -3,25 +3,48 @@
 #include <cassert>
 
 #include "../semantic/type_checker.hpp"
+#include "support/statistics.hpp"
 
-std::string IRTranslator::new_temp() {
-  static int temp_count = 0;
-  return "T" + std::to_string(temp_count++);
+IR::Operand IRTranslator::new_temp() {
+  return IR::Operand::temp(names->temp_count++);
 }
 
-std::string IRTranslator::new_label() {
-  static int label_count = 1;
-  return "label" + std::to_string(label_count++);
+InstPool &IRTranslator::new_pool() {
+  pools.push_back(std::make_unique<InstPool>());
+  return *pools.back();
+}
+
+Ident IRTranslator::new_label() {
+  // 标签在整个汇编文件中可见，所以加上函数名作为前缀
+  std::string label = names->prefix;
+  label += "label";
+  label += std::to_string(names->label_count++);
+  return Ident(label);
 }
 
 IR::Code IRTranslator::translate(AST::NodePtr node) {
-#define TRANSLATE_NODE(type)                                 \
-  if (auto n = std::dynamic_pointer_cast<AST::type>(node)) { \
-    return translate##type(n);                               \
+  IR::Code ir;
+  IR::Builder::Guard guard(builder);
+  builder.set_insert_point(ir);
+  translateNode(node);
+  return ir;
+}
+
+IR::Code IRTranslator::translateUnit(AST::NodePtr unit) {
+  if (unit->kind == AST::Kind::FuncDef) {
+    return translate(unit);  // translateFuncDef opens the function's pool
   }
-  // 递归翻译 AST 的每个节点
-  // 如果你添加了新的 AST 节点类型，记得在这里添加对应的翻译函数
+  InstPool::Scope scope(new_pool());
+  return translate(unit);
+}
 
+void IRTranslator::translateNode(AST::NodePtr node) {
+#define TRANSLATE_NODE(type) \
+  case AST::Kind::type:      \
+    return translate##type(static_cast<AST::type *>(node));
+  // 递归翻译 AST 的每个节点，按节点的 kind 分派
+  // 如果你添加了新的 AST 节点类型，记得在这里添加对应的翻译函数
+  switch (node->kind) {
   TRANSLATE_NODE(CompUnit)
   TRANSLATE_NODE(FuncDef)
   TRANSLATE_NODE(Block)
@@ -37,6 +60,9 @@ IR::Code IRTranslator::translate(AST::NodePtr node) {
 
   TRANSLATE_NODE(IfStmt)
   TRANSLATE_NODE(WhileStmt)
+  default:
+    break;
+  }
 
 #warning Add more AST node types if needed
 
@@ -46,18 +72,21 @@ IR::Code IRTranslator::translate(AST::NodePtr node) {
          "Unknown AST node type " + node->to_string() + " in IR translation");
 }
 
-IR::Code IRTranslator::translateExp(AST::NodePtr node,
-                                    const std::string &place) {
-#define TRANSLATE_EXP_NODE(type)                             \
-  if (auto n = std::dynamic_pointer_cast<AST::type>(node)) { \
-    return translate##type(n, place);                        \
-  }
+void IRTranslator::translateExp(AST::NodePtr node,
+                                const IR::Operand &place) {
+#define TRANSLATE_EXP_NODE(type) \
+  case AST::Kind::type:          \
+    return translate##type(static_cast<AST::type *>(node), place);
 
+  switch (node->kind) {
   TRANSLATE_EXP_NODE(BinaryExp)
   TRANSLATE_EXP_NODE(UnaryExp)
   TRANSLATE_EXP_NODE(FuncCall)
   TRANSLATE_EXP_NODE(IntConst)
   TRANSLATE_EXP_NODE(LVal)
+  default:
+    break;
+  }
 
 #warning Add more AST node types if needed
 
@@ -66,16 +95,20 @@ IR::Code IRTranslator::translateExp(AST::NodePtr node,
   ASSERT(false, "No translateExp for node " + node->to_string());
 }
 
-IR::Code IRTranslator::translateCond(AST::NodePtr node,
-                                     const std::string &label_true,
-                                     const std::string &label_false) {
-#define TRANSLATE_COND_NODE(type)                            \
-  if (auto n = std::dynamic_pointer_cast<AST::type>(node)) { \
-    return translateCond##type(n, label_true, label_false);  \
-  }
+void IRTranslator::translateCond(AST::NodePtr node,
+                                 Ident label_true,
+                                 Ident label_false) {
+#define TRANSLATE_COND_NODE(type)                                  \
+  case AST::Kind::type:                                            \
+    return translateCond##type(static_cast<AST::type *>(node),     \
+                               label_true, label_false);
 
+  switch (node->kind) {
   TRANSLATE_COND_NODE(BinaryExp)
   TRANSLATE_COND_NODE(UnaryExp)
+  default:
+    break;
+  }
 
 #undef TRANSLATE_COND_NODE
 
@@ -83,186 +116,137 @@ IR::Code IRTranslator::translateCond(AST::NodePtr node,
   return translateCondOther(node, label_true, label_false);
 }
 
-IR::Code IRTranslator::translateIfStmt(AST::IfStmtPtr node) {
-  IR::Code ir;
+void IRTranslator::translateIfStmt(AST::IfStmtPtr node) {
   if (!node->false_stmt) {
     auto label_true = new_label();
     auto label_false = new_label();
-    auto code1 = translateCond(node->cond, label_true, label_false);
-    auto code2 = translate(node->true_stmt);
-    // return code1 + [LABEL label1] + code2 + [LABEL label2]
-    auto LT = IR::Label::create(label_true);
-    auto LF = IR::Label::create(label_false);
-    std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-    ir.push_back(LT);
-    std::move(code2.begin(), code2.end(), std::back_inserter(ir));
-    ir.push_back(LF);
+    // code1 + [LABEL label1] + code2 + [LABEL label2]
+    translateCond(node->cond, label_true, label_false);
+    builder.emit<IR::Label>(label_true);
+    translateNode(node->true_stmt);
+    builder.emit<IR::Label>(label_false);
   }
 
   else {
     auto label_1 = new_label();
     auto label_2 = new_label();
     auto label_3 = new_label();
-    auto code1 = translateCond(node->cond, label_1, label_2);
-    auto code2 = translate(node->true_stmt);
-    auto code3 = translate(node->false_stmt);
-
-    auto L1 = IR::Label::create(label_1);
-    auto L2 = IR::Label::create(label_2);
-    auto L3 = IR::Label::create(label_3);
-    auto GOTO3 = IR::Goto::create(label_3);
-    std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-    ir.push_back(L1);
-    std::move(code2.begin(), code2.end(), std::back_inserter(ir));
-    ir.push_back(GOTO3);
-    ir.push_back(L2);
-    std::move(code3.begin(), code3.end(), std::back_inserter(ir));
-    ir.push_back(L3);
+    translateCond(node->cond, label_1, label_2);
+    builder.emit<IR::Label>(label_1);
+    translateNode(node->true_stmt);
+    builder.emit<IR::Goto>(label_3);
+    builder.emit<IR::Label>(label_2);
+    translateNode(node->false_stmt);
+    builder.emit<IR::Label>(label_3);
   }
-
-  return ir;
 }
 
-IR::Code IRTranslator::translateWhileStmt(AST::WhileStmtPtr node) {
-  IR::Code ir;
+void IRTranslator::translateWhileStmt(AST::WhileStmtPtr node) {
   auto label_1 = new_label();
   auto label_2 = new_label();
   auto label_3 = new_label();
-  auto code1 = translateCond(node->cond, label_2, label_3);
-  auto code2 = translate(node->stmt);
-
-  auto L1 = IR::Label::create(label_1);
-  auto L2 = IR::Label::create(label_2);
-  auto L3 = IR::Label::create(label_3);
-  auto GOTO1 = IR::Goto::create(label_1);
-  ir.push_back(L1);
-  std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-  ir.push_back(L2);
-  std::move(code2.begin(), code2.end(), std::back_inserter(ir));
-  ir.push_back(GOTO1);
-  ir.push_back(L3);
-  return ir;
+  builder.emit<IR::Label>(label_1);
+  translateCond(node->cond, label_2, label_3);
+  builder.emit<IR::Label>(label_2);
+  translateNode(node->stmt);
+  builder.emit<IR::Goto>(label_1);
+  builder.emit<IR::Label>(label_3);
 }
 
-IR::Code IRTranslator::translateCondBinaryExp(AST::BinaryExpPtr node,
-                                              const std::string &label_true,
-                                              const std::string &label_false) {
-  IR::Code ir;
+void IRTranslator::translateCondBinaryExp(AST::BinaryExpPtr node,
+                                          Ident label_true,
+                                          Ident label_false) {
   if (node->op == BinaryOp::And) {
     auto label1 = new_label();
-    auto code1 = translateCond(node->left, label1, label_false);
-    auto code2 = translateCond(node->right, label_true, label_false);
-    auto L1 = IR::Label::create(label1);
-    std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-    ir.push_back(L1);
-    std::move(code2.begin(), code2.end(), std::back_inserter(ir));
+    translateCond(node->left, label1, label_false);
+    builder.emit<IR::Label>(label1);
+    translateCond(node->right, label_true, label_false);
   } else if (node->op == BinaryOp::Or) {
     auto label1 = new_label();
-    auto code1 = translateCond(node->left, label_true, label1);
-    auto code2 = translateCond(node->right, label_true, label_false);
-    auto L1 = IR::Label::create(label1);
-    std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-    ir.push_back(L1);
-    std::move(code2.begin(), code2.end(), std::back_inserter(ir));
+    translateCond(node->left, label_true, label1);
+    builder.emit<IR::Label>(label1);
+    translateCond(node->right, label_true, label_false);
   } else if (node->op == BinaryOp::Eq || node->op == BinaryOp::Ne ||
              node->op == BinaryOp::Lt || node->op == BinaryOp::Le ||
              node->op == BinaryOp::Gt || node->op == BinaryOp::Ge) {
     // RELOP
     auto t1 = new_temp();
     auto t2 = new_temp();
-    auto code1 = translateExp(node->left, t1);
-    auto code2 = translateExp(node->right, t2);
-    auto if_ir = IR::If::create(node->op, t1, t2, label_true);
-    std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-    std::move(code2.begin(), code2.end(), std::back_inserter(ir));
-    ir.push_back(if_ir);
-    auto goto_false = IR::Goto::create(label_false);
-    ir.push_back(goto_false);
+    translateExp(node->left, t1);
+    translateExp(node->right, t2);
+    builder.emit<IR::If>(node->op, t1, t2, label_true);
+    builder.emit<IR::Goto>(label_false);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateCondUnaryExp(AST::UnaryExpPtr node,
-                                             const std::string &label_true,
-                                             const std::string &label_false) {
-  IR::Code ir;
+void IRTranslator::translateCondUnaryExp(AST::UnaryExpPtr node,
+                                         Ident label_true,
+                                         Ident label_false) {
   if (node->op == BinaryOp::Not) {
-    auto code = translateCond(node->exp, label_false, label_true);
-    std::move(code.begin(), code.end(), std::back_inserter(ir));
+    translateCond(node->exp, label_false, label_true);
   } else {
     translateCondOther(node, label_true, label_false);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateCondOther(AST::NodePtr node,
-                                          const std::string &label_true,
-                                          const std::string &label_false) {
-  IR::Code ir;
+void IRTranslator::translateCondOther(AST::NodePtr node,
+                                      Ident label_true,
+                                      Ident label_false) {
   auto t1 = new_temp();
-  auto code1 = translateExp(node, t1);
+  translateExp(node, t1);
   auto t2 = new_temp();
-  auto code2 = IR::LoadImm::create(t2, 0);
-  auto if_ir = IR::If::create(BinaryOp::Ne, t1, t2, label_true);
-  std::move(code1.begin(), code1.end(), std::back_inserter(ir));
-  ir.push_back(code2);
-  ir.push_back(if_ir);
-  auto goto_false = IR::Goto::create(label_false);
-  ir.push_back(goto_false);
-  return ir;
+  builder.emit<IR::LoadImm>(t2, 0);
+  builder.emit<IR::If>(BinaryOp::Ne, t1, t2, label_true);
+  builder.emit<IR::Goto>(label_false);
 }
 
-IR::Code IRTranslator::translateCompUnit(AST::CompUnitPtr node) {
-  IR::Code ir;
+void IRTranslator::translateCompUnit(AST::CompUnitPtr node) {
+  // 全局变量放在单独的 pool 中，每个函数在 translateFuncDef 中另开 pool
+  InstPool::Scope scope(new_pool());
   for (auto &unit : node->units) {
-    auto unit_ir = translate(unit);
-    std::move(unit_ir.begin(), unit_ir.end(), std::back_inserter(ir));
+    translateNode(unit);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateFuncDef(AST::FuncDefPtr node) {
-  IR::Code ir;
-  ir.push_back(IR::Function::create(node->name));
+void IRTranslator::translateFuncDef(AST::FuncDefPtr node) {
+  InstPool::Scope scope(new_pool());
+  // temp 和 label 在每个函数内从头编号
+  NameContext func_names(node->name.str() + ".");
+  NameContext *saved_names = names;
+  names = &func_names;
+  builder.emit<IR::Function>(node->name);
   if (node->params) {
     int k = 0;
     for (auto &param : node->params->params) {
-      ir.push_back(
-          IR::Param::create(param->symbol->unique_name, node->name, k++));
+      builder.emit<IR::Param>(
+          IR::Operand::name(param->symbol->unique_name), node->name, k++);
     }
   }
 
   ++scope_depth;  // Enter function scope
-  auto block_ir = translate(node->block);
+  translateNode(node->block);
   --scope_depth;  // Exit function scope
-
-  std::move(block_ir.begin(), block_ir.end(), std::back_inserter(ir));
-  return ir;
+  names = saved_names;
+  if (Statistics::global().is_enabled()) {
+    Statistics::global().add(node->name.str(), "ir.temps", func_names.temp_count);
+  }
 }
 
-IR::Code IRTranslator::translateBlock(AST::BlockPtr node) {
-  IR::Code ir;
+void IRTranslator::translateBlock(AST::BlockPtr node) {
   ++scope_depth;  // Enter block scope
   for (auto &stmt : node->stmts) {
-    auto stmt_ir = translate(stmt);
-    std::move(stmt_ir.begin(), stmt_ir.end(), std::back_inserter(ir));
+    translateNode(stmt);
   }
   --scope_depth;  // Exit block scope
-  return ir;
 }
 
-IR::Code IRTranslator::translateVarDecl(AST::VarDeclPtr node) {
-  IR::Code ir;
+void IRTranslator::translateVarDecl(AST::VarDeclPtr node) {
   for (auto &def : node->defs) {
-    auto def_ir = translate(def);
-    std::move(def_ir.begin(), def_ir.end(), std::back_inserter(ir));
+    translateNode(def);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateVarDef(AST::VarDefPtr node) {
-  IR::Code ir;
-
+void IRTranslator::translateVarDef(AST::VarDefPtr node) {
   // Calculate total size in bytes (4 bytes per int)
   int total_size = 4;
   // treat scalar global variable as 1-dimension array
@@ -281,20 +265,20 @@ IR::Code IRTranslator::translateVarDef(AST::VarDefPtr node) {
       // Extract initial values
       std::vector<AST::NodePtr> initvals = node->inits->inits;
       if (auto initlist =
-              std::dynamic_pointer_cast<AST::InitList>(node->inits->inits[0])) {
+              AST::dyn_cast<AST::InitList>(node->inits->inits[0])) {
         initvals = initlist->elements;
         for (auto &init : initvals) {
-          auto initval = std::dynamic_pointer_cast<AST::InitVal>(init);
+          auto initval = AST::dyn_cast<AST::InitVal>(init);
           if (auto int_const =
-                  std::dynamic_pointer_cast<AST::IntConst>(initval->inits[0])) {
+                  AST::dyn_cast<AST::IntConst>(initval->inits[0])) {
             values.push_back(int_const->value);
-          } else if (auto initlist = std::dynamic_pointer_cast<AST::InitList>(
+          } else if (auto initlist = AST::dyn_cast<AST::InitList>(
                          initval->inits[0])) {
             int sub_total_size = node->dim[node->dim.size() - 1];
             for (auto &val : initlist->elements) {
-              auto initval = std::dynamic_pointer_cast<AST::InitVal>(val);
+              auto initval = AST::dyn_cast<AST::InitVal>(val);
               auto int_const =
-                  std::dynamic_pointer_cast<AST::IntConst>(initval->inits[0]);
+                  AST::dyn_cast<AST::IntConst>(initval->inits[0]);
               values.push_back(int_const->value);
               sub_total_size--;
             }
@@ -304,157 +288,138 @@ IR::Code IRTranslator::translateVarDef(AST::VarDefPtr node) {
             }
           }
         }
-      } else if (auto initval = std::dynamic_pointer_cast<AST::IntConst>(
+      } else if (auto initval = AST::dyn_cast<AST::IntConst>(
                      node->inits->inits[0])) {
         values.push_back(initval->value);
       }
     }
-    ir.push_back(
-        IR::Global::create(node->symbol->unique_name, total_size, values));
+    builder.emit<IR::Global>(node->symbol->unique_name, total_size, values);
   }
   // Local variable
   else {
     if (node->dim.empty()) {
       // Scalar local variable
       if (!node->inits) {
-        return ir;
+        return;
       }
-      auto init_ir =
-          translateExp(node->inits->inits[0], node->symbol->unique_name);
-      std::move(init_ir.begin(), init_ir.end(), std::back_inserter(ir));
+      translateExp(node->inits->inits[0],
+                                  IR::Operand::name(node->symbol->unique_name));
     } else {
       // Local array
-      ir.push_back(IR::Dec::create(node->symbol->unique_name, total_size));
+      builder.emit<IR::Dec>(
+          IR::Operand::name(node->symbol->unique_name), total_size);
       if (node->inits) {
         // Initialize array elements
-        // for (size_t i = 0; i < node->inits->inits.size(); ++i) {
-        //   auto temp = new_temp();
-        //   auto init_ir = translateExp(node->inits->inits[i], temp);
-        //   std::move(init_ir.begin(), init_ir.end(), std::back_inserter(ir));
-        //   ir.push_back(IR::Store::create(node->symbol->unique_name, temp, i *
-        //   4));
-        // }
-        auto init_ir = translateInitVal(node->inits, node->symbol->unique_name,
-                                        total_size, node->dim);
-        std::move(init_ir.begin(), init_ir.end(), std::back_inserter(ir));
+        translateInitVal(
+            node->inits, IR::Operand::name(node->symbol->unique_name),
+            total_size, node->dim);
       }
     }
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateAssignStmt(AST::AssignStmtPtr node) {
-  IR::Code ir;
+void IRTranslator::translateAssignStmt(AST::AssignStmtPtr node) {
   auto lnode = node->lval;
   auto rnode = node->exp;
 
   if (lnode->indexes.empty()) {
     // Scalar assignment
-    if (lnode->symbol->unique_name.find("_in_0") != std::string::npos) {
+    if (lnode->symbol->unique_name.str().find("_in_0") != std::string::npos) {
       // Global variable assignment
       auto addr_temp = new_temp();
-      ir.push_back(IR::LoadAddr::create(addr_temp, lnode->symbol->unique_name));
+      builder.emit<IR::LoadAddr>(addr_temp, lnode->symbol->unique_name);
       auto value_temp = new_temp();
-      auto value_ir = translateExp(rnode, value_temp);
-      std::move(value_ir.begin(), value_ir.end(), std::back_inserter(ir));
-      ir.push_back(IR::Store::create(addr_temp, value_temp, 0));
+      translateExp(rnode, value_temp);
+      builder.emit<IR::Store>(addr_temp, value_temp, 0);
     } else {
       // Local variable assignment
       auto value_temp = new_temp();
-      auto value_ir = translateExp(rnode, value_temp);
-      std::move(value_ir.begin(), value_ir.end(), std::back_inserter(ir));
-      ir.push_back(IR::Assign::create(lnode->symbol->unique_name, value_temp));
+      translateExp(rnode, value_temp);
+      builder.emit<IR::Assign>(
+          IR::Operand::name(lnode->symbol->unique_name), value_temp);
     }
 
   } else {
     // Array assignment
     auto value_temp = new_temp();
-    auto value_ir = translateExp(rnode, value_temp);
-    std::move(value_ir.begin(), value_ir.end(), std::back_inserter(ir));
+    translateExp(rnode, value_temp);
 
-    if (lnode->symbol->unique_name.find("_in_0") != std::string::npos) {
+    if (lnode->symbol->unique_name.str().find("_in_0") != std::string::npos) {
       // Global array assignment
       auto addr_temp = new_temp();
-      ir.push_back(IR::LoadAddr::create(addr_temp, lnode->symbol->unique_name));
+      builder.emit<IR::LoadAddr>(addr_temp, lnode->symbol->unique_name);
 
       // Calculate offset
       auto offset_temp = new_temp();
-      ir.push_back(IR::LoadImm::create(offset_temp, 0));
+      builder.emit<IR::LoadImm>(offset_temp, 0);
       for (size_t i = 0; i < lnode->indexes.size(); ++i) {
         auto index_temp = new_temp();
-        auto index_ir = translateExp(lnode->indexes[i], index_temp);
-        std::move(index_ir.begin(), index_ir.end(), std::back_inserter(ir));
+        translateExp(lnode->indexes[i], index_temp);
 
         // Multiply from dim[i+1] to dim[n-1]
         for (size_t j = i + 1; j < lnode->dims.size(); ++j) {
           auto mul_temp = new_temp();
-          ir.push_back(
-              IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul,
-                                 '#' + std::to_string(lnode->dims[j])));
+          builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                   IR::Operand::imm(lnode->dims[j]));
           index_temp = mul_temp;
         }
 
         // Multiply by 4 for int size
         auto mul_temp = new_temp();
-        ir.push_back(
-            IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul, "#4"));
+        builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                 IR::Operand::imm(4));
 
         // Add to offset
         auto add_temp = new_temp();
-        ir.push_back(
-            IR::Binary::create(add_temp, offset_temp, BinaryOp::Add, mul_temp));
+        builder.emit<IR::Binary>(add_temp, offset_temp, BinaryOp::Add,
+                                 mul_temp);
         offset_temp = add_temp;
       }
 
       // Store value at offset
       auto final_addr = new_temp();
-      ir.push_back(IR::Binary::create(final_addr, addr_temp, BinaryOp::Add,
-                                      offset_temp));
-      ir.push_back(IR::Store::create(final_addr, value_temp, 0));
+      builder.emit<IR::Binary>(final_addr, addr_temp, BinaryOp::Add,
+                               offset_temp);
+      builder.emit<IR::Store>(final_addr, value_temp, 0);
     } else {
       // Local array assignment
       auto offset_temp = new_temp();
-      ir.push_back(IR::LoadImm::create(offset_temp, 0));
+      builder.emit<IR::LoadImm>(offset_temp, 0);
       for (size_t i = 0; i < lnode->indexes.size(); ++i) {
         auto index_temp = new_temp();
-        auto index_ir = translateExp(lnode->indexes[i], index_temp);
-        std::move(index_ir.begin(), index_ir.end(), std::back_inserter(ir));
+        translateExp(lnode->indexes[i], index_temp);
 
         // Multiply from dim[i+1] to dim[n-1]
         for (size_t j = i + 1; j < lnode->dims.size(); ++j) {
           auto mul_temp = new_temp();
-          ir.push_back(
-              IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul,
-                                 '#' + std::to_string(lnode->dims[j])));
+          builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                   IR::Operand::imm(lnode->dims[j]));
           index_temp = mul_temp;
         }
 
         // Multiply by 4 for int size
         auto mul_temp = new_temp();
-        ir.push_back(
-            IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul, "#4"));
+        builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                 IR::Operand::imm(4));
 
         // Add to offset
         auto add_temp = new_temp();
-        ir.push_back(
-            IR::Binary::create(add_temp, offset_temp, BinaryOp::Add, mul_temp));
+        builder.emit<IR::Binary>(add_temp, offset_temp, BinaryOp::Add,
+                                 mul_temp);
         offset_temp = add_temp;
       }
 
       // Store value at offset
       auto final_addr = new_temp();
-      ir.push_back(IR::Binary::create(final_addr, lnode->symbol->unique_name,
-                                      BinaryOp::Add, offset_temp));
-      ir.push_back(IR::Store::create(final_addr, value_temp, 0));
+      builder.emit<IR::Binary>(
+          final_addr, IR::Operand::name(lnode->symbol->unique_name),
+          BinaryOp::Add, offset_temp);
+      builder.emit<IR::Store>(final_addr, value_temp, 0);
     }
   }
-
-  return ir;
 }
 
-IR::Code IRTranslator::translateReturnStmt(AST::ReturnStmtPtr node) {
-  IR::Code ir;
-
+void IRTranslator::translateReturnStmt(AST::ReturnStmtPtr node) {
   // 翻译返回值
   // 如果有返回值，则：
   // place = new_temp();
@@ -464,265 +429,231 @@ IR::Code IRTranslator::translateReturnStmt(AST::ReturnStmtPtr node) {
   // return [RETURN];
 
   if (!node->exp) {
-    ir.push_back(IR::Return::create());
+    builder.emit<IR::Return>();
   } else {
     auto place = new_temp();
-    auto exp_ir = translateExp(node->exp, place);
-    std::move(exp_ir.begin(), exp_ir.end(), std::back_inserter(ir));
-    ir.push_back(IR::Return::create(place));
+    translateExp(node->exp, place);
+    builder.emit<IR::Return>(place);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateLVal(AST::LValPtr node,
-                                     const std::string &place) {
-  IR::Code ir;
+void IRTranslator::translateLVal(AST::LValPtr node,
+                                 const IR::Operand &place) {
   if (!place.empty()) {
     if (node->indexes.empty()) {
       // Scalar variable
       // if node->symbol->unique_name contrains "_in_0", it is a global variable
-      if (node->symbol->unique_name.find("_in_0") != std::string::npos) {
+      if (node->symbol->unique_name.str().find("_in_0") != std::string::npos) {
         // Global variable
         auto addr_temp = new_temp();
-        ir.push_back(
-            IR::LoadAddr::create(addr_temp, node->symbol->unique_name));
-        ir.push_back(IR::Load::create(place, addr_temp, 0));
+        builder.emit<IR::LoadAddr>(addr_temp, node->symbol->unique_name);
+        builder.emit<IR::Load>(place, addr_temp, 0);
       } else {
         // Local variable
-        ir.push_back(IR::Assign::create(place, node->symbol->unique_name));
+        builder.emit<IR::Assign>(
+            place, IR::Operand::name(node->symbol->unique_name));
       }
 
     } else {
       // Array access
-      if (node->symbol->unique_name.find("_in_0") != std::string::npos) {
+      if (node->symbol->unique_name.str().find("_in_0") != std::string::npos) {
         // Global array access
         auto addr_temp = new_temp();
-        ir.push_back(
-            IR::LoadAddr::create(addr_temp, node->symbol->unique_name));
+        builder.emit<IR::LoadAddr>(addr_temp, node->symbol->unique_name);
 
         // Calculate offset
         auto offset_temp = new_temp();
-        ir.push_back(IR::LoadImm::create(offset_temp, 0));
+        builder.emit<IR::LoadImm>(offset_temp, 0);
         for (size_t i = 0; i < node->indexes.size(); ++i) {
           auto index_temp = new_temp();
-          auto index_ir = translateExp(node->indexes[i], index_temp);
-          std::move(index_ir.begin(), index_ir.end(), std::back_inserter(ir));
+          translateExp(node->indexes[i], index_temp);
 
           // Multiply from dim[i+1] to dim[n-1]
           for (size_t j = i + 1; j < node->dims.size(); ++j) {
             auto mul_temp = new_temp();
-            ir.push_back(
-                IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul,
-                                   '#' + std::to_string(node->dims[j])));
+            builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                     IR::Operand::imm(node->dims[j]));
             index_temp = mul_temp;
           }
 
           // Multiply by 4 for int size
           auto mul_temp = new_temp();
-          ir.push_back(
-              IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul, "#4"));
+          builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                   IR::Operand::imm(4));
 
           // Add to offset
           auto add_temp = new_temp();
-          ir.push_back(IR::Binary::create(add_temp, offset_temp, BinaryOp::Add,
-                                          mul_temp));
+          builder.emit<IR::Binary>(add_temp, offset_temp, BinaryOp::Add,
+                                   mul_temp);
           offset_temp = add_temp;
         }
 
         // Load value at offset
         if (node->dims.size() == node->indexes.size()) {
           auto final_addr = new_temp();
-          ir.push_back(IR::Binary::create(final_addr, addr_temp, BinaryOp::Add,
-                                          offset_temp));
-          ir.push_back(IR::Load::create(place, final_addr, 0));
+          builder.emit<IR::Binary>(final_addr, addr_temp, BinaryOp::Add,
+                                   offset_temp);
+          builder.emit<IR::Load>(place, final_addr, 0);
         } else {
           auto final_addr = new_temp();
-          ir.push_back(IR::Binary::create(final_addr, addr_temp, BinaryOp::Add,
-                                          offset_temp));
-          ir.push_back(IR::Assign::create(place, final_addr));
+          builder.emit<IR::Binary>(final_addr, addr_temp, BinaryOp::Add,
+                                   offset_temp);
+          builder.emit<IR::Assign>(place, final_addr);
         }
 
       } else {
         // Local array access
         auto offset_temp = new_temp();
-        ir.push_back(IR::LoadImm::create(offset_temp, 0));
+        builder.emit<IR::LoadImm>(offset_temp, 0);
         for (size_t i = 0; i < node->indexes.size(); ++i) {
           auto index_temp = new_temp();
-          auto index_ir = translateExp(node->indexes[i], index_temp);
-          std::move(index_ir.begin(), index_ir.end(), std::back_inserter(ir));
+          translateExp(node->indexes[i], index_temp);
 
           // Multiply from dim[i+1] to dim[n-1]
           for (size_t j = i + 1; j < node->dims.size(); ++j) {
             auto mul_temp = new_temp();
-            ir.push_back(
-                IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul,
-                                   '#' + std::to_string(node->dims[j])));
+            builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                     IR::Operand::imm(node->dims[j]));
             index_temp = mul_temp;
           }
 
           // Multiply by 4 for int size
           auto mul_temp = new_temp();
-          ir.push_back(
-              IR::Binary::create(mul_temp, index_temp, BinaryOp::Mul, "#4"));
+          builder.emit<IR::Binary>(mul_temp, index_temp, BinaryOp::Mul,
+                                   IR::Operand::imm(4));
 
           // Add to offset
           auto add_temp = new_temp();
-          ir.push_back(IR::Binary::create(add_temp, offset_temp, BinaryOp::Add,
-                                          mul_temp));
+          builder.emit<IR::Binary>(add_temp, offset_temp, BinaryOp::Add,
+                                   mul_temp);
           offset_temp = add_temp;
         }
 
         // Load value at offset
         if (node->dims.size() == node->indexes.size()) {
           auto final_addr = new_temp();
-          ir.push_back(IR::Binary::create(final_addr, node->symbol->unique_name,
-                                          BinaryOp::Add, offset_temp));
-          ir.push_back(IR::Load::create(place, final_addr, 0));
+          builder.emit<IR::Binary>(
+              final_addr, IR::Operand::name(node->symbol->unique_name),
+              BinaryOp::Add, offset_temp);
+          builder.emit<IR::Load>(place, final_addr, 0);
         } else {
           auto final_addr = new_temp();
-          ir.push_back(IR::Binary::create(final_addr, node->symbol->unique_name,
-                                          BinaryOp::Add, offset_temp));
-          ir.push_back(IR::Assign::create(place, final_addr));
+          builder.emit<IR::Binary>(
+              final_addr, IR::Operand::name(node->symbol->unique_name),
+              BinaryOp::Add, offset_temp);
+          builder.emit<IR::Assign>(place, final_addr);
         }
       }
     }
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateBinaryExp(AST::BinaryExpPtr node,
-                                          const std::string &place) {
-  IR::Code ir;
+void IRTranslator::translateBinaryExp(AST::BinaryExpPtr node,
+                                      const IR::Operand &place) {
   auto left_place = new_temp();
   auto right_place = new_temp();
 
   // 翻译左右子表达式
-  auto left_ir = translateExp(node->left, left_place);
-  auto right_ir = translateExp(node->right, right_place);
-
-  std::move(left_ir.begin(), left_ir.end(), std::back_inserter(ir));
-  std::move(right_ir.begin(), right_ir.end(), std::back_inserter(ir));
+  translateExp(node->left, left_place);
+  translateExp(node->right, right_place);
 
   // 添加二元运算指令
   if (!place.empty()) {
-    ir.push_back(IR::Binary::create(place, left_place, node->op, right_place));
+    builder.emit<IR::Binary>(place, left_place, node->op, right_place);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateUnaryExp(AST::UnaryExpPtr node,
-                                         const std::string &place) {
-  IR::Code ir;
-
+void IRTranslator::translateUnaryExp(AST::UnaryExpPtr node,
+                                     const IR::Operand &place) {
   // 翻译子表达式
   // 如果 place 不为空，则将 UnaryExp 的值赋给 place
 
   auto exp_place = new_temp();
-  auto exp_ir = translateExp(node->exp, exp_place);
-  std::move(exp_ir.begin(), exp_ir.end(), std::back_inserter(ir));
+  translateExp(node->exp, exp_place);
 
   if (!place.empty()) {
-    ir.push_back(IR::Unary::create(place, node->op, exp_place));
+    builder.emit<IR::Unary>(place, node->op, exp_place);
   }
-
-  return ir;
 }
 
-IR::Code IRTranslator::translateFuncCall(AST::FuncCallPtr node,
-                                         const std::string &place) {
-  IR::Code ir;
-  std::vector<std::string> arg_places;
+void IRTranslator::translateFuncCall(AST::FuncCallPtr node,
+                                     const IR::Operand &place) {
+  std::vector<IR::Operand> arg_places;
 
   // 首先翻译参数表达式，并存在临时变量中
   // 接下来，添加参数传递指令和函数调用指令
   // 如果 place 不为空，则将函数调用的返回值赋给 place
-  IR::Code func_args_ir;
   auto func_args = node->args;
   auto func_type = std::dynamic_pointer_cast<FuncType>(node->symbol->type);
   auto param_types = func_type->param_types;
   for (int i = 0; i < func_args.size(); i++) {
-    std::string arg_place;
+    IR::Operand arg_place;
     if (auto array_type =
             std::dynamic_pointer_cast<ArrayType>(param_types[i]) &&
-            func_args[i]->symbol->unique_name.find("_in_0") !=
+            func_args[i]->symbol->unique_name.str().find("_in_0") !=
                 std::string::npos) {
       // 全局数组参数
       arg_place = new_temp();
-      func_args_ir.push_back(
-          IR::LoadAddr::create(arg_place, func_args[i]->symbol->unique_name));
+      builder.emit<IR::LoadAddr>(arg_place,
+                                 func_args[i]->symbol->unique_name);
     } else {
       arg_place = new_temp();
-      auto arg_ir = translateExp(func_args[i], arg_place);
-      std::move(arg_ir.begin(), arg_ir.end(), std::back_inserter(func_args_ir));
+      translateExp(func_args[i], arg_place);
     }
     arg_places.push_back(arg_place);
   }
   int index = 0;
   for (auto &arg_place : arg_places) {
     // 添加参数传递指令
-    func_args_ir.push_back(IR::Arg::create(arg_place, node->name, index++));
+    builder.emit<IR::Arg>(arg_place, node->name, index++);
   }
 
-  std::move(func_args_ir.begin(), func_args_ir.end(), std::back_inserter(ir));
-
   if (!place.empty()) {
-    ir.push_back(IR::Call::create(place, node->name));
+    builder.emit<IR::Call>(place, node->name);
   } else {
-    ir.push_back(IR::Call::create(node->name));
+    builder.emit<IR::Call>(node->name);
   }
-
-  return ir;
 }
 
-IR::Code IRTranslator::translateIntConst(AST::IntConstPtr node,
-                                         const std::string &place) {
-  IR::Code ir;
+void IRTranslator::translateIntConst(AST::IntConstPtr node,
+                                     const IR::Operand &place) {
   // 添加赋值常量指令
   if (!place.empty()) {
-    ir.push_back(IR::LoadImm::create(place, node->value));
+    builder.emit<IR::LoadImm>(place, node->value);
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateInitList(AST::InitListPtr node,
-                                         const std::string &init_addr,
-                                         int total_size, int offset,
-                                         std::vector<int> &dims) {
+void IRTranslator::translateInitList(AST::InitListPtr node,
+                                     const IR::Operand &init_addr,
+                                     int total_size, int offset,
+                                     std::vector<int> &dims) {
   int filled_elements = 0;
   int total_elements = total_size / 4;
-  IR::Code ir;
   auto elements = node->elements;
   for (auto element : elements) {
-    auto initval = std::dynamic_pointer_cast<AST::InitVal>(element);
+    auto initval = AST::dyn_cast<AST::InitVal>(element);
     if (auto int_const =
-            std::dynamic_pointer_cast<AST::IntConst>(initval->inits[0])) {
+            AST::dyn_cast<AST::IntConst>(initval->inits[0])) {
       auto value = int_const->value;
-      std::cout << "value:" << value << std::endl;
       auto temp = new_temp();
-      ir.push_back(IR::LoadImm::create(temp, value));
-      ir.push_back(
-          IR::Store::create(init_addr, temp, filled_elements * 4 + offset));
+      builder.emit<IR::LoadImm>(temp, value);
+      builder.emit<IR::Store>(init_addr, temp, filled_elements * 4 + offset);
       ++filled_elements;
     }
-    if (auto lval = std::dynamic_pointer_cast<AST::LVal>(initval->inits[0])) {
+    if (auto lval = AST::dyn_cast<AST::LVal>(initval->inits[0])) {
       auto temp = new_temp();
-      auto lval_ir = translateLVal(lval, temp);
-      std::move(lval_ir.begin(), lval_ir.end(), std::back_inserter(ir));
-      ir.push_back(
-          IR::Store::create(init_addr, temp, filled_elements * 4 + offset));
+      translateLVal(lval, temp);
+      builder.emit<IR::Store>(init_addr, temp, filled_elements * 4 + offset);
       ++filled_elements;
     }
     // 处理嵌套的初值列表
     if (auto initlist =
-            std::dynamic_pointer_cast<AST::InitList>(initval->inits[0])) {
+            AST::dyn_cast<AST::InitList>(initval->inits[0])) {
       // 遇到嵌套的初值列表时，根据已经填充的元素数决定该初值列表对应的子数组，并尽量选择更大的子数组
       // 已填充的元素数要能被将要填充的子数组的总元素数整除，在此基础上选择可以填充的最大子数组
       for (int i = 1; i < dims.size(); ++i) {
         // 截取子数组
         auto sub_array = std::vector<int>(dims.begin() + i, dims.end());
-        for (int dim : sub_array) {
-          std::cout << "sub_array dim:" << dim << std::endl;
-        }
         int sub_array_total_size = 1;
         for (int dim : sub_array) {
           sub_array_total_size *= dim;
@@ -730,10 +661,8 @@ IR::Code IRTranslator::translateInitList(AST::InitListPtr node,
         if (filled_elements % sub_array_total_size == 0) {
           // 计算子数组的起始地址(offset)
           auto sub_init_addr_offset = filled_elements * 4;
-          auto init_ir =
-              translateInitList(initlist, init_addr, sub_array_total_size * 4,
-                                sub_init_addr_offset, sub_array);
-          std::move(init_ir.begin(), init_ir.end(), std::back_inserter(ir));
+          translateInitList(initlist, init_addr, sub_array_total_size * 4,
+                            sub_init_addr_offset, sub_array);
           filled_elements += sub_array_total_size;
           break;
         }
@@ -743,27 +672,19 @@ IR::Code IRTranslator::translateInitList(AST::InitListPtr node,
   // Fill remaining elements with 0
   for (int i = filled_elements; i < total_elements; ++i) {
     auto temp = new_temp();
-    ir.push_back(IR::LoadImm::create(temp, 0));
-    ir.push_back(IR::Store::create(init_addr, temp, i * 4 + offset));
+    builder.emit<IR::LoadImm>(temp, 0);
+    builder.emit<IR::Store>(init_addr, temp, i * 4 + offset);
     ++filled_elements;
   }
-  return ir;
 }
 
-IR::Code IRTranslator::translateInitVal(AST::InitValPtr node,
-                                        const std::string &init_addr,
-                                        int total_size,
-                                        std::vector<int> &dims) {
-  IR::Code ir;
+void IRTranslator::translateInitVal(AST::InitValPtr node,
+                                    const IR::Operand &init_addr,
+                                    int total_size,
+                                    std::vector<int> &dims) {
   auto val = node->inits[0];
-  if (auto initlist = std::dynamic_pointer_cast<AST::InitList>(val)) {
+  if (auto initlist = AST::dyn_cast<AST::InitList>(val)) {
     // 处理初始化列表
-    std::cout << "init_addr:" << init_addr << std::endl;
-    std::cout << "initlist size:" << initlist->elements.size() << std::endl;
-    std::cout << "total_size:" << total_size << std::endl;
-    auto init_ir = translateInitList(initlist, init_addr, total_size, 0, dims);
-
-    std::move(init_ir.begin(), init_ir.end(), std::back_inserter(ir));
+    translateInitList(initlist, init_addr, total_size, 0, dims);
   }
-  return ir;
 }
@@ -2,60 +2,94 @@
 #define IR_IR_TRANSLATOR_HPP
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "ast/tree.hpp"
 #include "ir/ir.hpp"
+#include "ir/ir_builder.hpp"
 
 class IRTranslator {
  public:
+  /// @brief translate a tree into a fresh Code list
   IR::Code translate(AST::NodePtr node);
-  IR::Code translateExp(AST::NodePtr node, const std::string &place = "");
-  IR::Code translateCond(AST::NodePtr node, const std::string &label_true, 
-                                            const std::string &label_false);
+  /// @brief translate one top-level FuncDef or global VarDecl on its own,
+  /// for streaming; every unit gets its own pool, see take_pools()
+  IR::Code translateUnit(AST::NodePtr unit);
+
+  /// @brief hand over the pools that own the translated instructions
+  /// one pool per function plus one for the globals
+  std::vector<std::unique_ptr<InstPool>> take_pools() {
+    return std::move(pools);
+  }
+  // 以下翻译函数都把指令直接追加到 builder 的插入点，不再返回 Code
+  void translateExp(AST::NodePtr node, const IR::Operand &place = IR::Operand());
+  void translateCond(AST::NodePtr node, Ident label_true,
+                     Ident label_false);
  private:
-  IR::Code translateCompUnit(AST::CompUnitPtr node);
-  IR::Code translateFuncDef(AST::FuncDefPtr node);
-  IR::Code translateBlock(AST::BlockPtr node);
-  IR::Code translateVarDecl(AST::VarDeclPtr node);
-  IR::Code translateVarDef(AST::VarDefPtr node);
-  IR::Code translateAssignStmt(AST::AssignStmtPtr node);
-  IR::Code translateReturnStmt(AST::ReturnStmtPtr node);
-  IR::Code translateIfStmt(AST::IfStmtPtr node);
-  IR::Code translateWhileStmt(AST::WhileStmtPtr node);
-  IR::Code translateLVal(AST::LValPtr node, const std::string &place = "");
-  IR::Code translateBinaryExp(AST::BinaryExpPtr node,
-                              const std::string &place = "");
-  IR::Code translateUnaryExp(AST::UnaryExpPtr node,
-                             const std::string &place = "");
-  IR::Code translateFuncCall(AST::FuncCallPtr node,
-                             const std::string &place = "");
-  IR::Code translateIntConst(AST::IntConstPtr node,
-                             const std::string &place = "");
+  void translateNode(AST::NodePtr node);
+  void translateCompUnit(AST::CompUnitPtr node);
+  void translateFuncDef(AST::FuncDefPtr node);
+  void translateBlock(AST::BlockPtr node);
+  void translateVarDecl(AST::VarDeclPtr node);
+  void translateVarDef(AST::VarDefPtr node);
+  void translateAssignStmt(AST::AssignStmtPtr node);
+  void translateReturnStmt(AST::ReturnStmtPtr node);
+  void translateIfStmt(AST::IfStmtPtr node);
+  void translateWhileStmt(AST::WhileStmtPtr node);
+  void translateLVal(AST::LValPtr node, const IR::Operand &place = IR::Operand());
+  void translateBinaryExp(AST::BinaryExpPtr node,
+                          const IR::Operand &place = IR::Operand());
+  void translateUnaryExp(AST::UnaryExpPtr node,
+                         const IR::Operand &place = IR::Operand());
+  void translateFuncCall(AST::FuncCallPtr node,
+                         const IR::Operand &place = IR::Operand());
+  void translateIntConst(AST::IntConstPtr node,
+                         const IR::Operand &place = IR::Operand());
 
   // 翻译函数参数
-  IR::Code translateFuncFParam(AST::FuncFParamPtr node,
-                               const std::string &place = "");
+  void translateFuncFParam(AST::FuncFParamPtr node,
+                           const IR::Operand &place = IR::Operand());
+
+  void translateCondBinaryExp(AST::BinaryExpPtr node,
+                              Ident label_true,
+                              Ident label_false);
 
-  IR::Code translateCondBinaryExp(AST::BinaryExpPtr node,
-                                  const std::string &label_true,
-                                  const std::string &label_false);
+  void translateCondUnaryExp(AST::UnaryExpPtr node,
+                             Ident label_true,
+                             Ident label_false);
 
-  IR::Code translateCondUnaryExp(AST::UnaryExpPtr node,
-                                 const std::string &label_true,
-                                 const std::string &label_false);
+  void translateCondOther(AST::NodePtr node,
+                          Ident label_true,
+                          Ident label_false);
 
-  IR::Code translateCondOther(AST::NodePtr node,
-                              const std::string &label_true,
-                              const std::string &label_false);
+  void translateInitVal(AST::InitValPtr node, const IR::Operand &place, int total_size, std::vector<int> &dims);
+  void translateInitList(AST::InitListPtr node, const IR::Operand &place, int total_size, int offset, std::vector<int> &dims);
 
-  IR::Code translateInitVal(AST::InitValPtr node, const std::string &place, int total_size, std::vector<int> &dims);
-  IR::Code translateInitList(AST::InitListPtr node, const std::string &place, int total_size, int offset, std::vector<int> &dims);
+  /// @brief numbering state of the function being translated
+  /// names only depend on the function itself, so translating functions in
+  /// any order (or on different translators) gives the same output
+  struct NameContext {
+    explicit NameContext(std::string prefix = "") : prefix(std::move(prefix)) {}
+    std::string prefix;  // label prefix, "<func>."
+    int temp_count = 0;
+    int label_count = 1;
+  };
+  NameContext module_names;
+  NameContext *names = &module_names;
 
-  std::string new_temp();
-  std::string new_label();
+  IR::Operand new_temp();
+  Ident new_label();
 
   int scope_depth = 0;  // Track whether we're in global or local scope
+
+  /// @brief where the translate functions put their instructions
+  IR::Builder builder;
+
+  std::vector<std::unique_ptr<InstPool>> pools;
+  /// @brief make a fresh pool for the next function or for the globals
+  InstPool &new_pool();
 };
 
 #endif  // IR_IR_TRANSLATOR_HPP
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "fast_lexer.hpp"
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "parser/parser.tab.hh"
+
+namespace {
+
+/// @brief 与 strtol 相同的转换：溢出时取 LONG_MAX，再像 lexer.l 一样截断成 int
+int to_int(const char *p, const char *end, int base) {
+  unsigned long value = 0;
+  for (; p < end; p++) {
+    unsigned digit = *p <= '9' ? *p - '0' : (*p | 0x20) - 'a' + 10;
+    if (value > (static_cast<unsigned long>(LONG_MAX) - digit) / base) {
+      value = LONG_MAX;
+      break;
+    }
+    value = value * base + digit;
+  }
+  return static_cast<int>(static_cast<long>(value));
+}
+
+struct Keyword {
+  const char *text;
+  size_t length;
+  int code;
+};
+
+const Keyword keywords[] = {
+    {"if", 2, IF},         {"else", 4, ELSE}, {"while", 5, WHILE},
+    {"return", 6, RETURN}, {"int", 3, INT},   {"void", 4, VOID},
+};
+
+}  // namespace
+
+FastLexer::Isa FastLexer::best_isa() {
+  if (scan_kernels(Isa::AVX2)) return Isa::AVX2;
+  if (scan_kernels(Isa::SSE2)) return Isa::SSE2;
+  return Isa::Scalar;
+}
+
+FastLexer::FastLexer(const char *begin, const char *end, Isa isa)
+    : begin(begin), cur(begin), end(end) {
+  kernels = scan_kernels(isa);
+  if (!kernels) {
+    kernels = scan_kernels(Isa::Scalar);
+  }
+}
+
+const char *FastLexer::block_comment_end(const char *p, int &lines) const {
+  // lexer.l 中的注释是 \/\*([^*]|\*[^/])*\*\/：紧接着 '/' 的一串 '*' 中，
+  // 只有长度为奇数时最后一个 '*' 才能与 '/' 组成结尾，否则 '*' 会被
+  // \*[^/] 两两吃掉，注释继续
+  for (;;) {
+    p = kernels->find_star(p, end, lines);
+    const char *stars = p;
+    while (p < end && *p == '*') p++;
+    if (p == end) {
+      return nullptr;
+    }
+    if (*p == '/' && (p - stars) % 2 == 1) {
+      return p + 1;
+    }
+    if (*p == '\n') lines++;
+    p++;
+  }
+}
+
+int FastLexer::number(Token &token) {
+  const char *p = cur;
+  const char *q;
+  if (*p != '0') {
+    q = kernels->skip_class(p + 1, end, CharClass::Digit);
+    token.int_val = to_int(p, q, 10);
+  } else if (end - p > 2 && (p[1] | 0x20) == 'x' && in_class(p[2], CharClass::Hex)) {
+    q = kernels->skip_class(p + 2, end, CharClass::Hex);
+    token.int_val = to_int(p + 2, q, 16);
+  } else {
+    // 单独的 "0" 也按八进制处理，结果相同
+    q = kernels->skip_class(p + 1, end, CharClass::Octal);
+    token.int_val = to_int(p + 1, q, 8);
+  }
+  cur = q;
+  return token.code = INTCONST;
+}
+
+int FastLexer::next(Token &token) {
+  token = Token();
+  for (;;) {
+    cur = kernels->skip_blanks(cur, end, line);
+    if (cur == end) {
+      return token.code = 0;
+    }
+    if (*cur != '/' || end - cur < 2) {
+      break;
+    }
+    if (cur[1] == '/') {
+      cur = kernels->find_newline(cur + 2, end);
+      continue;
+    }
+    int lines = 0;
+    const char *after = cur[1] == '*' ? block_comment_end(cur + 2, lines) : nullptr;
+    if (!after) {
+      break;  // 不是注释，或者注释没有结尾，按除号处理
+    }
+    cur = after;
+    line += lines;
+  }
+
+  unsigned char c = *cur;
+  if (c >= '0' && c <= '9') {
+    return number(token);
+  }
+  if (in_class(c, CharClass::Ident)) {
+    const char *q = kernels->skip_class(cur + 1, end, CharClass::Ident);
+    size_t length = q - cur;
+    for (const auto &keyword : keywords) {
+      if (keyword.length == length && std::memcmp(keyword.text, cur, length) == 0) {
+        cur = q;
+        return token.code = keyword.code;
+      }
+    }
+    token.text = {static_cast<uint32_t>(cur - begin), static_cast<uint32_t>(length)};
+    cur = q;
+    return token.code = IDENT;
+  }
+
+  // 运算符和分隔符，两个字符的优先
+  char next = end - cur > 1 ? cur[1] : '\0';
+  auto pair = [&](char second, int matched, int single) {
+    cur += next == second ? 2 : 1;
+    return token.code = next == second ? matched : single;
+  };
+  switch (c) {
+    case '+': cur++; return token.code = ADD;
+    case '-': cur++; return token.code = SUB;
+    case '*': cur++; return token.code = MUL;
+    case '/': cur++; return token.code = DIV;
+    case '%': cur++; return token.code = MOD;
+    case '(': cur++; return token.code = LPAREN;
+    case ')': cur++; return token.code = RPAREN;
+    case '{': cur++; return token.code = LBRACE;
+    case '}': cur++; return token.code = RBRACE;
+    case '[': cur++; return token.code = LBRACKET;
+    case ']': cur++; return token.code = RBRACKET;
+    case ',': cur++; return token.code = COMMA;
+    case ';': cur++; return token.code = SEMICOLON;
+    case '!': return pair('=', NEQ, NOT);
+    case '=': return pair('=', EQU, ASSIGN);
+    case '>': return pair('=', GEQ, GRE);
+    case '<': return pair('=', LEQ, LES);
+    case '&':
+      if (next == '&') { cur += 2; return token.code = AND; }
+      break;
+    case '|':
+      if (next == '|') { cur += 2; return token.code = OR; }
+      break;
+  }
+  // 与 lexer.l 的 "." 规则相同；yytext 为 "\0" 时信息里是空字符串
+  std::string text = c ? std::string(1, static_cast<char>(c)) : std::string();
+  throw std::runtime_error("Unknown token '" + text + "' at line " + std::to_string(line));
+}
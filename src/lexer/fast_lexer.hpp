@@ -0,0 +1,39 @@
+#ifndef LEXER_FAST_LEXER_HPP
+#define LEXER_FAST_LEXER_HPP
+
+#include "lexer/lexer.hpp"
+#include "lexer/scan_kernels.hpp"
+
+/// @brief 手写的词法分析器，记号序列与 src/lexer/lexer.l 完全一致
+/// 跳过空白和注释、寻找标识符和数字的边界时，一次用 SSE2 (16 字节)
+/// 或 AVX2 (32 字节) 对整段字符分类，不足一段的部分逐字节处理
+class FastLexer {
+ public:
+  using Isa = ScanIsa;
+
+  /// @brief 当前 CPU 支持的最快指令集
+  static Isa best_isa();
+
+  /// @param begin 源码起始位置，记号的偏移相对于它
+  /// @param end 源码结束位置，不要求以 NUL 结尾
+  FastLexer(const char *begin, const char *end, Isa isa);
+
+  /// @brief 下一个记号，文件结束时返回 0
+  /// 遇到无法识别的字符时抛出 std::runtime_error，信息与 flex 扫描器相同
+  int next(Token &token);
+
+  int lineno() const { return line; }
+
+ private:
+  const char *begin;
+  const char *cur;
+  const char *end;
+  int line = 1;
+  const ScanKernels *kernels;  // 选定指令集的内层循环
+
+  /// @brief 尝试匹配 /* ... */，返回注释之后的位置，不构成注释时返回 nullptr
+  const char *block_comment_end(const char *p, int &lines) const;
+  int number(Token &token);
+};
+
+#endif  // LEXER_FAST_LEXER_HPP
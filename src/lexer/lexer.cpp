@@ -0,0 +1,155 @@
+#include "lexer.hpp"
+
+#include <stdexcept>
+
+#include "lexer/fast_lexer.hpp"
+#include "parser/parser.tab.hh"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// lexer.l 生成的扫描器
+int flex_lex(YYSTYPE *value, yyscan_t scanner);
+int yylex_init_extra(const char *source, yyscan_t *scanner);
+struct yy_buffer_state *yy_scan_buffer(char *base, size_t size, yyscan_t scanner);
+int yylex_destroy(yyscan_t scanner);
+int yyget_lineno(yyscan_t scanner);
+
+namespace {
+
+std::string describe(const Token &token) {
+  std::string text = "token " + std::to_string(token.code);
+  if (token.code == INTCONST) {
+    text += " (" + std::to_string(token.int_val) + ")";
+  } else if (token.code == IDENT) {
+    text += " (offset " + std::to_string(token.text.offset) + ", length " +
+            std::to_string(token.text.length) + ")";
+  }
+  return text;
+}
+
+bool same_token(const Token &a, const Token &b) {
+  if (a.code != b.code) return false;
+  if (a.code == INTCONST) return a.int_val == b.int_val;
+  if (a.code == IDENT) return a.text.offset == b.text.offset && a.text.length == b.text.length;
+  return true;
+}
+
+}  // namespace
+
+LexerKind parse_lexer_kind(const std::string &name) {
+  if (name == "flex") return LexerKind::Flex;
+  if (name == "simd") return LexerKind::Simd;
+  if (name == "scalar") return LexerKind::Scalar;
+  if (name == "check") return LexerKind::Check;
+  throw std::runtime_error("Unknown lexer: " + name + " (expected flex, simd, scalar or check)");
+}
+
+Lexer::Lexer(SourceBuffer &source, LexerKind kind) : kind(kind) {
+  const char *begin = source.data();
+  const char *end = begin + source.size();
+  if (kind == LexerKind::Simd || kind == LexerKind::Scalar) {
+    auto isa = kind == LexerKind::Simd ? FastLexer::best_isa() : FastLexer::Isa::Scalar;
+    fast = std::make_unique<FastLexer>(begin, end, isa);
+    return;
+  }
+
+  // 直接扫描源码缓冲区，末尾的两个 NUL 是 yy_scan_buffer 要求的；
+  // yyextra 是缓冲区的起始地址，IDENT 记录相对它的偏移
+  if (yylex_init_extra(source.data(), &scanner)) {
+    throw std::runtime_error("Cannot create scanner");
+  }
+  if (!yy_scan_buffer(source.data(), source.size() + SourceBuffer::padding, scanner)) {
+    yylex_destroy(scanner);
+    throw std::runtime_error("Cannot scan source buffer");
+  }
+
+  if (kind == LexerKind::Check) {
+    copy.emplace(std::string(source.data(), source.size()));
+    begin = copy->data();
+    end = begin + copy->size();
+    fast = std::make_unique<FastLexer>(begin, end, FastLexer::best_isa());
+    scalar = std::make_unique<FastLexer>(begin, end, FastLexer::Isa::Scalar);
+  }
+}
+
+Lexer::~Lexer() {
+  if (scanner) {
+    yylex_destroy(scanner);
+  }
+}
+
+int Lexer::next(YYSTYPE *value) {
+  if (kind == LexerKind::Flex) {
+    return flex_lex(value, scanner);
+  }
+  if (kind == LexerKind::Check) {
+    return next_checked(value);
+  }
+  Token token;
+  fast->next(token);
+  if (token.code == INTCONST) {
+    value->int_val = token.int_val;
+  } else if (token.code == IDENT) {
+    value->text = token.text;
+  }
+  return token.code;
+}
+
+int Lexer::lineno() const {
+  return scanner ? yyget_lineno(scanner) : fast->lineno();
+}
+
+int Lexer::next_checked(YYSTYPE *value) {
+  struct Result {
+    const char *name;
+    FastLexer &lexer;
+    Token token;
+    std::string error;
+  } results[] = {{"simd", *fast, {}, {}}, {"scalar", *scalar, {}, {}}};
+  for (auto &result : results) {
+    try {
+      result.lexer.next(result.token);
+    } catch (const std::runtime_error &e) {
+      result.error = e.what();
+    }
+  }
+
+  auto mismatch = [&](const Result &result, const std::string &expected,
+                      const std::string &actual) {
+    return std::runtime_error("Lexer mismatch at line " + std::to_string(yyget_lineno(scanner)) +
+                              ": flex gave " + expected + ", " + result.name + " gave " +
+                              actual);
+  };
+  auto outcome = [](const Result &result) {
+    return result.error.empty() ? describe(result.token) : result.error;
+  };
+
+  Token token;
+  try {
+    token.code = flex_lex(value, scanner);
+  } catch (const std::runtime_error &e) {
+    for (auto &result : results) {
+      if (result.error != e.what()) {
+        throw mismatch(result, e.what(), outcome(result));
+      }
+    }
+    throw;
+  }
+  if (token.code == INTCONST) {
+    token.int_val = value->int_val;
+  } else if (token.code == IDENT) {
+    token.text = value->text;
+  }
+  for (auto &result : results) {
+    if (!result.error.empty() || !same_token(token, result.token)) {
+      throw mismatch(result, describe(token), outcome(result));
+    }
+    if (result.lexer.lineno() != yyget_lineno(scanner)) {
+      throw mismatch(result, describe(token), "it on line " + std::to_string(result.lexer.lineno()));
+    }
+  }
+  return token.code;
+}
@@ -0,0 +1,66 @@
+#ifndef LEXER_LEXER_HPP
+#define LEXER_LEXER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "support/source_buffer.hpp"
+
+union YYSTYPE;
+class FastLexer;
+
+/// @brief 记号在源码缓冲区中的位置 (offset, length)
+/// 扫描器直接在源码缓冲区上工作，IDENT 不再 strdup 出新的字符串
+struct TokenText {
+  uint32_t offset;
+  uint32_t length;
+};
+
+/// @brief 一个记号：parser.tab.hh 中的记号编号和它的值
+struct Token {
+  int code = 0;
+  int int_val = 0;   // INTCONST
+  TokenText text{};  // IDENT
+};
+
+/// @brief 词法分析器的实现
+enum class LexerKind {
+  Flex,    // src/lexer/lexer.l 生成的扫描器
+  Simd,    // 手写扫描器，按 CPU 支持选择 AVX2 或 SSE2
+  Scalar,  // 手写扫描器，逐字节处理
+  Check,   // 同时运行以上三种并逐个比较记号，以 flex 的结果为准
+};
+
+/// @brief 解析 --lexer 的取值：flex、simd、scalar 或 check
+LexerKind parse_lexer_kind(const std::string &name);
+
+/// @brief 语法分析器使用的词法分析器，按 LexerKind 转发给具体实现
+class Lexer {
+ public:
+  Lexer(SourceBuffer &source, LexerKind kind);
+  ~Lexer();
+  Lexer(const Lexer &) = delete;
+  Lexer &operator=(const Lexer &) = delete;
+
+  /// @brief 下一个记号，值写入 value，文件结束时返回 0
+  /// 遇到无法识别的字符时抛出 std::runtime_error
+  int next(YYSTYPE *value);
+
+  /// @brief 已读过的记号所在的行号
+  int lineno() const;
+
+ private:
+  LexerKind kind;
+  void *scanner = nullptr;  // flex 的 yyscan_t
+  std::unique_ptr<FastLexer> fast;
+  // check 模式下再运行一个逐字节的手写扫描器；flex 会临时改写它的缓冲区，
+  // 所以手写扫描器读的是一份副本
+  std::unique_ptr<FastLexer> scalar;
+  std::optional<SourceBuffer> copy;
+
+  int next_checked(YYSTYPE *value);
+};
+
+#endif  // LEXER_LEXER_HPP
@@ -0,0 +1,60 @@
+#include "scan_kernels.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+// 由 scan_kernels_avx2.cpp 提供，没有用 -mavx2 编译时返回 nullptr；
+// 调用前必须先确认 CPU 支持 AVX2
+const ScanKernels *avx2_scan_kernels();
+#endif
+
+namespace {
+
+constexpr ScanKernels scalar_kernels = {skip_blanks_scalar, skip_class_scalar,
+                                        find_newline_scalar, find_star_scalar};
+
+#ifdef __SSE2__
+struct SSE2Ops {
+  using Block = __m128i;
+  static constexpr int width = 16;
+
+  static Block load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+  static uint32_t eq(Block b, char c) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(b, _mm_set1_epi8(c)));
+  }
+  static uint32_t range(Block b, char lo, char hi) {
+    // SSE2 只有有符号比较：把 b - lo 平移 0x80 后，无符号的 <= (hi - lo)
+    // 就变成了有符号的 <= (hi - lo) - 0x80
+    __m128i shifted = _mm_xor_si128(_mm_sub_epi8(b, _mm_set1_epi8(lo)), _mm_set1_epi8(-128));
+    __m128i above = _mm_cmpgt_epi8(shifted, _mm_set1_epi8(static_cast<char>((hi - lo) ^ 0x80)));
+    return ~_mm_movemask_epi8(above) & 0xffff;
+  }
+  static Block lower(Block b) { return _mm_or_si128(b, _mm_set1_epi8(0x20)); }
+};
+
+constexpr ScanKernels sse2_kernels = simd_kernels<SSE2Ops>();
+#endif
+
+}  // namespace
+
+const ScanKernels *scan_kernels(ScanIsa isa) {
+  switch (isa) {
+    case ScanIsa::Scalar:
+      return &scalar_kernels;
+    case ScanIsa::SSE2:
+#ifdef __SSE2__
+      return &sse2_kernels;
+#else
+      return nullptr;
+#endif
+    case ScanIsa::AVX2:
+#if defined(__x86_64__) || defined(__i386__)
+      return __builtin_cpu_supports("avx2") ? avx2_scan_kernels() : nullptr;
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
@@ -0,0 +1,185 @@
+#ifndef LEXER_SCAN_KERNELS_HPP
+#define LEXER_SCAN_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief 字符分类使用的指令集
+enum class ScanIsa { Scalar, SSE2, AVX2 };
+
+/// @brief 词法分析中可以成段处理的字符类
+enum class CharClass {
+  Ident,  // [_a-zA-Z0-9]
+  Digit,  // [0-9]
+  Octal,  // [0-7]
+  Hex,    // [0-9a-fA-F]
+};
+
+/// @brief 手写词法分析器的内层循环，每种指令集一份
+/// 所有函数都只在 [p, end) 内读取，不要求 end 处有 NUL
+struct ScanKernels {
+  /// @brief 跳过 [ \t\n]*，lines 加上其中的换行数
+  const char *(*skip_blanks)(const char *p, const char *end, int &lines);
+  /// @brief 跳过属于 cls 的字符
+  const char *(*skip_class)(const char *p, const char *end, CharClass cls);
+  /// @brief 第一个 '\n'，没有时返回 end
+  const char *(*find_newline)(const char *p, const char *end);
+  /// @brief 第一个 '*'，没有时返回 end，lines 加上途中的换行数
+  const char *(*find_star)(const char *p, const char *end, int &lines);
+};
+
+/// @brief 指定指令集的内层循环，这个指令集没有编译进来时返回 nullptr
+const ScanKernels *scan_kernels(ScanIsa isa);
+
+// 以下是各指令集共用的循环，由 scan_kernels*.cpp 用各自的 Ops 实例化。
+// AVX2 的实现放在单独用 -mavx2 编译的文件里，为了不让那里生成的代码通过
+// ODR 合并被其他文件用到，这些模板都放在匿名命名空间中
+namespace {
+
+inline bool in_class(unsigned char c, CharClass cls) {
+  switch (cls) {
+    case CharClass::Ident:
+      return c == '_' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+    case CharClass::Digit:
+      return c >= '0' && c <= '9';
+    case CharClass::Octal:
+      return c >= '0' && c <= '7';
+    case CharClass::Hex:
+      return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+  }
+  return false;
+}
+
+inline const char *skip_blanks_scalar(const char *p, const char *end, int &lines) {
+  for (; p < end; p++) {
+    if (*p == '\n') {
+      lines++;
+    } else if (*p != ' ' && *p != '\t') {
+      break;
+    }
+  }
+  return p;
+}
+
+inline const char *skip_class_scalar(const char *p, const char *end, CharClass cls) {
+  while (p < end && in_class(*p, cls)) p++;
+  return p;
+}
+
+inline const char *find_newline_scalar(const char *p, const char *end) {
+  while (p < end && *p != '\n') p++;
+  return p;
+}
+
+inline const char *find_star_scalar(const char *p, const char *end, int &lines) {
+  for (; p < end && *p != '*'; p++) {
+    if (*p == '\n') lines++;
+  }
+  return p;
+}
+
+/// Ops 提供 width 字节一段的操作，结果是每字节一位的掩码：
+///   Block load(const char *p)
+///   uint32_t eq(Block b, char c)             b[i] == c
+///   uint32_t range(Block b, char lo, char hi) lo <= b[i] <= hi（无符号）
+///   Block lower(Block b)                     b[i] | 0x20
+template <typename Ops, CharClass Cls>
+inline uint32_t class_mask(typename Ops::Block b) {
+  switch (Cls) {
+    case CharClass::Ident:
+      return Ops::range(Ops::lower(b), 'a', 'z') | Ops::range(b, '0', '9') | Ops::eq(b, '_');
+    case CharClass::Digit:
+      return Ops::range(b, '0', '9');
+    case CharClass::Octal:
+      return Ops::range(b, '0', '7');
+    case CharClass::Hex:
+      return Ops::range(b, '0', '9') | Ops::range(Ops::lower(b), 'a', 'f');
+  }
+  return 0;
+}
+
+template <typename Ops>
+constexpr uint32_t full_mask() {
+  return Ops::width == 32 ? 0xffffffffu : (1u << Ops::width) - 1;
+}
+
+template <typename Ops>
+const char *skip_blanks_simd(const char *p, const char *end, int &lines) {
+  while (end - p >= Ops::width) {
+    auto b = Ops::load(p);
+    uint32_t newline = Ops::eq(b, '\n');
+    uint32_t stop = ~(newline | Ops::eq(b, ' ') | Ops::eq(b, '\t')) & full_mask<Ops>();
+    if (stop) {
+      unsigned n = __builtin_ctz(stop);
+      lines += __builtin_popcount(newline & ((1u << n) - 1));
+      return p + n;
+    }
+    lines += __builtin_popcount(newline);
+    p += Ops::width;
+  }
+  return skip_blanks_scalar(p, end, lines);
+}
+
+template <typename Ops, CharClass Cls>
+const char *skip_class_of(const char *p, const char *end) {
+  while (end - p >= Ops::width) {
+    uint32_t stop = ~class_mask<Ops, Cls>(Ops::load(p)) & full_mask<Ops>();
+    if (stop) {
+      return p + __builtin_ctz(stop);
+    }
+    p += Ops::width;
+  }
+  return skip_class_scalar(p, end, Cls);
+}
+
+template <typename Ops>
+const char *skip_class_simd(const char *p, const char *end, CharClass cls) {
+  switch (cls) {
+    case CharClass::Ident:
+      return skip_class_of<Ops, CharClass::Ident>(p, end);
+    case CharClass::Digit:
+      return skip_class_of<Ops, CharClass::Digit>(p, end);
+    case CharClass::Octal:
+      return skip_class_of<Ops, CharClass::Octal>(p, end);
+    case CharClass::Hex:
+      return skip_class_of<Ops, CharClass::Hex>(p, end);
+  }
+  return p;
+}
+
+template <typename Ops>
+const char *find_newline_simd(const char *p, const char *end) {
+  while (end - p >= Ops::width) {
+    if (uint32_t hit = Ops::eq(Ops::load(p), '\n')) {
+      return p + __builtin_ctz(hit);
+    }
+    p += Ops::width;
+  }
+  return find_newline_scalar(p, end);
+}
+
+template <typename Ops>
+const char *find_star_simd(const char *p, const char *end, int &lines) {
+  while (end - p >= Ops::width) {
+    auto b = Ops::load(p);
+    uint32_t newline = Ops::eq(b, '\n');
+    if (uint32_t star = Ops::eq(b, '*')) {
+      unsigned n = __builtin_ctz(star);
+      lines += __builtin_popcount(newline & ((1u << n) - 1));
+      return p + n;
+    }
+    lines += __builtin_popcount(newline);
+    p += Ops::width;
+  }
+  return find_star_scalar(p, end, lines);
+}
+
+template <typename Ops>
+constexpr ScanKernels simd_kernels() {
+  return {skip_blanks_simd<Ops>, skip_class_simd<Ops>, find_newline_simd<Ops>,
+          find_star_simd<Ops>};
+}
+
+}  // namespace
+
+#endif  // LEXER_SCAN_KERNELS_HPP
@@ -0,0 +1,41 @@
+// 这个文件单独用 -mavx2 编译（见 Makefile），只有 scan_kernels() 确认
+// CPU 支持 AVX2 之后才会用到这里的代码。不要在这里包含标准库头文件：
+// 它们的 inline 函数以 AVX2 指令生成后，可能被链接器选给其他文件使用
+#if defined(__x86_64__) || defined(__i386__)
+
+#include "scan_kernels.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace {
+
+struct AVX2Ops {
+  using Block = __m256i;
+  static constexpr int width = 32;
+
+  static Block load(const char *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static uint32_t eq(Block b, char c) {
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(c)));
+  }
+  static uint32_t range(Block b, char lo, char hi) {
+    // 无符号的 lo <= b <= hi 等价于 max(b, lo) == b 且 min(b, hi) == b
+    __m256i ge = _mm256_cmpeq_epi8(_mm256_max_epu8(b, _mm256_set1_epi8(lo)), b);
+    __m256i le = _mm256_cmpeq_epi8(_mm256_min_epu8(b, _mm256_set1_epi8(hi)), b);
+    return _mm256_movemask_epi8(_mm256_and_si256(ge, le));
+  }
+  static Block lower(Block b) { return _mm256_or_si256(b, _mm256_set1_epi8(0x20)); }
+};
+
+constexpr ScanKernels avx2_kernels = simd_kernels<AVX2Ops>();
+
+}  // namespace
+
+const ScanKernels *avx2_scan_kernels() { return &avx2_kernels; }
+#else
+const ScanKernels *avx2_scan_kernels() { return nullptr; }
+#endif
+
+#endif  // x86
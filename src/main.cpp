@@ -1,49 +1,133 @@
-#include <fstream>
+#include <unistd.h>
+
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
-
-#include "analysis/cfg_builder.hpp"
-#include "ast/tree.hpp"
-#include "codegen/asm_emitter.hpp"
-#include "codegen/inst_selector.hpp"
-#include "codegen/reg_allocator.hpp"
-#include "ir/ir_translator.hpp"
-#include "semantic/type_checker.hpp"
-
-extern int yydebug; // 0: disable debug mode, 1: enable debug mode
-extern int yyparse();
-extern int yylex();
-extern int yylineno; // line number
-extern FILE *yyin;
-AST::NodePtr root;
+#include <vector>
+
+#include "driver/batch.hpp"
+#include "driver/compiler.hpp"
+#include "driver/server.hpp"
+#include "lexer/lexer.hpp"
+#include "support/alloc_profile.hpp"
+#include "support/source_buffer.hpp"
+#include "support/statistics.hpp"
+#include "support/thread_pool.hpp"
+#include "support/time_report.hpp"
+#include "support/trace.hpp"
+#include "support/writer.hpp"
 
 class Argument {
 public:
     std::string input_file;
     std::string output_file;
+    // 批量模式
+    std::vector<std::string> input_files; // 命令行上的多个输入
+    std::string batch_list;               // --batch 指定的列表文件
+    std::string output_dir;               // --output-dir 指定的输出目录
+    std::string server_socket;            // --server 监听的 socket
     bool output_ir = false;
     bool use_venus = false;
+    unsigned jobs = 1; // 后端并行处理函数的线程数，0 表示按 CPU 核数
+    bool jobs_given = false;
+    LexerKind lexer = LexerKind::Flex; // --lexer 选择的词法分析器
+    bool stream = false;               // --stream：逐个函数编译并输出，内存只与最大的函数有关
+    // 输出到标准输出的信息，默认都不输出
+    bool verbose = false;
+    bool dump_ast = false;
+    bool dump_ir = false;
+    bool dump_asm_pre_ra = false;
+    bool time_report = false; // 退出时向标准错误输出各阶段的耗时和内存
+    std::string stats;        // --stats 的格式，text 或 json，空表示不统计
+    std::string trace_file;   // --trace 输出的 Chrome trace 文件
+    bool alloc_report = false; // 退出时输出各阶段的堆分配，需要 make ALLOC_PROFILE=1
 
     Argument(int argc, char **argv) {
         if (argc < 2) {
-            throw std::runtime_error("Usage: " + std::string(argv[0]) + " <input file> [output file] [--ir] [--venus]");
+            throw std::runtime_error("Usage: " + std::string(argv[0]) + " <input file | -> [output file] [--ir] [--venus] [-j N] [--lexer flex|simd|scalar|check] [--stream]\n"
+                                     "       " + std::string(argv[0]) + " ... [-v] [--dump-ast] [--dump-ir] [--dump-asm-pre-ra] [--time-report] [--stats[=text|json]] [--trace <file>] [--alloc-report]\n"
+                                     "       " + std::string(argv[0]) + " --batch <list file> | --output-dir <dir> <input files...> [-j N]\n"
+                                     "       " + std::string(argv[0]) + " --server <socket> [-j N]");
         }
-        int pos = 1;
+        std::vector<std::string> positional;
         for (int i = 1; i < argc; i++) {
-            if (std::string(argv[i]) == "--ir") {
+            std::string arg = argv[i];
+            if (arg == "--ir") {
                 output_ir = true;
-            } else if (std::string(argv[i]) == "--venus") {
+            } else if (arg == "--venus") {
                 use_venus = true;
-            } else if (pos == 1) {
-                input_file = argv[i];
-                pos++;
-            } else if (pos == 2) {
-                output_file = argv[i];
-                pos++;
+            } else if (arg == "-v" || arg == "--verbose") {
+                verbose = true;
+            } else if (arg == "--dump-ast") {
+                dump_ast = true;
+            } else if (arg == "--dump-ir") {
+                dump_ir = true;
+            } else if (arg == "--dump-asm-pre-ra") {
+                dump_asm_pre_ra = true;
+            } else if (arg == "--stream") {
+                stream = true;
+            } else if (arg == "--time-report") {
+                time_report = true;
+            } else if (arg == "--alloc-report") {
+                if (!AllocProfile::available) {
+                    throw std::runtime_error("--alloc-report needs a build with make ALLOC_PROFILE=1");
+                }
+                alloc_report = true;
+            } else if (arg == "--stats" || arg.compare(0, 8, "--stats=") == 0) {
+                stats = arg == "--stats" ? "text" : arg.substr(8);
+                if (stats != "text" && stats != "json") {
+                    throw std::runtime_error("Unknown statistics format: " + stats);
+                }
+            } else if (arg == "-j" || (arg.size() > 2 && arg.compare(0, 2, "-j") == 0)) {
+                std::string value = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+                jobs = parse_jobs(value);
+                jobs_given = true;
+            } else if (arg == "--lexer" || arg.compare(0, 8, "--lexer=") == 0) {
+                if (arg == "--lexer" && i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                lexer = parse_lexer_kind(arg == "--lexer" ? argv[++i] : arg.substr(8));
+            } else if (arg == "--trace" || arg.compare(0, 8, "--trace=") == 0) {
+                if (arg == "--trace" && i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                trace_file = arg == "--trace" ? argv[++i] : arg.substr(8);
+            } else if (arg == "--batch" || arg == "--output-dir" || arg == "--server") {
+                if (i + 1 >= argc) {
+                    throw std::runtime_error("Missing value for " + arg);
+                }
+                (arg == "--batch" ? batch_list : arg == "--output-dir" ? output_dir : server_socket) = argv[++i];
             } else {
-                throw std::runtime_error("No matching argument: " + std::string(argv[i]));
+                positional.push_back(arg);
+            }
+        }
+        if (!server_socket.empty()) {
+            if (!positional.empty()) {
+                throw std::runtime_error("No matching argument: " + positional[0]);
+            }
+            // 这些报告在退出时输出，而服务模式不会退出，样本、计数和 trace 事件还会随请求一直增长
+            if (time_report) {
+                throw std::runtime_error("Cannot use --time-report with --server");
+            }
+            if (!stats.empty()) {
+                throw std::runtime_error("Cannot use --stats with --server");
+            }
+            if (!trace_file.empty()) {
+                throw std::runtime_error("Cannot use --trace with --server");
+            }
+        } else if (is_batch()) {
+            input_files = positional;
+        } else {
+            if (positional.empty()) {
+                throw std::runtime_error("No input file");
+            }
+            if (positional.size() > 2) {
+                throw std::runtime_error("No matching argument: " + positional[2]);
+            }
+            input_file = positional[0];
+            if (positional.size() == 2) {
+                output_file = positional[1];
             }
         }
         if (output_ir && use_venus) {
@@ -51,68 +135,107 @@ public:
                 "Cannot output IR and Venus assembly at the same time");
         }
     }
-};
-
-int main(int argc, char **argv) {
-    try {
-        yylineno = 1; // initialize line number
-
-        Argument args(argc, argv);
-
-        yyin = fopen(args.input_file.c_str(), "r");
-        if (!yyin) {
-            throw std::runtime_error("Cannot open file: " + args.input_file);
-        }
 
-        // 输出 flex/bison 的调试信息
-        // yydebug = 1;
+    bool is_batch() const {
+        return !batch_list.empty() || !output_dir.empty();
+    }
 
-        if (int parse_status = yyparse()) {
-            throw std::runtime_error("Parse failed with status " + std::to_string(parse_status));
+private:
+    static unsigned parse_jobs(const std::string &value) {
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::runtime_error("Invalid job count: " + value);
         }
-        fclose(yyin);
+        unsigned jobs = std::stoul(value);
+        return jobs == 0 ? ThreadPool::default_threads() : jobs;
+    }
+};
 
-        if (root) {
-            std::ofstream output_file;
-            if (!args.output_file.empty()) {
-                output_file.open(args.output_file);
-                if (!output_file.is_open()) {
-                    throw std::runtime_error("Cannot open output file: " + args.output_file);
+int main(int argc, char **argv) {
+    // --time-report、--stats、--trace 和 --alloc-report：无论编译是否成功，退出前都输出
+    struct PrintReports {
+        bool stats_json = false;
+        bool alloc_report = false;
+        ~PrintReports() {
+            if (TimeReport::global().is_enabled()) {
+                TimeReport::global().print(std::cerr);
+            }
+            if (Statistics::global().is_enabled()) {
+                if (stats_json) {
+                    Statistics::global().print_json(std::cerr);
+                } else {
+                    Statistics::global().print(std::cerr);
                 }
             }
-            std::ostream &output = args.output_file.empty() ? std::cout : output_file;
-
-            root->print_tree();
-            std::cout << "Parse succeeded" << std::endl;
+            if (alloc_report) {
+                AllocProfile::print(std::cerr);
+            }
+            if (Trace::global().is_enabled()) {
+                try {
+                    Trace::global().write();
+                } catch (const std::exception &e) {
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+        }
+    } print_reports;
 
-            auto type_checker = TypeChecker();
-            type_checker.check(root);
-            std::cout << "Semantic check passed" << std::endl;
+    try {
+        Argument args(argc, argv);
 
-            auto ir_translator = IRTranslator();
-            auto ir = ir_translator.translate(root);
-            std::cout << "IR generated" << std::endl;
+        CompileOptions options;
+        options.output_ir = args.output_ir;
+        options.use_venus = args.use_venus;
+        options.jobs = args.jobs;
+        options.lexer = args.lexer;
+        options.stream = args.stream;
+        options.verbose = args.verbose;
+        options.dump_ast = args.dump_ast;
+        options.dump_ir = args.dump_ir;
+        options.dump_asm_pre_ra = args.dump_asm_pre_ra;
+        if (args.time_report) {
+            TimeReport::global().enable();
+        }
+        print_reports.alloc_report = args.alloc_report;
+        if (!args.trace_file.empty()) {
+            Trace::global().start(args.trace_file);
+        }
+        if (!args.stats.empty()) {
+            Statistics::global().enable();
+            print_reports.stats_json = args.stats == "json";
+        }
 
-            auto cfg_builder = CFGBuilder();
-            auto mod = cfg_builder.build(ir);
-            std::cout << "Control flow graph generated" << std::endl;
+        if (!args.server_socket.empty()) {
+            // 服务模式：-j 指定同时服务的连接数，默认按 CPU 核数
+            unsigned workers = args.jobs_given ? args.jobs : ThreadPool::default_threads();
+            CompileServer(args.server_socket, options, workers).run();
+        }
 
-            if (args.output_ir) {
-                output << mod.get_ir();
-                return 0;
+        if (args.is_batch()) {
+            // 批量模式：-j 指定同时编译的文件数，与服务模式一样默认按 CPU 核数
+            auto inputs = args.input_files;
+            if (!args.batch_list.empty()) {
+                auto listed = BatchCompiler::read_list(args.batch_list);
+                inputs.insert(inputs.end(), listed.begin(), listed.end());
             }
+            unsigned workers = args.jobs_given ? args.jobs : ThreadPool::default_threads();
+            auto batch = BatchCompiler(options, args.output_dir, workers);
+            return batch.run(inputs, std::cout) == 0 ? 0 : 1;
+        }
 
-            auto inst_selector = InstSelector();
-            inst_selector.select(mod);
-            std::cout << "Instruction selection done" << std::endl;
+        // "-" 表示从标准输入读取
+        auto source = SourceBuffer::open(args.input_file);
 
-            auto reg_allocator = RegAllocator();
-            reg_allocator.allocate(mod);
-            std::cout << "Register allocation done" << std::endl;
+        // 没有指定输出文件时写到标准输出，与进度信息共用，进度信息每行都会 flush
+        int fd = args.output_file.empty() ? STDOUT_FILENO : Writer::open_file(args.output_file);
+        Writer output(fd, fd != STDOUT_FILENO);
 
-            auto asm_emitter = ASMEmitter(args.use_venus, output);
-            asm_emitter.emit(mod);
-            std::cout << "Assembly generated" << std::endl;
+        if (options.stream) {
+            compile_streaming(source, options, output, &std::cout);
+            return 0;
+        }
+        auto mod = compile_frontend(source, options, &std::cout);
+        if (mod) {
+            compile_backend(*mod, options, output, &std::cout);
         }
 
         return 0;
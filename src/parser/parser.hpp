@@ -0,0 +1,30 @@
+#ifndef PARSER_PARSER_HPP
+#define PARSER_PARSER_HPP
+
+#include <functional>
+
+#include "ast/tree.hpp"
+#include "lexer/lexer.hpp"
+#include "support/arena.hpp"
+#include "support/source_buffer.hpp"
+
+/// @brief 对一个编译单元做词法和语法分析
+/// 每次调用使用独立的扫描器和分析器状态，可以在多个线程中同时调用
+/// @param source 扫描器直接在其中工作，AST 构建完成前必须保持有效
+/// @param arena 持有分析得到的所有 AST 节点
+/// @param lexer_kind 使用的词法分析器
+/// @return AST 的根节点
+/// 词法或语法错误时抛出 std::runtime_error
+AST::NodePtr parse(SourceBuffer &source, Arena &arena, LexerKind lexer_kind = LexerKind::Flex);
+
+/// @brief 流式分析时接收顶层单元（FuncDef 或 VarDecl）的回调
+using UnitCallback = std::function<void(AST::NodePtr)>;
+
+/// @brief 流式的词法和语法分析
+/// 每个顶层单元一归约就交给 on_unit，回调返回后它的 AST 节点随即从 arena
+/// 中释放，所以 arena 在任何时刻只持有一个单元；回调抛出的异常中止分析
+/// @return 不含任何单元的 CompUnit
+AST::NodePtr parse(SourceBuffer &source, Arena &arena, LexerKind lexer_kind,
+                   const UnitCallback &on_unit);
+
+#endif // PARSER_PARSER_HPP
@@ -1,34 +1,100 @@
-%{
+%code requires {
+#include <functional>
+#include <string>
+#include <string_view>
+#include "ast/tree.hpp"
+#include "lexer/lexer.hpp"
+#include "support/arena.hpp"
+#include "support/source_buffer.hpp"
+
+/// @brief 一次语法分析的全部状态
+/// 扫描器和分析器都是可重入的，状态只存在于这里和 Lexer 中，
+/// 因此多个线程可以同时分析不同的文件
+struct ParseContext {
+  Arena &arena;                // 持有所有 AST 节点，由调用者统一释放
+  const SourceBuffer &source;
+  Lexer &lexer;
+  AST::NodePtr root = nullptr;
+  /// @brief 流式分析的回调，为空时所有单元都挂在 CompUnit 上
+  const std::function<void(AST::NodePtr)> *on_unit = nullptr;
+  /// @brief 流式分析时下一个单元的节点从这里开始分配
+  Arena::Mark unit_start = arena.mark();
+  /// @brief yyerror 记下的第一条错误信息和所在行号
+  std::string error;
+  int error_line = 0;
+
+  std::string_view text(TokenText token) const {
+    return std::string_view(source.data() + token.offset, token.length);
+  }
+  /// @brief 标识符在建 AST 节点时就驻留，之后的查找都只比较 Ident
+  Ident ident(TokenText token) const { return Ident(text(token)); }
+
+  // 所有 AST 节点都分配在 arena 中，并记录扫描器当前的行号
+  template <typename T, typename... Args>
+  T *make(Args &&...args) {
+    T *node = arena.create<T>(std::forward<Args>(args)...);
+    node->lineno = lexer.lineno();
+    return node;
+  }
+
+  /// @brief 把刚归约出的顶层单元挂到 comp_unit 上（为空时新建一个），
+  /// 流式分析时则交给 on_unit，然后释放这个单元的所有节点
+  AST::CompUnit *add_unit(AST::CompUnit *comp_unit, AST::NodePtr unit) {
+    if (!on_unit) {
+      if (!comp_unit) {
+        return make<AST::CompUnit>(unit);
+      }
+      comp_unit->add_unit(unit);
+      return comp_unit;
+    }
+    (*on_unit)(unit);
+    arena.rewind(unit_start);
+    if (!comp_unit) {
+      comp_unit = make<AST::CompUnit>();
+      unit_start = arena.mark();
+    }
+    return comp_unit;
+  }
+};
+}
+
+%code {
 #include <cstdio>
 #include <memory>
 #include <string>
 #include <iostream>
-#include "ast/tree.hpp"
-#define YYDEBUG 1
-void yyerror(const char *s);
-extern int yylex(void);
+#include <stdexcept>
+#include "parser/parser.hpp"
+void yyerror(Lexer &lexer, ParseContext &ctx, const char *s);
+
+static int yylex(YYSTYPE *yylval, Lexer &lexer) {
+  return lexer.next(yylval);
+}
 using namespace AST;
-extern NodePtr root;
 
 template <typename T>
-inline std::shared_ptr<T> shared_cast(Node *ptr) {
-  return std::shared_ptr<T>(static_cast<T *>(ptr));
+inline T *as(Node *ptr) {
+  return static_cast<T *>(ptr);
+}
 }
 
-%}
+%define api.pure full
+%param {Lexer &lexer}
+%parse-param {ParseContext &ctx}
 
 // yylval 的定义, 我们把它定义成了一个联合体 (union)
-// 因为 token 的值有的是字符串指针, 有的是整数
-// 之前我们在 lexer 中用到的 str_val 和 int_val 就是在这里被定义的
+// 因为 token 的值有的是源码中的一段文本, 有的是整数
+// 之前我们在 lexer 中用到的 text 和 int_val 就是在这里被定义的
 // 这里的 union 是一种特殊的数据结构，所有成员共享相同的内存地址
 // 因此只能存储一个成员的值，且占用的内存大小等于其最大成员的大小
 // union 中的类型必须是 trivially copyable 的类型
 // 也就是说不能包含有自定义的构造函数、析构函数、虚函数等
 // 符合这个条件的类型有基本数据类型、指针、C 结构体、枚举等
 // 因此我们不能使用 std::shared_ptr，而只能使用普通指针
+// (AST 节点本身也只用普通指针引用，所有权归 ParseContext::arena)
 %union{
     int int_val;
-    char *str_val;
+    TokenText text;
     BinaryOp op;
     AST::Node *node;
 }
@@ -63,7 +129,7 @@ inline std::shared_ptr<T> shared_cast(Node *ptr) {
 %token IF "if"
 %token ELSE "else"
 %token WHILE "while"
-%token <str_val> IDENT
+%token <text> IDENT
 %token <int_val> INTCONST
 
 %type <node> AstRoot CompUnit Decl VarDecl VarDefs VarDef FuncDef Block BlockItem BlockItems Stmt Exp LVal PrimaryExp IntConst UnaryExp FuncRParams MulExp AddExp
@@ -82,16 +148,13 @@ inline std::shared_ptr<T> shared_cast(Node *ptr) {
 %nonassoc ELSE
 %%
 
-// 由于我们在后续代码中所有指针都是 std::shared_ptr
-// 而在 union 中没法直接定义 std::shared_ptr
-// 所以我们在这里需要将普通的指针转换成 std::shared_ptr
-AstRoot : CompUnit { root = NodePtr($1); }
+AstRoot : CompUnit { ctx.root = $1; }
     ;
 
-CompUnit : FuncDef { $$ = new CompUnit(shared_cast<FuncDef>($1)); }
-    | Decl { $$ = new CompUnit(shared_cast<VarDecl>($1)); }
-    | CompUnit FuncDef { static_cast<CompUnit*>($1)->add_unit(shared_cast<FuncDef>($2)); $$ = $1; }
-    | CompUnit Decl { static_cast<CompUnit*>($1)->add_unit(shared_cast<VarDecl>($2)); $$ = $1; }    
+CompUnit : FuncDef { $$ = ctx.add_unit(nullptr, $1); }
+    | Decl { $$ = ctx.add_unit(nullptr, $1); }
+    | CompUnit FuncDef { $$ = ctx.add_unit(as<CompUnit>($1), $2); }
+    | CompUnit Decl { $$ = ctx.add_unit(as<CompUnit>($1), $2); }
     ;
 
 // Decl & Define Part
@@ -99,83 +162,77 @@ CompUnit : FuncDef { $$ = new CompUnit(shared_cast<FuncDef>($1)); }
 Decl : VarDecl { $$ = $1; }
     ;
 
-// 由于 union 中的类型不能是 std::shared_ptr
-// 只是普通的指针，所以我们需要通过 static_cast 来转换类型
+// union 中保存的是 Node *，需要通过 as<T> (static_cast) 来转换类型
 // 才能访问到对应的成员和函数
-VarDecl : "int" VarDefs ";" { static_cast<VarDecl *>($2)->btype = BasicType::Int; $$ = $2; }
+VarDecl : "int" VarDefs ";" { as<VarDecl>($2)->btype = BasicType::Int; $$ = $2; }
     ;
 
-VarDefs : VarDef { $$ = new VarDecl(shared_cast<VarDef>($1)); }
-    | VarDefs "," VarDef { static_cast<VarDecl*>($1)->add_def(shared_cast<VarDef>($3)); $$ = $1; }
+VarDefs : VarDef { $$ = ctx.make<VarDecl>(as<VarDef>($1)); }
+    | VarDefs "," VarDef { as<VarDecl>($1)->add_def(as<VarDef>($3)); $$ = $1; }
     ;
 
-VarDef : IDENT { $$ = new VarDef($1); }
-    | VarDef "[" INTCONST "]" { $$ = new VarDef(shared_cast<VarDef>($1), $3); }
-    | IDENT "=" InitVal { $$ = new VarDef($1, shared_cast<InitVal>($3)); }
-    | VarDef "[" INTCONST "]" "=" InitVal { $$ = new VarDef(shared_cast<VarDef>($1), $3, shared_cast<InitVal>($6)); }
+VarDef : IDENT { $$ = ctx.make<VarDef>(ctx.ident($1)); }
+    | VarDef "[" INTCONST "]" { as<VarDef>($1)->add_dim($3); $$ = $1; }
+    | IDENT "=" InitVal { $$ = ctx.make<VarDef>(ctx.ident($1), as<InitVal>($3)); }
+    | VarDef "[" INTCONST "]" "=" InitVal { as<VarDef>($1)->add_dim($3); as<VarDef>($1)->inits = as<InitVal>($6); $$ = $1; }
     ;
 
 // FuncDef Part
 
-// 同样的，由于 union 中的类型不能是 std::shared_ptr
-// 而 FuncDef 初始化时需要传入一个 BlockPtr (std::shared_ptr<Block>)
-// 所以我们需要通过 static_cast 来转换类型
-// 再用 std::shared_ptr 包装一下
-// 才能传入 FuncDef 的构造函数
-// 这里 shared_cast 是一个自定义的模板函数，用于将普通指针转换成 std::shared_ptr
-// 相当于 std::shared_ptr<T>(static_cast<T*>(ptr))
+// 同样的，FuncDef 初始化时需要传入一个 BlockPtr (Block *)
+// 所以我们需要通过 as<T> 来转换类型，才能传入 FuncDef 的构造函数
 
-FuncDef : "void" IDENT "(" ")" Block { $$ = new FuncDef(BasicType::Void, $2, shared_cast<Block>($5)); }
-    | "int" IDENT "(" ")" Block { $$ = new FuncDef(BasicType::Int, $2, shared_cast<Block>($5)); }
-    | "void" IDENT "(" FuncFParams ")" Block { $$ = new FuncDef(BasicType::Void, $2, shared_cast<Block>($6), shared_cast<FuncFParams>($4)); }
-    | "int" IDENT "(" FuncFParams ")" Block { $$ = new FuncDef(BasicType::Int, $2, shared_cast<Block>($6), shared_cast<FuncFParams>($4)); }
+FuncDef : "void" IDENT "(" ")" Block { $$ = ctx.make<FuncDef>(BasicType::Void, ctx.ident($2), as<Block>($5)); }
+    | "int" IDENT "(" ")" Block { $$ = ctx.make<FuncDef>(BasicType::Int, ctx.ident($2), as<Block>($5)); }
+    | "void" IDENT "(" FuncFParams ")" Block { $$ = ctx.make<FuncDef>(BasicType::Void, ctx.ident($2), as<Block>($6), as<FuncFParams>($4)); }
+    | "int" IDENT "(" FuncFParams ")" Block { $$ = ctx.make<FuncDef>(BasicType::Int, ctx.ident($2), as<Block>($6), as<FuncFParams>($4)); }
     ;
 
-FuncFParams : FuncFParam { $$ = new FuncFParams(shared_cast<FuncFParam>($1)); }
-    | FuncFParams "," FuncFParam { static_cast<FuncFParams*>($1)->add_param(shared_cast<FuncFParam>($3)); $$ = $1; }
+FuncFParams : FuncFParam { $$ = ctx.make<FuncFParams>(as<FuncFParam>($1)); }
+    | FuncFParams "," FuncFParam { as<FuncFParams>($1)->add_param(as<FuncFParam>($3)); $$ = $1; }
 
-FuncFParam : "int" IDENT { $$ = new FuncFParam($2); }
-    | "int" IDENT "[" "]" { $$ = new FuncFParam($2, 0); }
-    | "int" IDENT "[" "]" ArrayDims { $$ = new FuncFParam($2, shared_cast<ArrayDims>($5)); }
+FuncFParam : "int" IDENT { $$ = ctx.make<FuncFParam>(ctx.ident($2)); }
+    | "int" IDENT "[" "]" { $$ = ctx.make<FuncFParam>(ctx.ident($2), 0); }
+    | "int" IDENT "[" "]" ArrayDims { $$ = ctx.make<FuncFParam>(ctx.ident($2), as<ArrayDims>($5)); }
     ;
 
-ArrayDims : "[" INTCONST "]" { $$ = new ArrayDims($2); }
-    | ArrayDims "[" INTCONST "]" { static_cast<ArrayDims*>($1)->add_dim($3); $$ = $1; }
+ArrayDims : "[" INTCONST "]" { $$ = ctx.make<ArrayDims>($2); }
+    | ArrayDims "[" INTCONST "]" { as<ArrayDims>($1)->add_dim($3); $$ = $1; }
     ;
 
 // InitVal       ::= Exp | "{" [InitVal {"," InitVal}] "}";
-InitVal : Exp { $$ = new InitVal(shared_cast<Node>($1)); }
-    | "{" "}" { $$ = new InitVal(); }
-    | "{" InitList "}" { $$ = new InitVal(shared_cast<InitList>($2)); }
+InitVal : Exp { $$ = ctx.make<InitVal>($1); }
+    | "{" "}" { $$ = ctx.make<InitVal>(ctx.make<InitList>()); }
+    | "{" InitList "}" { $$ = ctx.make<InitVal>(as<InitList>($2)); }
 
-InitList : InitVal { $$ = new InitList(shared_cast<InitVal>($1)); }
-    | InitList "," InitVal { static_cast<InitList*>($1)->add_element(shared_cast<InitVal>($3)); $$ = $1; }
+InitList : InitVal { $$ = ctx.make<InitList>(as<InitVal>($1)); }
+    | InitList "," InitVal { as<InitList>($1)->add_element(as<InitVal>($3)); $$ = $1; }
     ;
     
 
 // Block and Stmt Part
 
-Block : "{" "}" { $$ = new Block(); }
+Block : "{" "}" { $$ = ctx.make<Block>(); }
     | "{" BlockItems "}" { $$ = $2; }
     ;
 
-BlockItems : BlockItem { $$ = new Block(NodePtr($1)); }
-    | BlockItems BlockItem { static_cast<Block*>($1)->add_stmt(NodePtr($2)); $$ = $1; }
+BlockItems : BlockItem { $$ = ctx.make<Block>($1); }
+    | BlockItems BlockItem { as<Block>($1)->add_stmt($2); $$ = $1; }
     ;
 
 BlockItem : Stmt { $$ = $1; }
     | Decl { $$ = $1; }
     ;
 
-Stmt : LVal "=" Exp ";" { $$ = new AssignStmt(shared_cast<LVal>($1), NodePtr($3)); }
+Stmt : LVal "=" Exp ";" { $$ = ctx.make<AssignStmt>(as<LVal>($1), $3); }
     | Exp ";" { $$ = $1; }
-    | ";" { $$ = new EmptyStmt(); }
+    | ";" { $$ = ctx.make<EmptyStmt>(); }
     | Block { $$ = $1; } 
-    | "if" "(" Cond ")" Stmt { $$ = new IfStmt(NodePtr($3), NodePtr($5)); }
-    | "if" "(" Cond ")" Stmt "else" Stmt { $$ = new IfStmt(NodePtr($3), NodePtr($5), NodePtr($7)); }
-    | "while" "(" Cond ")" Stmt { $$ = new WhileStmt(NodePtr($3), NodePtr($5)); }
-    | "return" Exp ";" { $$ = new ReturnStmt(NodePtr($2)); }
-    | "return" ";" { $$ = new ReturnStmt(); }
+    | "if" "(" Cond ")" Stmt { $$ = ctx.make<IfStmt>($3, $5); }
+    | "if" "(" Cond ")" Stmt "else" Stmt { $$ = ctx.make<IfStmt>($3, $5, $7); }
+    | "while" "(" Cond ")" Stmt { $$ = ctx.make<WhileStmt>($3, $5); }
+    | "return" Exp ";" { $$ = ctx.make<ReturnStmt>($2); }
+    | "return" ";" { $$ = ctx.make<ReturnStmt>(); }
     ;
 
 
@@ -187,8 +244,8 @@ Exp : AddExp { $$ = $1; }
 Cond : LOrExp { $$ = $1; }
     ;
 
-LVal : IDENT { $$ = new LVal($1); }
-    | LVal "[" Exp "]" { static_cast<LVal*>($1)->add_index(NodePtr($3)); $$ = $1; }
+LVal : IDENT { $$ = ctx.make<LVal>(ctx.ident($1)); }
+    | LVal "[" Exp "]" { as<LVal>($1)->add_index($3); $$ = $1; }
     ;
 
 PrimaryExp : LVal { $$ = $1; }
@@ -196,13 +253,13 @@ PrimaryExp : LVal { $$ = $1; }
     | "(" Exp ")" { $$ = $2; }
     ;
 
-IntConst : INTCONST { $$ = new IntConst($1); }
+IntConst : INTCONST { $$ = ctx.make<IntConst>($1); }
     ;
 
 UnaryExp : PrimaryExp { $$ = $1; }
-    | IDENT "(" ")" { $$ = new FuncCall($1); }
-    | IDENT "(" FuncRParams ")" { static_cast<FuncCall*>($3)->name = $1; $$ = $3; }
-    | UnaryOp UnaryExp { $$ = new UnaryExp($1, NodePtr($2)); }
+    | IDENT "(" ")" { $$ = ctx.make<FuncCall>(ctx.ident($1)); }
+    | IDENT "(" FuncRParams ")" { as<FuncCall>($3)->name = ctx.ident($1); $$ = $3; }
+    | UnaryOp UnaryExp { $$ = ctx.make<UnaryExp>($1, $2); }
     ;
 
 UnaryOp : "+" { $$ = BinaryOp::Add; }
@@ -210,44 +267,74 @@ UnaryOp : "+" { $$ = BinaryOp::Add; }
     | "!" { $$ = BinaryOp::Not; }
     ;
 
-FuncRParams : Exp { $$ = new FuncCall(NodePtr($1)); }
-    | FuncRParams "," Exp { static_cast<FuncCall*>($1)->add_arg(NodePtr($3)); $$ = $1; }
+FuncRParams : Exp { $$ = ctx.make<FuncCall>($1); }
+    | FuncRParams "," Exp { as<FuncCall>($1)->add_arg($3); $$ = $1; }
     ;
 
 
 MulExp : UnaryExp { $$ = $1; }
-    | MulExp "*" UnaryExp { $$ = new BinaryExp(BinaryOp::Mul, NodePtr($1), NodePtr($3)); }
-    | MulExp "/" UnaryExp { $$ = new BinaryExp(BinaryOp::Div, NodePtr($1), NodePtr($3)); }
-    | MulExp "%" UnaryExp { $$ = new BinaryExp(BinaryOp::Mod, NodePtr($1), NodePtr($3)); }
+    | MulExp "*" UnaryExp { $$ = ctx.make<BinaryExp>(BinaryOp::Mul, $1, $3); }
+    | MulExp "/" UnaryExp { $$ = ctx.make<BinaryExp>(BinaryOp::Div, $1, $3); }
+    | MulExp "%" UnaryExp { $$ = ctx.make<BinaryExp>(BinaryOp::Mod, $1, $3); }
     ;
 
 AddExp : MulExp { $$ = $1; }
-    | AddExp "+" MulExp { $$ = new BinaryExp(BinaryOp::Add, NodePtr($1), NodePtr($3)); }
-    | AddExp "-" MulExp { $$ = new BinaryExp(BinaryOp::Sub, NodePtr($1), NodePtr($3)); }
+    | AddExp "+" MulExp { $$ = ctx.make<BinaryExp>(BinaryOp::Add, $1, $3); }
+    | AddExp "-" MulExp { $$ = ctx.make<BinaryExp>(BinaryOp::Sub, $1, $3); }
     ;
 
 RelExp : AddExp { $$ = $1; }
-    | RelExp "<" AddExp { $$ = new BinaryExp(BinaryOp::Lt, NodePtr($1), NodePtr($3)); }
-    | RelExp ">" AddExp { $$ = new BinaryExp(BinaryOp::Gt, NodePtr($1), NodePtr($3)); }
-    | RelExp "<=" AddExp { $$ = new BinaryExp(BinaryOp::Le, NodePtr($1), NodePtr($3)); }
-    | RelExp ">=" AddExp { $$ = new BinaryExp(BinaryOp::Ge, NodePtr($1), NodePtr($3)); }
+    | RelExp "<" AddExp { $$ = ctx.make<BinaryExp>(BinaryOp::Lt, $1, $3); }
+    | RelExp ">" AddExp { $$ = ctx.make<BinaryExp>(BinaryOp::Gt, $1, $3); }
+    | RelExp "<=" AddExp { $$ = ctx.make<BinaryExp>(BinaryOp::Le, $1, $3); }
+    | RelExp ">=" AddExp { $$ = ctx.make<BinaryExp>(BinaryOp::Ge, $1, $3); }
     ;
 
 EqExp : RelExp { $$ = $1; }
-    | EqExp "==" RelExp { $$ = new BinaryExp(BinaryOp::Eq, NodePtr($1), NodePtr($3)); }
-    | EqExp "!=" RelExp { $$ = new BinaryExp(BinaryOp::Ne, NodePtr($1), NodePtr($3)); }
+    | EqExp "==" RelExp { $$ = ctx.make<BinaryExp>(BinaryOp::Eq, $1, $3); }
+    | EqExp "!=" RelExp { $$ = ctx.make<BinaryExp>(BinaryOp::Ne, $1, $3); }
     ;
 
 LAndExp : EqExp { $$ = $1; }
-    | LAndExp "&&" EqExp { $$ = new BinaryExp(BinaryOp::And, NodePtr($1), NodePtr($3)); }
+    | LAndExp "&&" EqExp { $$ = ctx.make<BinaryExp>(BinaryOp::And, $1, $3); }
     ;
 
 LOrExp : LAndExp { $$ = $1; }
-    | LOrExp "||" LAndExp { $$ = new BinaryExp(BinaryOp::Or, NodePtr($1), NodePtr($3)); }
+    | LOrExp "||" LAndExp { $$ = ctx.make<BinaryExp>(BinaryOp::Or, $1, $3); }
     ;
 
 %%
 
-void yyerror(const char *s) {
-    printf("error: %s\n", s);
+void yyerror(Lexer &lexer, ParseContext &ctx, const char *s) {
+    // 出错后 bison 还可能报告后续错误，只保留第一条
+    if (ctx.error.empty()) {
+        ctx.error = s;
+        ctx.error_line = lexer.lineno();
+    }
+}
+
+/// @brief 运行分析器，失败时把 yyerror 记下的信息放进异常
+static AST::NodePtr run_parser(Lexer &lexer, ParseContext &ctx) {
+    if (int status = yyparse(lexer, ctx)) {
+        if (ctx.error.empty()) {
+            throw std::runtime_error("Parse failed with status " + std::to_string(status));
+        }
+        throw std::runtime_error("Parse error at line " + std::to_string(ctx.error_line) + ": " +
+                                 ctx.error);
+    }
+    return ctx.root;
+}
+
+AST::NodePtr parse(SourceBuffer &source, Arena &arena, LexerKind lexer_kind) {
+    Lexer lexer(source, lexer_kind);
+    ParseContext ctx{arena, source, lexer};
+    return run_parser(lexer, ctx);
+}
+
+AST::NodePtr parse(SourceBuffer &source, Arena &arena, LexerKind lexer_kind,
+                   const UnitCallback &on_unit) {
+    Lexer lexer(source, lexer_kind);
+    ParseContext ctx{arena, source, lexer};
+    ctx.on_unit = &on_unit;
+    return run_parser(lexer, ctx);
 }
@@ -1,6 +1,29 @@
 #include "symbol_table.hpp"
 
-SymbolPtr SymbolTable::add_symbol(std::string name, TypePtr type, bool is_defined) {
+size_t SymbolTable::probe(Ident name) const {
+  // ids are dense, so scatter them before masking
+  size_t mask = slots.size() - 1;
+  size_t index = (name.id() * 0x9E3779B9u) & mask;
+  while (!slots[index].name.empty() && slots[index].name != name) {
+    index = (index + 1) & mask;
+  }
+  return index;
+}
+
+void SymbolTable::grow() {
+  std::vector<Slot> old = std::move(slots);
+  slots.assign(old.empty() ? 64 : old.size() * 2, Slot());
+  used_slots = 0;
+  for (auto &slot : old) {
+    // names with nothing in scope are dropped here
+    if (slot.head != -1) {
+      slots[probe(slot.name)] = slot;
+      used_slots++;
+    }
+  }
+}
+
+SymbolPtr SymbolTable::add_symbol(Ident name, TypePtr type, bool is_defined) {
   // 实现符号表的插入操作
   // 并设置 symbol 的 unique_name 属性（你也可以等到 IR Translation 阶段再设置）
   // 对于局部变量和数组，最好为该标识符重新生成一个唯一名称
@@ -9,52 +32,49 @@ SymbolPtr SymbolTable::add_symbol(std::string name, TypePtr type, bool is_define
   // 如果符号已经存在，返回 nullptr
 
 // #warning Not implemented: SymbolTable::add_symbol
-  if (scopes.empty()) enter_scope();
-  auto& current_scope = scopes.back();
-  if (current_scope.find(name) != current_scope.end()) {
+  if (scope_starts.empty()) enter_scope();
+  // 装载因子保持在 3/4 以下，探测才能很快停下
+  if ((used_slots + 1) * 4 > slots.size() * 3) grow();
+  size_t index = probe(name);
+  Slot &slot = slots[index];
+  if (slot.head != -1 && bindings[slot.head].depth == scope_depth) {
     return nullptr;  // Symbol already exists
   }
   SymbolPtr symbol = Symbol::create(name, type);
   if (is_defined) {
     symbol->unique_name = name;
   } else {
-    symbol->unique_name = name + "_in_" + std::to_string(scope_depth);
+    symbol->unique_name = Ident(name.str() + "_in_" + std::to_string(scope_depth));
+  }
+  if (slot.name.empty()) {
+    slot.name = name;
+    used_slots++;
   }
-  current_scope[name] = symbol;
+  bindings.push_back({name, symbol, scope_depth, slot.head});
+  slot.head = static_cast<int>(bindings.size() - 1);
   return symbol;
 }
 
-SymbolPtr SymbolTable::find_symbol(std::string name,
+SymbolPtr SymbolTable::find_symbol(Ident name,
                                    bool in_current_scope) const {
   // 实现符号表的查找操作
   // 找到了返回对应的符号，否则返回 nullptr
   // in_current_scope 为 true 时，只在当前作用域查找
 
 // #warning Not implemented: SymbolTable::find_symbol
-  if (scopes.empty()) return nullptr;
-  if (in_current_scope) {
-    auto& current_scope = scopes.back();
-    auto it = current_scope.find(name);
-    if (it != current_scope.end()) {
-      return it->second;
-    }    
-  }
-  else {
-    for (int i = scopes.size() - 1; i >= 0; --i) {
-      auto& scope = scopes[i];
-      auto it = scope.find(name);
-      if (it != scope.end()) {
-        return it->second;
-      }
-    }
-  }
-  return nullptr;
+  if (slots.empty()) return nullptr;
+  const Slot &slot = slots[probe(name)];
+  if (slot.head == -1) return nullptr;
+  // 槽里总是最内层的绑定，外层同名的符号都被它遮蔽
+  const Binding &binding = bindings[slot.head];
+  if (in_current_scope && binding.depth != scope_depth) return nullptr;
+  return binding.symbol;
 }
 
 void SymbolTable::enter_scope() {
   // 实现符号表的进入作用域操作
   // 需要创建一个新的作用域
-  scopes.emplace_back();
+  scope_starts.push_back(bindings.size());
   ++ scope_depth;
 // #warning Not implemented: SymbolTable::enter_scope
 }
@@ -62,8 +82,14 @@ void SymbolTable::enter_scope() {
 void SymbolTable::exit_scope() {
   // 实现符号表的退出作用域操作
   // 需要删除当前作用域中的所有符号
-  if (!scopes.empty()) {
-    scopes.pop_back();
+  if (!scope_starts.empty()) {
+    // 按插入的逆序撤销，每个名字恢复成被它遮蔽的绑定
+    while (bindings.size() > scope_starts.back()) {
+      const Binding &binding = bindings.back();
+      slots[probe(binding.name)].head = binding.shadowed;
+      bindings.pop_back();
+    }
+    scope_starts.pop_back();
     -- scope_depth;
   }
 // #warning Not implemented: SymbolTable::exit_scope
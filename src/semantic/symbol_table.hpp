@@ -3,9 +3,10 @@
 
 #include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "support/alloc_profile.hpp"
+#include "support/ident.hpp"
 #include "type.hpp"
 
 class Symbol;
@@ -13,30 +14,38 @@ using SymbolPtr = std::shared_ptr<Symbol>;
 class Symbol {
  public:
   /// @brief The name of the symbol
-  std::string name;
-  /// @brief The unique name of the symbol
-  std::string unique_name;
+  Ident name;
+  /// @brief The unique name of the symbol, interned once for all uses in the IR
+  Ident unique_name;
   /// @brief The type of the symbol
   TypePtr type;
-  Symbol(std::string name, TypePtr type) : name(name), type(type) {}
-  static SymbolPtr create(std::string name, TypePtr type) {
+  Symbol(Ident name, TypePtr type) : name(name), type(type) {}
+  static SymbolPtr create(Ident name, TypePtr type) {
+    AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
     return std::make_shared<Symbol>(name, type);
   }
 };
 
+/// @brief Scoped symbol table
+/// All scopes share one open-addressing hash table keyed by interned
+/// identifiers. A slot points at the innermost binding of its name, and each
+/// binding links to the one it shadows. Bindings are kept in insertion order,
+/// which doubles as the undo log: exit_scope pops the bindings of the current
+/// scope and puts the shadowed ones back, so lookup costs the same at any
+/// nesting depth.
 class SymbolTable {
  public:
   /// @brief Add a symbol to the table and return the unique name of the symbol
   /// @param name The name of the symbol
   /// @param type The type of the symbol
   /// @return The added symbol if added successfully, nullptr otherwise
-  SymbolPtr add_symbol(std::string name, TypePtr type, bool is_defined = false);
+  SymbolPtr add_symbol(Ident name, TypePtr type, bool is_defined = false);
 
   /// @brief Find a symbol by name
   /// @param name The name of the symbol
   /// @param in_current_scope Whether to search only in the current scope
   /// @return The symbol if found, nullptr otherwise
-  SymbolPtr find_symbol(std::string name, bool in_current_scope = false) const;
+  SymbolPtr find_symbol(Ident name, bool in_current_scope = false) const;
 
   /// @brief Enter a new scope
   void enter_scope();
@@ -46,12 +55,30 @@ class SymbolTable {
 
   /// @brief The current scope depth
   int scope_depth = -1;
-  /// @brief functional implementation of the symbol table
-  /// scopes.back() is the current scope
-  std::vector<std::unordered_map<std::string, SymbolPtr>> scopes;
 
  private:
-  
+  struct Binding {
+    Ident name;
+    SymbolPtr symbol;
+    int depth;
+    int shadowed;  // index of the binding this one hides, -1 if none
+  };
+  struct Slot {
+    Ident name;     // empty if the slot was never used
+    int head = -1;  // innermost binding of name, -1 once all went out of scope
+  };
+
+  /// @brief bindings of all open scopes in insertion order
+  std::vector<Binding> bindings;
+  /// @brief size of bindings when each open scope was entered
+  std::vector<size_t> scope_starts;
+  /// @brief capacity is a power of two; names stay in their slot once placed
+  std::vector<Slot> slots;
+  size_t used_slots = 0;
+
+  /// @brief the slot of name, or the empty slot where it would go
+  size_t probe(Ident name) const;
+  void grow();
 };
 
 #endif  // SEMANTIC_SYMBOL_TABLE_HPP
\ No newline at end of file
@@ -1,38 +1,158 @@
 #include "type.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 #include "common.hpp"
 
-bool PrimitiveType::equals(const TypePtr& other) const {
-  auto other_type = std::dynamic_pointer_cast<PrimitiveType>(other);
-  return other_type && basic_type == other_type->basic_type;
+namespace {
+
+size_t hash_combine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+TypeContext& TypeContext::global() {
+  static TypeContext context;
+  return context;
+}
+
+TypeContext::TypeContext() {
+  AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
+  for (auto basic_type : {BasicType::Unknown, BasicType::Int, BasicType::Void}) {
+    primitives[static_cast<int>(basic_type)] =
+        PrimitiveTypePtr(new PrimitiveType(basic_type));
+  }
+}
+
+size_t TypeContext::KeyHash::operator()(const ArrayKey& key) const {
+  size_t seed = std::hash<const Type*>()(key.element_type);
+  for (int dim : key.dims) {
+    seed = hash_combine(seed, std::hash<int>()(dim));
+  }
+  return seed;
+}
+
+size_t TypeContext::KeyHash::operator()(const FuncKey& key) const {
+  size_t seed = std::hash<const Type*>()(key.return_type);
+  for (auto param : key.param_types) {
+    seed = hash_combine(seed, std::hash<const Type*>()(param));
+  }
+  return seed;
+}
+
+PrimitiveTypePtr TypeContext::primitive(BasicType basic_type) {
+  return primitives[static_cast<int>(basic_type)];
+}
+
+ArrayTypePtr TypeContext::array(TypePtr element_type, std::vector<int> dims) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return array_locked(std::move(element_type), std::move(dims));
+}
+
+FuncTypePtr TypeContext::func(TypePtr return_type, std::vector<TypePtr> param_types) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return func_locked(std::move(return_type), std::move(param_types));
 }
 
-bool ArrayType::equals(const TypePtr& other) const {
-  // 判断两个数组类型是否相等
-  // tips: 先判断 other 是否是 ArrayType，然后逐个比较 element_type 和 dims
-  // tips: 对于 dims，或许可以忽略第 0 维
+size_t TypeContext::size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t count = std::size(primitives);
+  for (auto& [key, type] : arrays) {
+    count += !type.expired();
+  }
+  for (auto& [key, type] : funcs) {
+    count += !type.expired();
+  }
+  return count;
+}
 
-// #warning Not implemented: ArrayType::equals
-  auto other_type = std::dynamic_pointer_cast<ArrayType>(other);
-  if (!other_type) return false;
-  if (!element_type->equals(other_type->element_type)) return false;
-  if (dims.size() != other_type->dims.size()) return false;
-  for (size_t i = 1; i < dims.size(); i++) {
-    if (dims[i] != other_type->dims[i]) return false;
+template <typename Map>
+void TypeContext::sweep(Map& map, size_t& sweep_at) {
+  if (map.size() < sweep_at) {
+    return;
+  }
+  for (auto it = map.begin(); it != map.end();) {
+    it = it->second.expired() ? map.erase(it) : std::next(it);
   }
-  return true;
+  sweep_at = std::max<size_t>(64, map.size() * 2);
 }
 
-bool FuncType::equals(const TypePtr& other) const {
-  auto other_type = std::dynamic_pointer_cast<FuncType>(other);
-  if (!other_type || !return_type->equals(other_type->return_type) ||
-      param_types.size() != other_type->param_types.size()) {
-    return false;
+TypePtr TypeContext::canonical_locked(const TypePtr& type) {
+  // 数组和函数类型在建立时已经把它的代表类型也建好并持有，这里的查找总会命中
+  if (auto array_type = std::dynamic_pointer_cast<ArrayType>(type)) {
+    std::vector<int> dims = array_type->dims;
+    if (!dims.empty()) dims[0] = 0;
+    return array_locked(canonical_locked(array_type->element_type), std::move(dims));
   }
-  for (size_t i = 0; i < param_types.size(); i++) {
-    if (!param_types[i]->equals(other_type->param_types[i])) {
-      return false;
+  if (auto func_type = std::dynamic_pointer_cast<FuncType>(type)) {
+    std::vector<TypePtr> param_types;
+    for (auto& param : func_type->param_types) {
+      param_types.push_back(canonical_locked(param));
     }
+    return func_locked(canonical_locked(func_type->return_type), std::move(param_types));
+  }
+  return type;
+}
+
+ArrayTypePtr TypeContext::array_locked(TypePtr element_type, std::vector<int> dims) {
+  // 判断两个数组类型是否相等时忽略第 0 维，形参的第 0 维本来就是空的
+  ArrayKey key{element_type.get(), dims};
+  auto it = arrays.find(key);
+  if (it != arrays.end()) {
+    if (auto type = it->second.lock()) {
+      return type;
+    }
+    arrays.erase(it);
+  }
+  sweep(arrays, arrays_sweep_at);
+  ArrayTypePtr type;
+  {
+    AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
+    type = ArrayTypePtr(new ArrayType(element_type, std::move(dims)));
+    arrays.emplace(std::move(key), type);
+  }
+  TypePtr canonical_element = canonical_locked(element_type);
+  if (canonical_element != element_type || (!type->dims.empty() && type->dims[0] != 0)) {
+    std::vector<int> canonical_dims = type->dims;
+    if (!canonical_dims.empty()) canonical_dims[0] = 0;
+    type->canonical_owner = array_locked(canonical_element, std::move(canonical_dims));
+    type->canonical = type->canonical_owner.get();
+  }
+  return type;
+}
+
+FuncTypePtr TypeContext::func_locked(TypePtr return_type, std::vector<TypePtr> param_types) {
+  FuncKey key{return_type.get(), {}};
+  for (auto& param : param_types) {
+    key.param_types.push_back(param.get());
+  }
+  auto it = funcs.find(key);
+  if (it != funcs.end()) {
+    if (auto type = it->second.lock()) {
+      return type;
+    }
+    funcs.erase(it);
+  }
+  sweep(funcs, funcs_sweep_at);
+  FuncTypePtr type;
+  {
+    AllocProfile::Tag tag(AllocProfile::Category::SharedPtr);
+    type = FuncTypePtr(new FuncType(return_type, std::move(param_types)));
+    funcs.emplace(std::move(key), type);
+  }
+  // 参数类型只要逐个 equals，函数类型就 equals
+  TypePtr canonical_return = canonical_locked(return_type);
+  std::vector<TypePtr> canonical_params;
+  bool is_canonical = canonical_return == return_type;
+  for (auto& param : type->param_types) {
+    canonical_params.push_back(canonical_locked(param));
+    is_canonical = is_canonical && canonical_params.back() == param;
+  }
+  if (!is_canonical) {
+    type->canonical_owner = func_locked(canonical_return, std::move(canonical_params));
+    type->canonical = type->canonical_owner.get();
   }
-  return true;
+  return type;
 }
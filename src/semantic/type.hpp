@@ -2,61 +2,66 @@
 #define SEMANTIC_TYPE_HPP
 
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common.hpp"
+#include "support/alloc_profile.hpp"
+
+class TypeContext;
 
 class Type;
 using TypePtr = std::shared_ptr<Type>;
 class Type {
  public:
-  virtual bool equals(const TypePtr& other) const = 0;
+  /// @brief Whether the two types are the same for type checking
+  /// Every type comes from TypeContext, which links it to one canonical
+  /// representative per equivalence class, so this is a pointer compare.
+  bool equals(const TypePtr& other) const {
+    return other && canonical == other->canonical;
+  }
   virtual std::string to_string() const = 0;
   virtual ~Type() = default;  // make the class polymorphic
+
+ protected:
+  Type() = default;
+  Type(const Type&) = delete;
+  Type& operator=(const Type&) = delete;
+
+ private:
+  friend class TypeContext;
+  const Type* canonical = this;
+  TypePtr canonical_owner;  // keeps canonical alive, nullptr when it is this
 };
 
 class PrimitiveType;
 using PrimitiveTypePtr = std::shared_ptr<PrimitiveType>;
 class PrimitiveType : public Type {
  public:
-  BasicType basic_type;
-
-  PrimitiveType(BasicType basic_type) : basic_type(basic_type) {}
+  const BasicType basic_type;
 
-  static PrimitiveTypePtr create(BasicType basic_type) {
-    return std::make_shared<PrimitiveType>(basic_type);
-  }
-
-  bool equals(const TypePtr& other) const override;
+  static PrimitiveTypePtr create(BasicType basic_type);
 
   std::string to_string() const override { return type_to_string(basic_type); }
 
   static const TypePtr Int;
   static const TypePtr Void;
-};
 
-inline const TypePtr PrimitiveType::Int = PrimitiveType::create(BasicType::Int);
-inline const TypePtr PrimitiveType::Void =
-    PrimitiveType::create(BasicType::Void);
+ private:
+  friend class TypeContext;
+  PrimitiveType(BasicType basic_type) : basic_type(basic_type) {}
+};
 
 class ArrayType;
 using ArrayTypePtr = std::shared_ptr<ArrayType>;
 class ArrayType : public Type {
  public:
-  TypePtr element_type;
-  std::vector<int> dims;
+  const TypePtr element_type;
+  const std::vector<int> dims;
 
-  ArrayType(TypePtr element_type, std::vector<int> dims)
-      : element_type(element_type), dims(dims) {
-    // ASSERT(dims.size() > 0, "Array dimension should be greater than 0");
-  }
-
-  static ArrayTypePtr create(TypePtr element_type, std::vector<int> dims) {
-    return std::make_shared<ArrayType>(element_type, dims);
-  }
-
-  bool equals(const TypePtr& other) const override;
+  static ArrayTypePtr create(TypePtr element_type, std::vector<int> dims);
 
   std::string to_string() const override {
     std::string result = element_type->to_string() + " (*)";
@@ -65,24 +70,24 @@ class ArrayType : public Type {
     }
     return result;
   }
+
+ private:
+  friend class TypeContext;
+  ArrayType(TypePtr element_type, std::vector<int> dims)
+      : element_type(std::move(element_type)), dims(std::move(dims)) {
+    // ASSERT(dims.size() > 0, "Array dimension should be greater than 0");
+  }
 };
 
 class FuncType;
 using FuncTypePtr = std::shared_ptr<FuncType>;
 class FuncType : public Type {
  public:
-  TypePtr return_type;
-  std::vector<TypePtr> param_types;
-
-  FuncType(TypePtr return_type, std::vector<TypePtr> param_types)
-      : return_type(return_type), param_types(param_types) {}
+  const TypePtr return_type;
+  const std::vector<TypePtr> param_types;
 
   static FuncTypePtr create(TypePtr return_type,
-                            std::vector<TypePtr> param_types) {
-    return std::make_shared<FuncType>(return_type, param_types);
-  }
-
-  bool equals(const TypePtr& other) const override;
+                            std::vector<TypePtr> param_types);
 
   std::string to_string() const override {
     std::string result = return_type->to_string() + " (*)(";
@@ -94,6 +99,89 @@ class FuncType : public Type {
     }
     return result + ")";
   }
+
+ private:
+  friend class TypeContext;
+  FuncType(TypePtr return_type, std::vector<TypePtr> param_types)
+      : return_type(std::move(return_type)), param_types(std::move(param_types)) {}
+};
+
+/// @brief Process-wide table of hash-consed types
+/// Each distinct type is built once and shared by every symbol and
+/// expression using it, so types are immutable. The table only holds weak
+/// references: a type is freed with the last symbol using it, and its entry
+/// is swept once the table has doubled, so a long-running server keeps only
+/// the types of the requests in flight. A type
+/// also points at the canonical member of its class under equals: arrays
+/// that differ only in the first dimension check as the same type, like an
+/// `int a[][3]` parameter and an `int b[2][3]` argument, so their canonical
+/// type has the first dimension zeroed.
+class TypeContext {
+ public:
+  static TypeContext& global();
+
+  PrimitiveTypePtr primitive(BasicType basic_type);
+  ArrayTypePtr array(TypePtr element_type, std::vector<int> dims);
+  FuncTypePtr func(TypePtr return_type, std::vector<TypePtr> param_types);
+
+  /// @brief number of types alive
+  size_t size();
+
+ private:
+  struct ArrayKey {
+    const Type* element_type;
+    std::vector<int> dims;
+    bool operator==(const ArrayKey& other) const {
+      return element_type == other.element_type && dims == other.dims;
+    }
+  };
+  struct FuncKey {
+    const Type* return_type;
+    std::vector<const Type*> param_types;
+    bool operator==(const FuncKey& other) const {
+      return return_type == other.return_type && param_types == other.param_types;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const ArrayKey& key) const;
+    size_t operator()(const FuncKey& key) const;
+  };
+
+  TypeContext();
+  ArrayTypePtr array_locked(TypePtr element_type, std::vector<int> dims);
+  FuncTypePtr func_locked(TypePtr return_type, std::vector<TypePtr> param_types);
+  /// @brief the canonical type of an interned type, as a TypePtr
+  TypePtr canonical_locked(const TypePtr& type);
+
+  /// @brief drop the entries of freed types once a table has doubled
+  template <typename Map>
+  static void sweep(Map& map, size_t& sweep_at);
+
+  // primitives are built up front and never change, so reading them needs no lock
+  PrimitiveTypePtr primitives[3];
+  std::mutex mutex;
+  // a live entry keeps the component types in its key alive, so an address
+  // in a key cannot be reused while the entry can still be found
+  std::unordered_map<ArrayKey, std::weak_ptr<ArrayType>, KeyHash> arrays;
+  std::unordered_map<FuncKey, std::weak_ptr<FuncType>, KeyHash> funcs;
+  size_t arrays_sweep_at = 64, funcs_sweep_at = 64;
 };
 
+inline PrimitiveTypePtr PrimitiveType::create(BasicType basic_type) {
+  return TypeContext::global().primitive(basic_type);
+}
+
+inline ArrayTypePtr ArrayType::create(TypePtr element_type, std::vector<int> dims) {
+  return TypeContext::global().array(std::move(element_type), std::move(dims));
+}
+
+inline FuncTypePtr FuncType::create(TypePtr return_type,
+                                    std::vector<TypePtr> param_types) {
+  return TypeContext::global().func(std::move(return_type), std::move(param_types));
+}
+
+inline const TypePtr PrimitiveType::Int = PrimitiveType::create(BasicType::Int);
+inline const TypePtr PrimitiveType::Void =
+    PrimitiveType::create(BasicType::Void);
+
 #endif  // SEMANTIC_TYPE_HPP
\ No newline at end of file
@@ -2,29 +2,35 @@
 
 #include "common.hpp"
 
-TypeChecker::TypeChecker() {
-  // 你需要在这里对 symbol_table 进行初始化
-  // 插入一些内置函数，如 read 和 write
-  symbol_table.enter_scope();
-  std::vector<TypePtr> read_params;
-  auto read_func = FuncType::create(PrimitiveType::Int, read_params);
-  symbol_table.add_symbol("read", read_func, true);
-  
-  std::vector<TypePtr> write_params;
-  write_params.push_back(PrimitiveType::Int);
-  auto write_func = FuncType::create(PrimitiveType::Int, write_params);
-  symbol_table.add_symbol("write", write_func, true);
-
+TypeChecker::TypeChecker() : symbol_table(builtins()) {}
+
+const SymbolTable &TypeChecker::builtins() {
+  // 内置函数（如 read 和 write）所在的全局作用域只建立一次，
+  // 之后每个 TypeChecker 复制一份，内置符号本身是共享且只读的
+  static const SymbolTable table = [] {
+    SymbolTable table;
+    table.enter_scope();
+    std::vector<TypePtr> read_params;
+    auto read_func = FuncType::create(PrimitiveType::Int, read_params);
+    table.add_symbol(Ident("read"), read_func, true);
+
+    std::vector<TypePtr> write_params;
+    write_params.push_back(PrimitiveType::Int);
+    auto write_func = FuncType::create(PrimitiveType::Int, write_params);
+    table.add_symbol(Ident("write"), write_func, true);
+    return table;
+  }();
+  return table;
 }
 
 TypePtr TypeChecker::check(AST::NodePtr node) {
-#define CHECK_NODE(type)                                     \
-  if (auto n = std::dynamic_pointer_cast<AST::type>(node)) { \
-    return check##type(n);                                   \
-  }
+#define CHECK_NODE(type) \
+  case AST::Kind::type:  \
+    return check##type(static_cast<AST::type *>(node));
 
-  // 递归检查 AST 的每个节点
+  // 递归检查 AST 的每个节点，按节点的 kind 分派
   // 如果你添加了新的 AST 节点类型，记得在这里添加对应的检查函数
+  switch (node->kind) {
   CHECK_NODE(CompUnit)
   CHECK_NODE(FuncDef)
   CHECK_NODE(VarDecl)
@@ -39,6 +45,9 @@ TypePtr TypeChecker::check(AST::NodePtr node) {
   CHECK_NODE(IfStmt)
   CHECK_NODE(WhileStmt)
   CHECK_NODE(EmptyStmt)
+  default:
+    break;
+  }
 
 #warning Add more AST node types if needed
 
@@ -65,13 +74,11 @@ TypePtr TypeChecker::checkFuncDef(AST::FuncDefPtr node) {
 
   // 检查函数是否已经被定义过
   if (symbol_table.find_symbol(node->name)) {
-    ASSERT(false, "Function " + node->name + " is already defined");
+    ASSERT(false, "Function " + node->name.str() + " is already defined");
   }
   // 将函数插入符号表并挂载到 FuncDef 节点上
   std::vector<TypePtr> param_types;
   auto return_type = PrimitiveType::create(node->return_btype);  
-  // std::cout << "return type: " << return_type->to_string() << std::endl;
-  // std:: cout << "param type: " << param_types.size() << std::endl;
   if (node->params && !node->params->params.empty()) {
     // 函数参数不为空    
     for (auto param : node->params->params) {
@@ -88,10 +95,11 @@ TypePtr TypeChecker::checkFuncDef(AST::FuncDefPtr node) {
   auto func_type = FuncType::create(return_type, param_types);
   node->symbol = symbol_table.add_symbol(node->name, func_type);
 
+  // 记下当前函数，return 语句据此比较返回类型
+  current_function = node->symbol;
+
   // 创建新的作用域
   symbol_table.enter_scope();
-  // 将函数参数插入新的作用域，为了比较返回类型
-  symbol_table.add_symbol(node->name, func_type);
   // 将函数参数插入符号表
   if (node->params && !node->params->params.empty()) 
     for (auto param : node->params->params) {
@@ -104,14 +112,13 @@ TypePtr TypeChecker::checkFuncDef(AST::FuncDefPtr node) {
       else {
         param->symbol = symbol_table.add_symbol(param->ident, type);
       }
-      // std::cout << "param name: " << param->ident << std::endl;
-      // std::cout << "param type: " << param->symbol->type->to_string() << std::endl;      
     }
   
   // 检查函数体
   checkBlock(node->block, false);
   // 离开作用域
   symbol_table.exit_scope();
+  current_function = nullptr;
   return nullptr;
 }
 
@@ -132,7 +139,7 @@ TypePtr TypeChecker::checkVarDef(AST::VarDefPtr node, BasicType var_type) {
   }
   // 判断变量是否已经被定义过
   if (symbol_table.find_symbol(node->ident, true)) {
-    ASSERT(false, "Variable " + node->ident + " is already defined");
+    ASSERT(false, "Variable " + node->ident.str() + " is already defined");
   }
 
   if (node->inits == nullptr) {
@@ -187,24 +194,11 @@ TypePtr TypeChecker::checkReturnStmt(AST::ReturnStmtPtr node) {
   // 你需要从当前作用域的符号表中获取函数的返回值类型
   // 如果函数没有返回值，你需要判断 expr_type 是否为 void
   // 否则，你需要判断 expr_type 是否和函数的返回值类型一致
-  // auto& scope = symbol_table.scopes[symbol_table.scope_depth];
-  // FuncTypePtr func_type = nullptr;
-  // for (auto& it : scope) {
-  //     func_type = std::dynamic_pointer_cast<FuncType>(it.second->type);
-  // }
-  // find the nearest defined function in the symbol table
   FuncTypePtr func_type = nullptr;
   std::string func_name = "";
-  for (int i = symbol_table.scope_depth; i >= 0 && func_type == nullptr; --i) {
-      auto& scope = symbol_table.scopes[i];      
-      for (auto& it : scope) {
-          func_type = std::dynamic_pointer_cast<FuncType>(it.second->type);
-          if (func_type) {
-              func_name = it.first;             
-              std::cout << "func name for return stmt: " << func_name << std::endl;
-              std::cout << "func type for return stmt: " << func_type->to_string() << std::endl;               
-          }
-      }      
+  if (current_function) {
+    func_type = std::dynamic_pointer_cast<FuncType>(current_function->type);
+    func_name = current_function->name.str();
   }
   if (!func_type) {
     ASSERT(false, "No function found in the current scope at line " +
@@ -222,8 +216,6 @@ TypePtr TypeChecker::checkReturnStmt(AST::ReturnStmtPtr node) {
       auto expr_type = check(node->exp);
       // 函数有返回值
       if (!func_type->return_type->equals(expr_type)) {
-        // std::cout << "func type: " << func_type->to_string() << std::endl;
-        // std::cout << "expr type: " << expr_type->to_string() << std::endl;
         ASSERT(false, "Return type mismatch at line " +
                           std::to_string(node->lineno));            
       }
@@ -242,7 +234,7 @@ TypePtr TypeChecker::checkLVal(AST::LValPtr node) {
   // 你需要返回 LVal 的类型
   auto symbol = symbol_table.find_symbol(node->ident);
   if (!symbol) {
-    ASSERT(false, "Variable " + node->ident + "at line " + std::to_string(node->lineno) + " is not defined");
+    ASSERT(false, "Variable " + node->ident.str() + "at line " + std::to_string(node->lineno) + " is not defined");
   }
 
   if (auto type = std::dynamic_pointer_cast<ArrayType>(symbol->type)) {    
@@ -303,15 +295,13 @@ TypePtr TypeChecker::checkFuncCall(AST::FuncCallPtr node) {
   // 你需要返回函数调用表达式的类型
   auto symbol = symbol_table.find_symbol(node->name);
   if (!symbol) {
-    ASSERT(false, "Function " + node->name + " is not defined");
+    ASSERT(false, "Function " + node->name.str() + " is not defined");
   }
   node->symbol = symbol;
   auto func_type = std::dynamic_pointer_cast<FuncType>(symbol->type);
   if (!func_type) {
-    ASSERT(false, node->name + " is not a function");
+    ASSERT(false, node->name.str() + " is not a function");
   }
-  // std::cout << "func name: " << node->name << std::endl;
-  // std::cout << "func type: " << func_type->to_string() << std::endl;
   
   // 检查函数参数的个数和类型是否和声明一致
   checkFuncFParams(node->args, func_type->param_types);
@@ -345,7 +335,7 @@ TypePtr TypeChecker::checkBinaryExp(AST::BinaryExpPtr node) {
 TypePtr TypeChecker::checkInitVal(AST::InitValPtr node,
                                   ArrayTypePtr array_type) {                                    
   auto val = node->inits[0];  
-  if (auto n = std::dynamic_pointer_cast<AST::InitList>(val)) {
+  if (auto n = AST::dyn_cast<AST::InitList>(val)) {
     // 初值列表
     if (array_type->dims.size() == 0) {
       ASSERT(false, "Non-Array Can not initialize with list " +
@@ -361,8 +351,6 @@ TypePtr TypeChecker::checkInitVal(AST::InitValPtr node,
                         std::to_string(node->lineno));
     }
     auto type = check(val);
-    std::cout << "type: " << type->to_string() << std::endl;
-    std::cout << "Element type: " << array_type->element_type->to_string() << std::endl;
     if (!type->equals(array_type->element_type)) {
       ASSERT(false, "Initialization type mismatch at line " +
                         std::to_string(node->lineno));
@@ -379,9 +367,6 @@ TypePtr TypeChecker::checkInitList(AST::InitListPtr node,
   // 2. 在抵达初值列表结尾时，如果对应数组仍未被填满，则填 0 直到对应数组被填满：
   // 3. 在初值列表内，可以用嵌套的初值列表对子数组进行初始化：
   // 4. 遇到嵌套的初值列表时，根据已经填充的元素数决定该初值列表对应的子数组，并尽量选择更大的子数组：
-  std::cout << "array type: " << array_type->to_string() << std::endl;
-  std::cout << "array type: " << array_type->element_type->to_string() << std::endl;
-  std::cout << "array type: " << array_type->dims.size() << std::endl;
   int filled_elements = 0;
   int total_elements = 1;
   for (auto d : array_type->dims) {
@@ -391,8 +376,8 @@ TypePtr TypeChecker::checkInitList(AST::InitListPtr node,
   ArrayTypePtr subarray_type = nullptr;
   int subarray_size;
   for (auto element : elements) {  
-    auto val = std::dynamic_pointer_cast<AST::InitVal>(element);
-    if (auto n = std::dynamic_pointer_cast<AST::InitList>(val->inits[0])) {
+    auto val = AST::dyn_cast<AST::InitVal>(element);
+    if (auto n = AST::dyn_cast<AST::InitList>(val->inits[0])) {
       // 子数组
       for (int i = 1; i < array_type->dims.size(); i++) {
           subarray_type = nullptr;
@@ -418,15 +403,12 @@ TypePtr TypeChecker::checkInitList(AST::InitListPtr node,
     else {
       // 标量
       auto type = check(val->inits[0]);
-      std::cout << "type: " << type->to_string() << std::endl;
-      std::cout << "array type: " << array_type->to_string() << std::endl;
       if (!type->equals(array_type->element_type)) {
         ASSERT(false, "Initialization type mismatch at line " +
                           std::to_string(node->lineno));
       }
       filled_elements++;
     }      
-    std::cout << "filled elements: " << filled_elements << "/" << total_elements << std::endl;
    
     if (filled_elements > total_elements) {
       ASSERT(false, "Excess initializers at line " +
@@ -479,8 +461,6 @@ TypePtr TypeChecker::checkFuncFParams(
 
   for (size_t i = 0; i < args.size(); i++) {
     auto arg_type = check(args[i]);
-    std::cout << "arg type: " << arg_type->to_string() << std::endl;
-    std::cout << "param type: " << param_types[i]->to_string() << std::endl;
     if (!arg_type->equals(param_types[i])) {
       ASSERT(false, "Function parameter type mismatch");
     }    
@@ -15,6 +15,10 @@ class TypeChecker {
  private:
   /// @brief The symbol table
   SymbolTable symbol_table;
+  /// @brief symbol table holding only the builtin functions, built once
+  static const SymbolTable &builtins();
+  /// @brief symbol of the function being checked, nullptr outside functions
+  SymbolPtr current_function;
 
   TypePtr checkIntConst(AST::IntConstPtr node);
   TypePtr checkLVal(AST::LValPtr node);
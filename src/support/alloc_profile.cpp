@@ -0,0 +1,175 @@
+#include "alloc_profile.hpp"
+
+#include <iomanip>
+
+#ifdef ALLOC_PROFILE
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace {
+
+/// @brief counters of one (phase, category) pair
+struct Cell {
+  std::atomic<long> allocs, bytes, frees, live;
+};
+
+// all of this is zero-initialized before any constructor runs, so the hooks
+// work for allocations made during static initialization too
+Cell cells[AllocProfile::max_phases][AllocProfile::num_categories];
+std::atomic<long> peak_live[AllocProfile::max_phases];  // heap size, sampled per phase
+std::atomic<long> live_total;
+std::atomic<const char *> phase_names[AllocProfile::max_phases];
+std::atomic<int> phase_count{1};
+std::mutex phase_mutex;
+
+/// @brief stored in front of every block, so delete knows whom to charge
+struct alignas(16) Header {
+  size_t size;
+  int phase;
+  int category;
+};
+static_assert(sizeof(Header) == 16, "the header must keep malloc's alignment");
+
+int find_phase(const char *name) {
+  int count = phase_count.load(std::memory_order_acquire);
+  for (int i = 1; i < count; i++) {
+    const char *known = phase_names[i].load(std::memory_order_relaxed);
+    if (known == name || std::strcmp(known, name) == 0) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+void *allocate(size_t size, bool nothrow) {
+  auto header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+  if (!header) {
+    if (nothrow) {
+      return nullptr;
+    }
+    throw std::bad_alloc();
+  }
+  header->size = size;
+  header->phase = AllocProfile::current_phase;
+  header->category = static_cast<int>(AllocProfile::current_category);
+
+  Cell &cell = cells[header->phase][header->category];
+  cell.allocs.fetch_add(1, std::memory_order_relaxed);
+  cell.bytes.fetch_add(size, std::memory_order_relaxed);
+  cell.live.fetch_add(size, std::memory_order_relaxed);
+  long live = live_total.fetch_add(size, std::memory_order_relaxed) + size;
+  auto &peak = peak_live[header->phase];
+  long old = peak.load(std::memory_order_relaxed);
+  while (live > old && !peak.compare_exchange_weak(old, live, std::memory_order_relaxed)) {
+  }
+  return header + 1;
+}
+
+void release(void *p) {
+  if (!p) {
+    return;
+  }
+  auto header = static_cast<Header *>(p) - 1;
+  Cell &cell = cells[header->phase][header->category];
+  cell.frees.fetch_add(1, std::memory_order_relaxed);
+  cell.live.fetch_sub(header->size, std::memory_order_relaxed);
+  live_total.fetch_sub(header->size, std::memory_order_relaxed);
+  std::free(header);
+}
+
+}  // namespace
+
+AllocProfile::Phase::Phase(const char *name) : saved(current_phase) {
+  int index = find_phase(name);
+  if (index == 0) {
+    std::lock_guard<std::mutex> lock(phase_mutex);
+    index = find_phase(name);
+    int count = phase_count.load(std::memory_order_relaxed);
+    if (index == 0 && count < max_phases) {
+      phase_names[count].store(name, std::memory_order_relaxed);
+      phase_count.store(count + 1, std::memory_order_release);
+      index = count;
+    }
+  }
+  current_phase = index;
+}
+
+void *operator new(std::size_t size) { return allocate(size, false); }
+void *operator new[](std::size_t size) { return allocate(size, false); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, true);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, true);
+}
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+
+void AllocProfile::print(std::ostream &out) {
+  static const char *const category_names[num_categories] = {"other", "arena", "ident",
+                                                             "shared_ptr", "output"};
+  // snapshot first: printing allocates too
+  struct Row {
+    int phase, category;
+    long allocs, bytes, frees, live;
+  };
+  Row rows[max_phases * num_categories];
+  int num_rows = 0;
+  int count = phase_count.load(std::memory_order_acquire);
+  for (int phase = 0; phase < count; phase++) {
+    for (int category = 0; category < num_categories; category++) {
+      const Cell &cell = cells[phase][category];
+      long allocs = cell.allocs.load(std::memory_order_relaxed);
+      if (allocs > 0) {
+        rows[num_rows++] = {phase,
+                            category,
+                            allocs,
+                            cell.bytes.load(std::memory_order_relaxed),
+                            cell.frees.load(std::memory_order_relaxed),
+                            cell.live.load(std::memory_order_relaxed)};
+      }
+    }
+  }
+
+  out << "===== Allocation report =====\n";
+  out << std::left << std::setw(14) << "Phase" << std::setw(12) << "Category" << std::right
+      << std::setw(12) << "Allocs" << std::setw(12) << "KiB" << std::setw(12) << "Frees"
+      << std::setw(12) << "Live KiB" << std::setw(12) << "Peak KiB" << '\n';
+  long allocs = 0, bytes = 0;
+  int last_phase = -1;
+  for (int i = 0; i < num_rows; i++) {
+    const Row &row = rows[i];
+    const char *phase = row.phase == 0 ? "(none)" : phase_names[row.phase].load();
+    out << std::left << std::setw(14) << (row.phase == last_phase ? "" : phase) << std::setw(12)
+        << category_names[row.category] << std::right << std::setw(12) << row.allocs
+        << std::setw(12) << row.bytes / 1024 << std::setw(12) << row.frees << std::setw(12)
+        << row.live / 1024;
+    // the peak belongs to the phase, print it once on its first row
+    if (row.phase != last_phase) {
+      out << std::setw(12) << peak_live[row.phase].load(std::memory_order_relaxed) / 1024;
+    }
+    out << '\n';
+    last_phase = row.phase;
+    allocs += row.allocs;
+    bytes += row.bytes;
+  }
+  out << std::left << std::setw(26) << "sum" << std::right << std::setw(12) << allocs
+      << std::setw(12) << bytes / 1024 << std::setw(24) << live_total.load() / 1024 << '\n';
+  out.flush();
+}
+
+#else
+
+void AllocProfile::print(std::ostream &out) {
+  out << "Allocation profile needs a build with make ALLOC_PROFILE=1" << std::endl;
+}
+
+#endif  // ALLOC_PROFILE
@@ -0,0 +1,81 @@
+#ifndef SUPPORT_ALLOC_PROFILE_HPP
+#define SUPPORT_ALLOC_PROFILE_HPP
+
+#include <ostream>
+
+/// @brief Heap profile of the compiler itself, for builds with
+/// `make ALLOC_PROFILE=1`
+/// That build replaces the global operator new and delete with hooks that
+/// count every allocation against the phase running on the calling thread
+/// (the phases of TimeReport::Scope) and against the innermost Tag, the
+/// kind of object being allocated. Frees are charged back to the phase and
+/// category that allocated the block, so what is left at the end is what a
+/// phase retained. --alloc-report prints the result.
+///
+/// In a normal build Phase and Tag are empty and the hooks do not exist.
+class AllocProfile {
+ public:
+#ifdef ALLOC_PROFILE
+  static constexpr bool available = true;
+#else
+  static constexpr bool available = false;
+#endif
+
+  enum class Category {
+    Other,
+    Arena,      // arena chunks: AST nodes, IR and ASM instructions
+    Ident,      // entries of the identifier table
+    SharedPtr,  // objects made by make_shared, with what their constructors allocate
+    Output,     // formatted assembly
+  };
+  static constexpr int num_categories = 5;
+  static constexpr int max_phases = 32;
+
+  /// @brief charges allocations of this thread to a phase until destroyed
+  class Phase {
+   public:
+#ifdef ALLOC_PROFILE
+    explicit Phase(const char *name);
+    ~Phase() { current_phase = saved; }
+#else
+    explicit Phase(const char *) {}
+#endif
+    Phase(const Phase &) = delete;
+    Phase &operator=(const Phase &) = delete;
+
+#ifdef ALLOC_PROFILE
+   private:
+    int saved;
+#endif
+  };
+
+  /// @brief charges allocations of this thread to a category until destroyed
+  class Tag {
+   public:
+#ifdef ALLOC_PROFILE
+    explicit Tag(Category category) : saved(current_category) { current_category = category; }
+    ~Tag() { current_category = saved; }
+#else
+    explicit Tag(Category) {}
+#endif
+    Tag(const Tag &) = delete;
+    Tag &operator=(const Tag &) = delete;
+
+#ifdef ALLOC_PROFILE
+   private:
+    Category saved;
+#endif
+  };
+
+  /// @brief print allocations, bytes and what is still live per phase and
+  /// category, and the peak live heap seen while each phase ran
+  static void print(std::ostream &out);
+
+#ifdef ALLOC_PROFILE
+  // read by the operator new hooks
+  static inline thread_local int current_phase = 0;  // 0 is outside any phase
+  static inline thread_local Category current_category = Category::Other;
+#endif
+};
+
+#endif  // SUPPORT_ALLOC_PROFILE_HPP
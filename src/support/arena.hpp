@@ -0,0 +1,135 @@
+#ifndef SUPPORT_ARENA_HPP
+#define SUPPORT_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "support/alloc_profile.hpp"
+
+/// @brief Bump-pointer arena
+/// Objects are carved out of large chunks and are all destroyed together when
+/// the arena is released, so a whole tree costs a handful of heap blocks and
+/// is torn down in one shot instead of node by node.
+class Arena {
+ public:
+  static constexpr size_t default_chunk_size = 64 * 1024;
+
+  explicit Arena(size_t chunk_size = default_chunk_size)
+      : chunk_size(chunk_size) {}
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena() { release(); }
+
+  /// @brief Construct a T inside the arena
+  /// @return A non-owning pointer, valid until the arena is released
+  template <typename T, typename... Args>
+  T *create(Args &&...args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      dtors.push_back({obj, [](void *p) { static_cast<T *>(p)->~T(); }});
+    }
+    return obj;
+  }
+
+  /// @brief Allocate raw, uninitialized memory
+  void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    size_t pad = (align - reinterpret_cast<uintptr_t>(cur) % align) % align;
+    if (cur == nullptr || size + pad > static_cast<size_t>(end - cur)) {
+      grow(size + align);
+      pad = (align - reinterpret_cast<uintptr_t>(cur) % align) % align;
+    }
+    char *p = cur + pad;
+    cur = p + size;
+    return p;
+  }
+
+  /// @brief Destroy every object and give all chunks back
+  void release() {
+    destroy_all();
+    chunks.clear();
+    used = 0;
+    cur = end = nullptr;
+    reserved = 0;
+  }
+
+  /// @brief Destroy every object but keep the chunks
+  /// The next round of allocations reuses them, so a long-lived arena that
+  /// is reset between compilation units stops hitting the system allocator.
+  void reset() {
+    destroy_all();
+    used = 0;
+    cur = end = nullptr;
+  }
+
+  /// @brief A position in the arena, see rewind()
+  struct Mark {
+    size_t used = 0;
+    char *cur = nullptr;
+    size_t dtors = 0;
+  };
+  Mark mark() const { return {used, cur, dtors.size()}; }
+
+  /// @brief Destroy every object created since m was taken
+  /// Their memory is handed out again by the next allocations; chunks that
+  /// were started after m become spares, as with reset().
+  void rewind(const Mark &m) {
+    for (size_t i = dtors.size(); i > m.dtors; i--) {
+      dtors[i - 1].second(dtors[i - 1].first);
+    }
+    dtors.resize(m.dtors);
+    used = m.used;
+    cur = m.cur;
+    end = used > 0 ? chunks[used - 1].data.get() + chunks[used - 1].size : nullptr;
+  }
+
+  /// @brief Bytes reserved from the system allocator
+  size_t bytes_reserved() const { return reserved; }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  size_t chunk_size;
+  /// @brief chunks[0, used) hold objects, the rest are spares kept by reset()
+  std::vector<Chunk> chunks;
+  size_t used = 0;
+  char *cur = nullptr;
+  char *end = nullptr;
+  size_t reserved = 0;
+  /// @brief destructors of non-trivial objects, run in reverse order
+  std::vector<std::pair<void *, void (*)(void *)>> dtors;
+
+  void grow(size_t min_size) {
+    auto spare = std::find_if(chunks.begin() + used, chunks.end(),
+                              [&](const Chunk &c) { return c.size >= min_size; });
+    if (spare == chunks.end()) {
+      AllocProfile::Tag tag(AllocProfile::Category::Arena);
+      size_t size = std::max(chunk_size, min_size);
+      chunks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+      reserved += size;
+      spare = chunks.end() - 1;
+    }
+    std::iter_swap(chunks.begin() + used, spare);
+    Chunk &chunk = chunks[used++];
+    cur = chunk.data.get();
+    end = cur + chunk.size;
+  }
+
+  void destroy_all() {
+    for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) {
+      it->second(it->first);
+    }
+    dtors.clear();
+  }
+};
+
+#endif  // SUPPORT_ARENA_HPP
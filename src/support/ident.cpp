@@ -0,0 +1,45 @@
+#include "ident.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "support/alloc_profile.hpp"
+
+/// @brief process-wide interning table
+/// Entries live in a deque so they never move; the map keys view their text.
+struct Ident::Table {
+  std::mutex mutex;
+  std::deque<Entry> entries;
+  std::unordered_map<std::string_view, const Entry *> index;
+};
+
+Ident::Table &Ident::table() {
+  static Table instance;
+  return instance;
+}
+
+const Ident::Entry *Ident::intern(std::string_view text) {
+  auto &t = table();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  auto it = t.index.find(text);
+  if (it != t.index.end()) {
+    return it->second;
+  }
+  AllocProfile::Tag tag(AllocProfile::Category::Ident);
+  t.entries.push_back({std::string(text), static_cast<uint32_t>(t.entries.size() + 1)});
+  const Entry *entry = &t.entries.back();
+  t.index.emplace(entry->text, entry);
+  return entry;
+}
+
+const std::string &Ident::str() const {
+  static const std::string empty_text;
+  return entry ? entry->text : empty_text;
+}
+
+size_t Ident::count() {
+  auto &t = table();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  return t.entries.size();
+}
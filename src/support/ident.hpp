@@ -0,0 +1,57 @@
+#ifndef SUPPORT_IDENT_HPP
+#define SUPPORT_IDENT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/// @brief Interned identifier
+/// Every distinct spelling is stored exactly once for the whole process and
+/// gets a dense id, so an Ident is a single pointer: copying is free and
+/// equality is a pointer compare. A default-constructed Ident is empty.
+class Ident {
+ public:
+  Ident() = default;
+  // interning locks the process-wide table, so conversions are explicit
+  explicit Ident(std::string_view text) : entry(intern(text)) {}
+  explicit Ident(const std::string &text) : entry(intern(text)) {}
+  explicit Ident(const char *text) : entry(intern(text)) {}
+
+  bool empty() const { return entry == nullptr; }
+  const std::string &str() const;
+  /// @brief dense id in interning order, 0 for the empty Ident
+  uint32_t id() const { return entry ? entry->id : 0; }
+
+  bool operator==(const Ident &other) const { return entry == other.entry; }
+  bool operator!=(const Ident &other) const { return entry != other.entry; }
+  bool operator<(const Ident &other) const { return id() < other.id(); }
+
+  /// @brief number of distinct identifiers interned so far
+  static size_t count();
+
+ private:
+  struct Entry {
+    std::string text;
+    uint32_t id;
+  };
+  struct Table;
+  const Entry *entry = nullptr;
+
+  static Table &table();
+  static const Entry *intern(std::string_view text);
+};
+
+inline std::ostream &operator<<(std::ostream &os, const Ident &ident) {
+  return os << ident.str();
+}
+
+namespace std {
+template <>
+struct hash<Ident> {
+  size_t operator()(const Ident &ident) const { return ident.id(); }
+};
+}  // namespace std
+
+#endif  // SUPPORT_IDENT_HPP
@@ -0,0 +1,179 @@
+#ifndef SUPPORT_ILIST_HPP
+#define SUPPORT_ILIST_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+
+template <typename T>
+class IList;
+
+/// @brief Link fields embedded in every element of an IList
+/// An element can be in at most one list at a time.
+template <typename T>
+class IListNode {
+ public:
+  T *prev_node() const { return prev; }
+  T *next_node() const { return next; }
+
+ private:
+  friend class IList<T>;
+  T *prev = nullptr;
+  T *next = nullptr;
+};
+
+/// @brief Intrusive doubly-linked list
+/// The list does not own its elements (they live in a pool); pushing,
+/// inserting, erasing and splicing only relink pointers and never allocate.
+/// Iterators stay valid until the element they point to is unlinked.
+template <typename T>
+class IList {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T *const *;
+    using reference = T *const &;
+
+    iterator() = default;
+    reference operator*() const { return node; }
+    pointer operator->() const { return &node; }
+    iterator &operator++() {
+      node = node->next;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+    iterator &operator--() {
+      node = node ? node->prev : list->tail;
+      return *this;
+    }
+    iterator operator--(int) {
+      iterator old = *this;
+      --*this;
+      return old;
+    }
+    bool operator==(const iterator &other) const { return node == other.node; }
+    bool operator!=(const iterator &other) const { return node != other.node; }
+
+   private:
+    friend class IList;
+    T *node = nullptr;
+    const IList *list = nullptr;
+    iterator(T *node, const IList *list) : node(node), list(list) {}
+  };
+  using const_iterator = iterator;
+
+  IList() = default;
+  IList(std::initializer_list<T *> nodes) {
+    for (T *node : nodes) {
+      push_back(node);
+    }
+  }
+  IList(const IList &) = delete;
+  IList &operator=(const IList &) = delete;
+  IList(IList &&other) noexcept { take(other); }
+  IList &operator=(IList &&other) noexcept {
+    if (this != &other) {
+      clear();
+      take(other);
+    }
+    return *this;
+  }
+  /// nodes belong to their pool, which may already be released when the
+  /// list goes away, so the destructor does not touch them
+  ~IList() = default;
+
+  bool empty() const { return head == nullptr; }
+  size_t size() const { return count; }
+  T *front() const { return head; }
+  T *back() const { return tail; }
+
+  iterator begin() const { return iterator(head, this); }
+  iterator end() const { return iterator(nullptr, this); }
+  /// @brief iterator to an element of this list
+  iterator iterator_to(T *node) const { return iterator(node, this); }
+
+  void push_back(T *node) { insert(end(), node); }
+  void push_front(T *node) { insert(begin(), node); }
+
+  /// @brief link node before pos
+  /// @return iterator to the inserted node
+  iterator insert(iterator pos, T *node) {
+    assert(!node->prev && !node->next && "node is already in a list");
+    T *next = pos.node;
+    T *prev = next ? next->prev : tail;
+    node->prev = prev;
+    node->next = next;
+    (prev ? prev->next : head) = node;
+    (next ? next->prev : tail) = node;
+    ++count;
+    return iterator(node, this);
+  }
+
+  /// @brief unlink the node at pos
+  /// @return iterator to the node after it
+  iterator erase(iterator pos) {
+    T *node = pos.node;
+    T *next = node->next;
+    (node->prev ? node->prev->next : head) = node->next;
+    (node->next ? node->next->prev : tail) = node->prev;
+    node->prev = node->next = nullptr;
+    --count;
+    return iterator(next, this);
+  }
+
+  T *pop_front() {
+    T *node = head;
+    erase(begin());
+    return node;
+  }
+
+  /// @brief move every node of other before pos, other becomes empty
+  void splice(iterator pos, IList &other) {
+    if (other.empty() || &other == this) {
+      return;
+    }
+    T *next = pos.node;
+    T *prev = next ? next->prev : tail;
+    other.head->prev = prev;
+    other.tail->next = next;
+    (prev ? prev->next : head) = other.head;
+    (next ? next->prev : tail) = other.tail;
+    count += other.count;
+    other.head = other.tail = nullptr;
+    other.count = 0;
+  }
+
+  /// @brief unlink every node, the nodes themselves are untouched
+  void clear() {
+    while (head) {
+      T *next = head->next;
+      head->prev = head->next = nullptr;
+      head = next;
+    }
+    tail = nullptr;
+    count = 0;
+  }
+
+ private:
+  T *head = nullptr;
+  T *tail = nullptr;
+  size_t count = 0;
+
+  void take(IList &other) {
+    head = other.head;
+    tail = other.tail;
+    count = other.count;
+    other.head = other.tail = nullptr;
+    other.count = 0;
+  }
+};
+
+#endif  // SUPPORT_ILIST_HPP
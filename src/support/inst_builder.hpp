@@ -0,0 +1,65 @@
+#ifndef SUPPORT_INST_BUILDER_HPP
+#define SUPPORT_INST_BUILDER_HPP
+
+#include <cassert>
+#include <utility>
+
+#include "support/ilist.hpp"
+
+/// @brief Instruction builder with an insertion point
+/// Instructions are created and linked in place at the insertion point, so
+/// passes never build intermediate lists that have to be merged into their
+/// parent afterwards. Shared by the IR translator and the backend.
+template <typename Node>
+class InstBuilder {
+ public:
+  using Code = IList<Node>;
+
+  InstBuilder() = default;
+  explicit InstBuilder(Code &code) { set_insert_point(code); }
+
+  /// @brief insert at the end of code
+  void set_insert_point(Code &code) { set_insert_point(code, code.end()); }
+  /// @brief insert before pos in code
+  void set_insert_point(Code &code, typename Code::iterator pos) {
+    this->code = &code;
+    this->pos = pos;
+  }
+
+  Code *get_code() const { return code; }
+
+  /// @brief create an instruction and insert it at the insertion point
+  template <typename T, typename... Args>
+  T *emit(Args &&...args) {
+    auto inst = T::create(std::forward<Args>(args)...);
+    insert(inst);
+    return inst;
+  }
+
+  void insert(Node *inst) {
+    assert(code && "builder has no insertion point");
+    code->insert(pos, inst);
+  }
+
+  class Guard;
+
+ private:
+  Code *code = nullptr;
+  typename Code::iterator pos;
+};
+
+/// @brief restores the insertion point when it goes out of scope
+template <typename Node>
+class InstBuilder<Node>::Guard {
+ public:
+  explicit Guard(InstBuilder &builder) : builder(builder), saved(builder) {}
+  ~Guard() { builder = saved; }
+  Guard(const Guard &) = delete;
+  Guard &operator=(const Guard &) = delete;
+
+ private:
+  InstBuilder &builder;
+  InstBuilder saved;
+};
+
+#endif  // SUPPORT_INST_BUILDER_HPP
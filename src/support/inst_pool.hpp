@@ -0,0 +1,36 @@
+#ifndef SUPPORT_INST_POOL_HPP
+#define SUPPORT_INST_POOL_HPP
+
+#include <cassert>
+
+#include "support/arena.hpp"
+
+/// @brief Arena that owns IR and ASM instructions
+/// The create() factories of IR and ASM instructions allocate from the pool
+/// that is active on the calling thread, so each function's instructions
+/// end up packed together in its own pool.
+class InstPool : public Arena {
+ public:
+  /// @brief the pool create() allocates from on this thread
+  static InstPool &current() {
+    assert(active && "no active instruction pool");
+    return *active;
+  }
+
+  /// @brief makes a pool the active one for the lifetime of the scope
+  class Scope {
+   public:
+    explicit Scope(InstPool &pool) : saved(active) { active = &pool; }
+    ~Scope() { active = saved; }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    InstPool *saved;
+  };
+
+ private:
+  static inline thread_local InstPool *active = nullptr;
+};
+
+#endif  // SUPPORT_INST_POOL_HPP
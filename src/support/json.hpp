@@ -0,0 +1,27 @@
+#ifndef SUPPORT_JSON_HPP
+#define SUPPORT_JSON_HPP
+
+#include <cstdio>
+#include <string_view>
+
+/// @brief append text to out as a quoted JSON string
+/// Out is anything with operator<< for char and const char *, e.g. an
+/// std::ostream or a Writer.
+template <typename Out>
+void write_json_string(Out &out, std::string_view text) {
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escape[8];
+      std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(c));
+      out << static_cast<const char *>(escape);
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+#endif  // SUPPORT_JSON_HPP
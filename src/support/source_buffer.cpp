@@ -0,0 +1,136 @@
+#include "source_buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+/// @brief closes the descriptor on every way out of map_file
+struct FileDescriptor {
+  int fd;
+  explicit FileDescriptor(int fd) : fd(fd) {}
+  ~FileDescriptor() {
+    if (fd >= 0) close(fd);
+  }
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+};
+
+void check_size(size_t size, const std::string &what) {
+  if (size > SourceBuffer::max_size) {
+    throw std::runtime_error(what + " is too large: sources are limited to 4 GiB");
+  }
+}
+
+}  // namespace
+
+SourceBuffer SourceBuffer::open(const std::string &path) {
+  if (path == "-") {
+    return read_fd(STDIN_FILENO);
+  }
+  return map_file(path);
+}
+
+SourceBuffer SourceBuffer::map_file(const std::string &path) {
+  FileDescriptor file(::open(path.c_str(), O_RDONLY));
+  int fd = file.fd;
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open file: " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+    // not a regular file (e.g. a FIFO), fall back to reading it
+    return read_fd(fd);
+  }
+  check_size(st.st_size, path);
+
+  // Reserve room for the text plus the padding as zero-filled anonymous
+  // memory, then map the file over its start. The tail of the last file page
+  // and everything after it reads as NUL, so the padding comes for free even
+  // when the file ends exactly on a page boundary. MAP_PRIVATE keeps flex's
+  // in-place writes away from the file; MAP_POPULATE reads the file in now,
+  // since the scanner is going to touch every page anyway.
+  size_t size = st.st_size;
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t total = (size + padding + page - 1) / page * page;
+  void *base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("Cannot map file: " + path);
+  }
+  if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, fd, 0) == MAP_FAILED) {
+    munmap(base, total);
+    throw std::runtime_error("Cannot map file: " + path);
+  }
+
+  SourceBuffer buffer;
+  buffer.text = static_cast<char *>(base);
+  buffer.length = size;
+  buffer.mapped = total;
+  return buffer;
+}
+
+SourceBuffer SourceBuffer::read_fd(int fd) {
+  std::string content(64 * 1024, '\0');
+  size_t used = 0;
+  for (;;) {
+    if (used == content.size()) {
+      content.resize(content.size() * 2);
+    }
+    ssize_t n = read(fd, content.data() + used, content.size() - used);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      throw std::runtime_error("Cannot read input");
+    }
+    if (n == 0) break;
+    used += n;
+    check_size(used, "Input");
+  }
+  content.resize(used);
+  SourceBuffer buffer;
+  buffer.adopt(std::move(content));
+  return buffer;
+}
+
+SourceBuffer::SourceBuffer(std::string text) { adopt(std::move(text)); }
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept { *this = std::move(other); }
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept {
+  if (this != &other) {
+    release();
+    length = other.length;
+    mapped = other.mapped;
+    storage = std::move(other.storage);
+    // a moved std::string may hold its text inline, so look it up again
+    text = mapped ? other.text : storage.data();
+    other.text = nullptr;
+    other.length = other.mapped = 0;
+  }
+  return *this;
+}
+
+SourceBuffer::~SourceBuffer() { release(); }
+
+void SourceBuffer::adopt(std::string &&content) {
+  check_size(content.size(), "Source");
+  length = content.size();
+  storage = std::move(content);
+  storage.append(padding, '\0');
+  text = storage.data();
+}
+
+void SourceBuffer::release() {
+  if (mapped) {
+    munmap(text, mapped);
+  }
+  text = nullptr;
+  length = mapped = 0;
+  storage.clear();
+}
@@ -0,0 +1,59 @@
+#ifndef SUPPORT_SOURCE_BUFFER_HPP
+#define SUPPORT_SOURCE_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Source text of a compilation unit, ready to be scanned in place
+/// The text is followed by two NUL bytes, which is what flex's
+/// yy_scan_buffer() expects, so the scanner works on this memory directly
+/// instead of copying the input through YY_INPUT. Tokens refer back into it
+/// by offset, so the buffer has to outlive the parse.
+class SourceBuffer {
+ public:
+  /// @brief bytes past the end of the text that must be NUL
+  static constexpr size_t padding = 2;
+  /// @brief longest text accepted; tokens store 32-bit offsets (TokenText)
+  static constexpr size_t max_size = UINT32_MAX;
+
+  /// @brief map a file into memory; "-" reads standard input instead
+  /// throws std::runtime_error if the file cannot be read or is longer
+  /// than max_size
+  static SourceBuffer open(const std::string &path);
+
+  /// @brief map a file into memory
+  static SourceBuffer map_file(const std::string &path);
+
+  /// @brief read a whole stream (e.g. a pipe) into a growable buffer
+  static SourceBuffer read_fd(int fd);
+
+  /// @brief take over text that is already in memory
+  explicit SourceBuffer(std::string text);
+
+  SourceBuffer(SourceBuffer &&other) noexcept;
+  SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer &operator=(const SourceBuffer &) = delete;
+  ~SourceBuffer();
+
+  /// @brief the text, followed by `padding` NUL bytes
+  /// writable because flex temporarily terminates each token in place
+  char *data() { return text; }
+  const char *data() const { return text; }
+  /// @brief length of the text, without the padding
+  size_t size() const { return length; }
+
+ private:
+  SourceBuffer() = default;
+
+  char *text = nullptr;
+  size_t length = 0;
+  size_t mapped = 0;    // bytes mapped with mmap, 0 if text lives in storage
+  std::string storage;  // text read from a stream or handed over in memory
+
+  void adopt(std::string &&content);
+  void release();
+};
+
+#endif  // SUPPORT_SOURCE_BUFFER_HPP
@@ -0,0 +1,133 @@
+#include "statistics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "support/json.hpp"
+
+namespace {
+
+/// @brief counters shown as columns of the per-function table
+struct Column {
+  const char *counter;
+  const char *title;
+};
+constexpr Column columns[] = {
+    {"ir.insts", "IR"},           {"ir.temps", "Temps"},         {"cfg.blocks", "Blocks"},
+    {"asm.vregs", "VRegs"},       {"spill.loads", "SpillLd"},    {"spill.stores", "SpillSt"},
+    {"frame.bytes", "Frame"},     {"asm.insts", "ASM"},          {"asm.imm_expansions", "ImmExp"},
+};
+
+long lookup(const std::map<std::string, long, std::less<>> &counters, std::string_view name) {
+  auto it = counters.find(name);
+  return it == counters.end() ? 0 : it->second;
+}
+
+void write_json_counters(std::ostream &out, const std::map<std::string, long, std::less<>> &counters,
+                         const char *indent) {
+  out << '{';
+  bool first = true;
+  for (const auto &[name, value] : counters) {
+    out << (first ? "\n" : ",\n") << indent << "  ";
+    write_json_string(out, name);
+    out << ": " << value;
+    first = false;
+  }
+  out << (first ? "}" : std::string("\n") + indent + "}");
+}
+
+}  // namespace
+
+Statistics &Statistics::global() {
+  static Statistics statistics;
+  return statistics;
+}
+
+void Statistics::add(std::string_view function, std::string_view counter, long value) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Counters *counters = &unit;
+  if (!function.empty()) {
+    auto it = functions.find(function);
+    if (it == functions.end()) {
+      it = functions.emplace(std::string(function), Counters()).first;
+    }
+    counters = &it->second;
+  }
+  auto it = counters->find(counter);
+  if (it == counters->end()) {
+    it = counters->emplace(std::string(counter), 0).first;
+  }
+  it->second += value;
+}
+
+void Statistics::print(std::ostream &out, size_t top_functions) const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  struct Total {
+    long sum = 0, max = 0;
+    size_t count = 0;
+  };
+  std::map<std::string_view, Total> totals;
+  for (const auto &[function, counters] : functions) {
+    for (const auto &[name, value] : counters) {
+      auto &total = totals[name];
+      total.sum += value;
+      total.max = std::max(total.max, value);
+      total.count++;
+    }
+  }
+
+  out << "===== Statistics =====\n";
+  out << std::left << std::setw(28) << "Counter" << std::right << std::setw(12) << "Total"
+      << std::setw(12) << "Max/func" << std::setw(10) << "Funcs" << '\n';
+  for (const auto &[name, value] : unit) {
+    out << std::left << std::setw(28) << name << std::right << std::setw(12) << value << '\n';
+  }
+  for (const auto &[name, total] : totals) {
+    out << std::left << std::setw(28) << name << std::right << std::setw(12) << total.sum
+        << std::setw(12) << total.max << std::setw(10) << total.count << '\n';
+  }
+
+  if (!functions.empty()) {
+    std::vector<std::pair<std::string_view, const Counters *>> order;
+    for (const auto &[function, counters] : functions) {
+      order.emplace_back(function, &counters);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto &a, const auto &b) {
+      return lookup(*a.second, "asm.insts") > lookup(*b.second, "asm.insts");
+    });
+    size_t shown = std::min(top_functions, order.size());
+    out << "----- largest " << shown << " of " << order.size() << " functions -----\n";
+    out << std::left << std::setw(24) << "Function" << std::right;
+    for (const auto &column : columns) {
+      out << std::setw(9) << column.title;
+    }
+    out << '\n';
+    for (size_t i = 0; i < shown; i++) {
+      out << std::left << std::setw(24) << order[i].first << std::right;
+      for (const auto &column : columns) {
+        out << std::setw(9) << lookup(*order[i].second, column.counter);
+      }
+      out << '\n';
+    }
+  }
+  out.flush();
+}
+
+void Statistics::print_json(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  out << "{\n  \"unit\": ";
+  write_json_counters(out, unit, "  ");
+  out << ",\n  \"functions\": {";
+  bool first = true;
+  for (const auto &[function, counters] : functions) {
+    out << (first ? "\n" : ",\n") << "    ";
+    write_json_string(out, function);
+    out << ": ";
+    write_json_counters(out, counters, "    ");
+    first = false;
+  }
+  out << (first ? "}" : "\n  }") << "\n}\n";
+  out.flush();
+}
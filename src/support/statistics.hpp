@@ -0,0 +1,45 @@
+#ifndef SUPPORT_STATISTICS_HPP
+#define SUPPORT_STATISTICS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/// @brief Named counters that compilation passes add to, printed by --stats
+/// There is one registry per process and it is off until enable() is called.
+/// Passes count into their own members while they run and add the totals
+/// once per function, so the registry lock is taken a few times per
+/// function, never per instruction. Counters of functions with the same name
+/// (e.g. main in a batch of files) are summed.
+class Statistics {
+ public:
+  static Statistics &global();
+
+  void enable() { enabled.store(true, std::memory_order_relaxed); }
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  /// @brief add value to a counter, e.g. add("main", "spill.loads", 3)
+  /// @param function function the counter belongs to, empty for whole-unit counters
+  void add(std::string_view function, std::string_view counter, long value = 1);
+
+  /// @brief print the total and maximum of every counter, then the
+  /// top_functions functions with the most emitted instructions
+  void print(std::ostream &out, size_t top_functions = 20) const;
+  /// @brief print every counter as {"unit": {...}, "functions": {name: {...}}}
+  void print_json(std::ostream &out) const;
+
+ private:
+  using Counters = std::map<std::string, long, std::less<>>;
+
+  std::atomic<bool> enabled{false};
+  mutable std::mutex mutex;
+  Counters unit;
+  std::map<std::string, Counters, std::less<>> functions;
+};
+
+#endif  // SUPPORT_STATISTICS_HPP
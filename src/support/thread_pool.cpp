@@ -0,0 +1,112 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+  threads = std::max(threads, 1u);
+  for (unsigned i = 0; i < threads; i++) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (unsigned i = 0; i < threads; i++) {
+    workers.emplace_back([this, i] { run(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_ready.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+unsigned ThreadPool::default_threads() {
+  return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  size_t index;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    index = next_queue++ % queues.size();
+    ++unfinished;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++queued;
+  }
+  work_ready.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  all_done.wait(lock, [this] { return unfinished == 0; });
+  if (error) {
+    auto e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+bool ThreadPool::take(unsigned index, std::function<void()> &task) {
+  // own tasks first, newest at the back
+  {
+    auto &own = *queues[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  // then steal the oldest task of another worker
+  for (size_t k = 1; k < queues.size(); k++) {
+    auto &victim = *queues[(index + k) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::run(unsigned index) {
+  while (true) {
+    std::function<void()> task;
+    if (take(index, task)) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --queued;
+      }
+      std::exception_ptr failure;
+      try {
+        task();
+      } catch (...) {
+        failure = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (failure && !error) {
+        error = failure;
+      }
+      if (--unfinished == 0) {
+        all_done.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_ready.wait(lock, [this] { return stopping || queued > 0; });
+    if (stopping && queued <= 0) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef SUPPORT_THREAD_POOL_HPP
+#define SUPPORT_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Work-stealing thread pool
+/// Every worker owns a deque. Submitted tasks are dealt round-robin; a worker
+/// takes its own tasks from the back and, once it runs dry, steals from the
+/// front of the other deques, so a few large tasks do not leave the remaining
+/// workers idle.
+class ThreadPool {
+ public:
+  explicit ThreadPool(unsigned threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+
+  /// @brief block until every submitted task has finished
+  /// rethrows the first exception thrown by a task, if any
+  void wait();
+
+  unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+  /// @brief worker count to use for -j 0
+  static unsigned default_threads();
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable all_done;
+  long queued = 0;        // tasks sitting in some deque
+  size_t unfinished = 0;  // tasks submitted but not finished yet
+  size_t next_queue = 0;
+  bool stopping = false;
+  std::exception_ptr error;
+
+  void run(unsigned index);
+  bool take(unsigned index, std::function<void()> &task);
+};
+
+#endif  // SUPPORT_THREAD_POOL_HPP
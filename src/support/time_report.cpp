@@ -0,0 +1,160 @@
+#include "time_report.hpp"
+
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <map>
+
+namespace {
+
+double cpu_seconds(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/// @brief resident set size in KiB, from /proc/self/statm
+long current_rss() {
+  long pages = 0;
+  if (FILE *statm = std::fopen("/proc/self/statm", "r")) {
+    if (std::fscanf(statm, "%*s %ld", &pages) != 1) {
+      pages = 0;
+    }
+    std::fclose(statm);
+  }
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/// @brief peak resident set size in KiB
+long peak_rss() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+}  // namespace
+
+TimeReport &TimeReport::global() {
+  static TimeReport report;
+  return report;
+}
+
+TimeReport::Scope::Scope(const char *phase, std::string_view function)
+    : report(global().is_enabled() ? &global() : nullptr), phase(phase), trace(phase, function),
+      alloc_phase(phase) {
+  if (!report) {
+    return;
+  }
+  this->function = function;
+  rss_start = current_rss();
+  cpu_start = cpu_seconds(CLOCK_THREAD_CPUTIME_ID);
+  wall_start = std::chrono::steady_clock::now();
+}
+
+TimeReport::Scope::~Scope() {
+  if (!report) {
+    return;
+  }
+  std::chrono::duration<double> start = wall_start - report->epoch;
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wall_start;
+  double cpu = cpu_seconds(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+  report->add({phase, std::move(function), start.count(), wall.count(), cpu,
+               current_rss() - rss_start, peak_rss()});
+}
+
+void TimeReport::add(Sample sample) {
+  std::lock_guard<std::mutex> lock(mutex);
+  samples.push_back(std::move(sample));
+}
+
+void TimeReport::print(std::ostream &out, size_t top_functions) const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  struct Total {
+    const char *phase;
+    size_t count = 0;
+    double wall = 0, cpu = 0;
+    long rss_delta = 0, peak_rss = 0;
+    double end = 0;         // latest end of the samples seen so far
+    bool parallel = false;  // some samples overlapped, wall is thread time
+  };
+  // visit samples in order of their start, so overlaps show up as a start
+  // before the end of an earlier sample
+  std::vector<const Sample *> by_start;
+  for (const auto &sample : samples) {
+    by_start.push_back(&sample);
+  }
+  std::sort(by_start.begin(), by_start.end(),
+            [](const Sample *a, const Sample *b) { return a->start < b->start; });
+
+  std::map<std::string_view, Total> by_phase;
+  std::vector<const Sample *> per_function;
+  for (const Sample *p : by_start) {
+    const Sample &sample = *p;
+    auto &total = by_phase[sample.phase];
+    total.phase = sample.phase;
+    if (total.count > 0 && sample.start < total.end) {
+      total.parallel = true;
+    }
+    total.end = std::max(total.end, sample.start + sample.wall);
+    total.count++;
+    total.wall += sample.wall;
+    total.cpu += sample.cpu;
+    total.rss_delta += sample.rss_delta;
+    total.peak_rss = std::max(total.peak_rss, sample.peak_rss);
+    if (!sample.function.empty()) {
+      per_function.push_back(&sample);
+    }
+  }
+
+  std::vector<Total> phases;
+  for (const auto &[name, total] : by_phase) {
+    phases.push_back(total);
+  }
+  std::sort(phases.begin(), phases.end(),
+            [](const Total &a, const Total &b) { return a.wall > b.wall; });
+  std::sort(per_function.begin(), per_function.end(),
+            [](const Sample *a, const Sample *b) { return a->wall > b->wall; });
+
+  auto row = [&](const std::string &phase, const std::string &function, double wall, double cpu,
+                 long rss_delta, long peak, size_t count) {
+    out << std::left << std::setw(14) << phase << std::setw(24) << function << std::right
+        << std::fixed << std::setprecision(3) << std::setw(11) << wall * 1000 << std::setw(11)
+        << cpu * 1000 << std::setw(11) << rss_delta << std::setw(11) << peak << std::setw(8)
+        << count << '\n';
+  };
+
+  out << "===== Time report =====\n";
+  out << std::left << std::setw(14) << "Phase" << std::setw(24) << "Function" << std::right
+      << std::setw(11) << "Wall ms" << std::setw(11) << "CPU ms" << std::setw(11) << "RSS+ KiB"
+      << std::setw(11) << "Peak KiB" << std::setw(8) << "Count" << '\n';
+  bool parallel = false;
+  for (const auto &total : phases) {
+    row(total.phase, total.parallel ? "(threads)" : "(all)", total.wall, total.cpu,
+        total.rss_delta, total.peak_rss, total.count);
+    parallel = parallel || total.parallel;
+  }
+  // phases overlap each other too, so the total is measured, not summed
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - epoch;
+  row("elapsed", "", elapsed.count(), cpu_seconds(CLOCK_PROCESS_CPUTIME_ID), 0, peak_rss(),
+      samples.size());
+  if (parallel) {
+    out << "(threads): samples ran in parallel, times are summed over threads\n";
+  }
+
+  if (!per_function.empty()) {
+    size_t shown = std::min(top_functions, per_function.size());
+    out << "----- slowest " << shown << " of " << per_function.size()
+        << " per-function samples -----\n";
+    for (size_t i = 0; i < shown; i++) {
+      const Sample &sample = *per_function[i];
+      row(sample.phase, sample.function, sample.wall, sample.cpu, sample.rss_delta,
+          sample.peak_rss, 1);
+    }
+  }
+  out.flush();
+}
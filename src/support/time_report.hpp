@@ -0,0 +1,82 @@
+#ifndef SUPPORT_TIME_REPORT_HPP
+#define SUPPORT_TIME_REPORT_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "support/alloc_profile.hpp"
+#include "support/trace.hpp"
+
+/// @brief Wall time, CPU time and memory of each compilation phase
+/// There is one report per process. It is off until enable() is called, and
+/// a Scope on a disabled report costs a single relaxed load. Backend phases
+/// run per function on several threads, so CPU time is per thread, while
+/// RSS is necessarily process-wide: the RSS delta of a phase that ran in
+/// parallel with others includes their allocations too. For the same reason
+/// the wall time of a phase whose samples overlapped is thread time, summed
+/// over threads, and may exceed the elapsed time of the process.
+class TimeReport {
+ public:
+  static TimeReport &global();
+
+  void enable() {
+    epoch = std::chrono::steady_clock::now();
+    enabled.store(true, std::memory_order_relaxed);
+  }
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  /// @brief records the lifetime of the scope as one sample of a phase,
+  /// and as an event of the trace when --trace is on; in an ALLOC_PROFILE
+  /// build, allocations of the thread are charged to the phase meanwhile
+  class Scope {
+   public:
+    /// @param phase static name of the phase
+    /// @param function function the sample belongs to, empty for whole-unit phases
+    explicit Scope(const char *phase, std::string_view function = {});
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    TimeReport *report;  // nullptr when the report is disabled
+    const char *phase;
+    std::string function;
+    std::chrono::steady_clock::time_point wall_start;
+    double cpu_start;
+    long rss_start;
+    Trace::Scope trace;  // the same span on the --trace timeline
+    AllocProfile::Phase alloc_phase;
+  };
+
+  /// @brief print one row per phase and the slowest per-function samples,
+  /// both sorted by wall time; phases whose samples ran in parallel are
+  /// labelled "(threads)" instead of "(all)", and the last row is the
+  /// elapsed time since enable()
+  void print(std::ostream &out, size_t top_functions = 20) const;
+
+ private:
+  struct Sample {
+    const char *phase;
+    std::string function;
+    double start;   // seconds since enable()
+    double wall;    // seconds
+    double cpu;     // seconds, of the calling thread
+    long rss_delta; // KiB
+    long peak_rss;  // KiB, at the end of the sample
+  };
+
+  std::atomic<bool> enabled{false};
+  std::chrono::steady_clock::time_point epoch;
+  mutable std::mutex mutex;
+  std::vector<Sample> samples;
+
+  void add(Sample sample);
+};
+
+#endif  // SUPPORT_TIME_REPORT_HPP
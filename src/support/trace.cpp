@@ -0,0 +1,115 @@
+#include "trace.hpp"
+
+#include <iostream>
+
+#include "support/json.hpp"
+#include "support/writer.hpp"
+
+namespace {
+
+/// @brief trace-event timestamps are in microseconds; keep ns precision
+void write_microseconds(Writer &out, int64_t ns) {
+  char fraction[4] = {char('0' + ns / 100 % 10), char('0' + ns / 10 % 10), char('0' + ns % 10), 0};
+  out << ns / 1000 << '.' << static_cast<const char *>(fraction);
+}
+
+}  // namespace
+
+Trace &Trace::global() {
+  static Trace trace;
+  return trace;
+}
+
+void Trace::start(std::string path) {
+  this->path = std::move(path);
+  epoch = std::chrono::steady_clock::now();
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+int64_t Trace::now() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              epoch)
+      .count();
+}
+
+Trace::ThreadBuffer &Trace::local_buffer() {
+  // registered on the first event of the thread; the buffer is owned by the
+  // trace, so events of threads that have exited are still written
+  thread_local ThreadBuffer *local = nullptr;
+  if (!local) {
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    local = buffers.back().get();
+    local->tid = static_cast<uint32_t>(buffers.size());
+  }
+  return *local;
+}
+
+void Trace::record(const char *name, std::string_view detail, int64_t start) {
+  int64_t end = now();
+  ThreadBuffer &buffer = local_buffer();
+  if (buffer.events.size() < capacity) {
+    buffer.events.push_back({name, std::string(detail), start, end - start});
+    return;
+  }
+  Event &event = buffer.events[buffer.next];
+  event.name = name;
+  event.detail.assign(detail.data(), detail.size());
+  event.start = start;
+  event.duration = end - start;
+  buffer.next = (buffer.next + 1) % capacity;
+  buffer.dropped++;
+}
+
+Trace::Scope::Scope(const char *name, std::string_view detail)
+    : trace(global().is_enabled() ? &global() : nullptr), name(name) {
+  if (!trace) {
+    return;
+  }
+  this->detail = detail;
+  start = trace->now();
+}
+
+Trace::Scope::~Scope() {
+  if (trace) {
+    trace->record(name, detail, start);
+  }
+}
+
+void Trace::write() {
+  std::lock_guard<std::mutex> lock(mutex);
+  Writer out(Writer::open_file(path), true);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  size_t dropped = 0;
+  for (const auto &buffer : buffers) {
+    // metadata event naming the track; threads are numbered in order of their first event
+    out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << buffer->tid << ",\"args\":{\"name\":\"thread " << buffer->tid << "\"}}";
+    first = false;
+
+    // once the ring is full, the oldest event is at next
+    size_t count = buffer->events.size();
+    for (size_t i = 0; i < count; i++) {
+      const Event &event = buffer->events[(buffer->next + i) % count];
+      out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"ts\":";
+      write_microseconds(out, event.start);
+      out << ",\"dur\":";
+      write_microseconds(out, event.duration);
+      if (!event.detail.empty()) {
+        out << ",\"args\":{\"detail\":";
+        write_json_string(out, event.detail);
+        out << '}';
+      }
+      out << '}';
+    }
+    dropped += buffer->dropped;
+  }
+  out << "\n]}\n";
+  out.flush();
+  if (dropped > 0) {
+    std::cerr << "trace: " << dropped << " oldest events were dropped (" << capacity
+              << " are kept per thread)" << std::endl;
+  }
+}
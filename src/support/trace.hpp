@@ -0,0 +1,81 @@
+#ifndef SUPPORT_TRACE_HPP
+#define SUPPORT_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Timeline of scoped events, written in Chrome trace-event format
+/// The file loads in Perfetto or chrome://tracing and shows every phase and
+/// per-function pass as a slice on the thread that ran it. There is one
+/// trace per process and it is off until start() is called.
+///
+/// Each thread records into its own ring buffer, so recording takes no lock
+/// after a thread's first event. When a buffer is full the oldest events of
+/// that thread are overwritten and counted as dropped.
+class Trace {
+ public:
+  /// @brief events kept per thread
+  static constexpr size_t capacity = 1 << 16;
+
+  static Trace &global();
+
+  /// @brief start recording; write() will create path
+  void start(std::string path);
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  /// @brief records the lifetime of the scope as one complete ("X") event
+  class Scope {
+   public:
+    /// @param name static name of the event, e.g. the phase
+    /// @param detail shown as args.detail, e.g. the function or file;
+    /// it must stay valid until the scope ends
+    explicit Scope(const char *name, std::string_view detail = {});
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    Trace *trace;  // nullptr when tracing is off
+    const char *name;
+    std::string_view detail;
+    int64_t start;
+  };
+
+  /// @brief write every buffered event to the path given to start()
+  /// call once no other thread records any more, e.g. at exit;
+  /// throws std::runtime_error if the file cannot be written
+  void write();
+
+ private:
+  struct Event {
+    const char *name;
+    std::string detail;
+    int64_t start;     // ns since start()
+    int64_t duration;  // ns
+  };
+  struct ThreadBuffer {
+    uint32_t tid;
+    std::vector<Event> events;  // grows to capacity, then used as a ring
+    size_t next = 0;            // slot of the next event once full
+    size_t dropped = 0;
+  };
+
+  std::atomic<bool> enabled{false};
+  std::string path;
+  std::chrono::steady_clock::time_point epoch;
+  std::mutex mutex;  // guards buffers
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+  int64_t now() const;
+  ThreadBuffer &local_buffer();
+  void record(const char *name, std::string_view detail, int64_t start);
+};
+
+#endif  // SUPPORT_TRACE_HPP
@@ -0,0 +1,117 @@
+#include "writer.hpp"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+
+/// @brief writev() until every piece is written, retrying short writes
+void write_all(int fd, std::vector<iovec> &pieces) {
+  size_t first = 0;
+  while (first < pieces.size()) {
+    int count = static_cast<int>(std::min<size_t>(pieces.size() - first, IOV_MAX));
+    ssize_t written = ::writev(fd, pieces.data() + first, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Cannot write output: ") + std::strerror(errno));
+    }
+    size_t n = written;
+    while (first < pieces.size() && n >= pieces[first].iov_len) {
+      n -= pieces[first].iov_len;
+      first++;
+    }
+    if (n > 0) {
+      pieces[first].iov_base = static_cast<char *>(pieces[first].iov_base) + n;
+      pieces[first].iov_len -= n;
+    }
+  }
+}
+
+}  // namespace
+
+Writer::Writer(int fd, bool owns_fd) : fd(fd), owns_fd(owns_fd), buffer(&own) {
+  own.reserve(capacity + 64);
+}
+
+Writer::Writer(std::ostream &stream) : stream(&stream), buffer(&own) {
+  own.reserve(capacity + 64);
+}
+
+Writer::Writer(std::string &target) : buffer(&target) {}
+
+Writer::~Writer() {
+  try {
+    flush();
+  } catch (const std::runtime_error &) {
+  }
+  if (owns_fd) {
+    ::close(fd);
+  }
+}
+
+int Writer::open_file(const std::string &path) {
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open output file: " + path);
+  }
+  return fd;
+}
+
+void Writer::append_ref(std::string_view text) {
+  if (buffer != &own) {
+    buffer->append(text.data(), text.size());
+    return;
+  }
+  refs.push_back({buffer->size(), text});
+  if (refs.size() >= IOV_MAX / 2) {
+    flush();
+  }
+}
+
+void Writer::flush() {
+  if (buffer != &own || (buffer->empty() && refs.empty())) {
+    return;
+  }
+  // the buffer is cut at every ref and interleaved with the refs
+  std::vector<iovec> pieces;
+  pieces.reserve(refs.size() * 2 + 1);
+  size_t offset = 0;
+  auto add = [&](const char *data, size_t length) {
+    if (length > 0) {
+      pieces.push_back({const_cast<char *>(data), length});
+    }
+  };
+  for (const auto &ref : refs) {
+    add(buffer->data() + offset, ref.offset - offset);
+    add(ref.text.data(), ref.text.size());
+    offset = ref.offset;
+  }
+  add(buffer->data() + offset, buffer->size() - offset);
+  refs.clear();
+  try {
+    if (stream) {
+      for (const auto &piece : pieces) {
+        stream->write(static_cast<const char *>(piece.iov_base), piece.iov_len);
+      }
+      // the stream may share a file descriptor with fd writers (std::cout and
+      // stdout), which would otherwise overtake what sits in its own buffer
+      stream->flush();
+    } else {
+      write_all(fd, pieces);
+    }
+  } catch (...) {
+    buffer->clear();
+    throw;
+  }
+  buffer->clear();
+}
@@ -0,0 +1,92 @@
+#ifndef SUPPORT_WRITER_HPP
+#define SUPPORT_WRITER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// @brief Buffered output that assembly and IR format themselves into
+/// Text and integers are appended straight into one reusable buffer
+/// (integers through std::to_chars), so printing an instruction allocates
+/// nothing and nothing is flushed per line. A writer targets a file
+/// descriptor or a std::ostream, which are written only when the buffer
+/// fills up or on flush(), or appends to a string in memory.
+///
+/// Large pieces that are already formatted elsewhere (e.g. the per-function
+/// assembly produced in parallel) are added with append_ref() and are not
+/// copied: flush() hands them to writev() together with the buffer.
+class Writer {
+ public:
+  /// @brief bytes buffered before a file descriptor or stream is written
+  static constexpr size_t capacity = 64 << 10;
+
+  /// @brief write to fd; the descriptor is closed on destruction if owned
+  explicit Writer(int fd, bool owns_fd = false);
+  /// @brief write to stream, e.g. to keep dumps in order with other logging
+  explicit Writer(std::ostream &stream);
+  /// @brief append to target instead of writing to a file
+  explicit Writer(std::string &target);
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+  /// @brief flushes; errors at this point are ignored, call flush() to see them
+  ~Writer();
+
+  /// @brief create or truncate a file for writing
+  /// throws std::runtime_error if it cannot be opened
+  static int open_file(const std::string &path);
+
+  Writer &operator<<(char c) {
+    buffer->push_back(c);
+    return spill();
+  }
+  Writer &operator<<(std::string_view text) {
+    buffer->append(text.data(), text.size());
+    return spill();
+  }
+  Writer &operator<<(const char *text) { return *this << std::string_view(text); }
+  Writer &operator<<(const std::string &text) { return *this << std::string_view(text); }
+
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T> &&
+                                                    !std::is_same_v<T, char> &&
+                                                    !std::is_same_v<T, bool>>>
+  Writer &operator<<(T value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer->append(digits, result.ptr - digits);
+    return spill();
+  }
+
+  /// @brief append text that stays valid until the next flush, without copying
+  void append_ref(std::string_view text);
+
+  /// @brief write everything buffered so far; a stream is flushed as well
+  /// throws std::runtime_error if a file descriptor cannot be written
+  void flush();
+
+ private:
+  /// @brief text passed to append_ref, to be written before buffer[offset]
+  struct Ref {
+    size_t offset;
+    std::string_view text;
+  };
+
+  int fd = -1;
+  bool owns_fd = false;
+  std::ostream *stream = nullptr;
+  std::string own;      // buffer of a file or stream writer, keeps its capacity
+  std::string *buffer;  // own, or the target string
+  std::vector<Ref> refs;
+
+  Writer &spill() {
+    if (buffer == &own && buffer->size() >= capacity) {
+      flush();
+    }
+    return *this;
+  }
+};
+
+#endif  // SUPPORT_WRITER_HPP